@@ -3,10 +3,17 @@
 #include <algorithm>
 #include <array>
 #include <cstdio>
+#include <esp_heap_caps.h>
+#include <strings.h>
 
 #include "Config.h"
 #include "Core/Gfx.h"
 #include "Core/Storage.h"
+#include "Core/SlidePack.h"
+#include "Core/SlideMeta.h"
+#include "Core/SdFastSeek.h"
+#include "Core/BufferedFile.h"
+#include "Core/QoiImage.h"
 #include "Core/TextRenderer.h"
 #include "Core/I18n.h"
 
@@ -16,22 +23,43 @@ constexpr uint32_t kToastShortMs = 1000;
 constexpr uint32_t kToastLongMs = 1500;
 constexpr uint32_t kManualFilenameDurationMs = 2000;
 constexpr uint32_t kDeleteHintDurationMs = 6000;
+constexpr uint32_t kPreviewMinWindowMs = 800;      // don't start preview work with less idle time
+constexpr uint32_t kPreviewSafetyMarginMs = 150;   // keep clear of the next slide switch
+constexpr uint32_t kManualPreviewWindowMs = 10000; // manual mode: only a button press ends idle time
+constexpr uint32_t kPackCompactionBudgetMs = 15;   // flash slide pack compaction per tick
+constexpr uint32_t kKenBurnsFrameMs = 40;          // frame cap (~25 fps); decode time usually dominates
+constexpr uint32_t kKenBurnsManualMs = 10000;      // manual mode: length of one pan
+constexpr uint32_t kGifMaxLagMs = 100;             // further behind: drop the missed frame slots
+constexpr uint32_t kGifRamMaxBytes = 96 * 1024;    // GIFs up to this size are played from RAM
+constexpr uint32_t kGifHeapReserveBytes = 48 * 1024;
+constexpr size_t kGifFrameCacheBytes = 64 * 1024;  // replay cache budget per GIF, 0 disables it
+constexpr int kGifMaxScale = 3;                    // integer upscale for small GIFs
+constexpr int kGifMaxShrink = 2;                   // oversized GIFs are shown at half size
+constexpr int kAnimRetryMs = 500;                  // broken .anm frame: retry from the start
+constexpr bool kGifUseCanvas = true;               // composite into an 8-bit canvas, push changed rows
+constexpr uint8_t kSlideshowMenuItems = 5;
+constexpr uint8_t kGridColumns = 3;
+constexpr uint8_t kGridCells = kGridColumns * kGridColumns;
+constexpr int16_t kGridGap = 10;  // room for the 2px selection frame
+constexpr int16_t kGridPitch = ThumbnailCache::kThumbSize + kGridGap;
+constexpr int16_t kGridOrigin = (TFT_W - (kGridColumns * kGridPitch - kGridGap)) / 2;
+
+struct KenBurnsLevel {
+  uint8_t jpgScale;  // TJpgDec downscale (1/2/4/8)
+  uint8_t upscale;   // integer magnification in gfxJpegOutput
+};
+
+// Available magnifications from 1/8 up to 3x, smallest first
+constexpr KenBurnsLevel kKenBurnsLevels[] = {{8, 1}, {4, 1}, {2, 1}, {1, 1}, {1, 2}, {1, 3}};
+constexpr uint8_t kKenBurnsLevelCount = sizeof(kKenBurnsLevels) / sizeof(kKenBurnsLevels[0]);
+
+int32_t kenBurnsSize(uint16_t size, const KenBurnsLevel& level) {
+  return static_cast<int32_t>(size / level.jpgScale) * level.upscale;
+}
+
+bool slidePathLess(const SlideFile& a, const SlideFile& b) {
+  return a.path < b.path;
 }
-
-bool SlideshowApp::isJpeg_(const String& n) {
-  String l = n;
-  l.toLowerCase();
-  return l.endsWith(".jpg") || l.endsWith(".jpeg");
-}
-
-bool SlideshowApp::isGif_(const String& n) {
-  String l = n;
-  l.toLowerCase();
-  return l.endsWith(".gif");
-}
-
-bool SlideshowApp::isMediaFile_(const String& n) {
-  return isJpeg_(n) || isGif_(n);
 }
 
 bool SlideshowApp::focusTransferredFile(const char* filename, size_t size) {
@@ -44,17 +72,13 @@ bool SlideshowApp::focusTransferredFile(const char* filename, size_t size) {
     return false;
   }
   source_ = SlideSource::Flash;
-  String target = filename ? String(filename) : String();
-  target.toLowerCase();
-
   idx_ = 0;
-  if (!target.isEmpty()) {
+  if (filename && filename[0]) {
     for (size_t i = 0; i < files_.size(); ++i) {
-      String candidate = files_[i];
-      int s = candidate.lastIndexOf('/');
-      if (s >= 0) candidate = candidate.substring(s + 1);
-      candidate.toLowerCase();
-      if (candidate == target) {
+      const char* candidate = files_[i].path.c_str();
+      const char* slash = strrchr(candidate, '/');
+      if (slash) candidate = slash + 1;
+      if (strcasecmp(candidate, filename) == 0) {
         idx_ = i;
         break;
       }
@@ -89,7 +113,7 @@ void SlideshowApp::setControlMode_(ControlMode mode, bool showToast) {
   controlMode_ = mode;
   if (controlMode_ != ControlMode::Manual) {
     manualFilenameActive_ = false;
-    manualFilenameLabel_.clear();
+    manualFilenameLabel_[0] = '\0';
     manualFilenameUntil_ = 0;
   }
 
@@ -189,7 +213,7 @@ bool SlideshowApp::setSlideSource(SlideSource src, bool showToast, bool renderNo
 }
 
 String SlideshowApp::sourceLabel() const {
-  return sourceLabel_();
+  return String(sourceLabel_());
 }
 
 
@@ -249,7 +273,7 @@ bool SlideshowApp::ensureSdReady_() {
 
 void SlideshowApp::openSlideshowMenu_() {
   menuScreen_ = MenuScreen::Slideshow;
-  if (slideshowMenuSelection_ >= 4) slideshowMenuSelection_ = 0;
+  if (slideshowMenuSelection_ >= kSlideshowMenuItems) slideshowMenuSelection_ = 0;
   slideshowMenuDirty_ = true;
   sourceMenuDirty_ = false;
   autoSpeedMenuDirty_ = false;
@@ -259,6 +283,9 @@ void SlideshowApp::closeMenus_() {
   if (menuScreen_ == MenuScreen::None) {
     return;
   }
+  if (menuScreen_ == MenuScreen::Grid) {
+    thumbnails_.close();
+  }
   menuScreen_ = MenuScreen::None;
   slideshowMenuDirty_ = false;
   sourceMenuDirty_ = false;
@@ -285,7 +312,7 @@ void SlideshowApp::openAutoSpeedMenu_() {
 void SlideshowApp::handleMenuButton_(BtnEvent e) {
   switch (e) {
     case BtnEvent::Single:
-      slideshowMenuSelection_ = (slideshowMenuSelection_ + 1) % 4;
+      slideshowMenuSelection_ = (slideshowMenuSelection_ + 1) % kSlideshowMenuItems;
       slideshowMenuDirty_ = true;
       break;
     case BtnEvent::Long:
@@ -301,6 +328,13 @@ void SlideshowApp::handleMenuButton_(BtnEvent e) {
           openAutoSpeedMenu_();
           break;
         case 3:
+          ken_burns = !ken_burns;
+          if (!ken_burns) {
+            stopKenBurns_();
+          }
+          slideshowMenuDirty_ = true;
+          break;
+        case 4:
         default:
           closeMenus_();
           setControlMode_(ControlMode::Auto);
@@ -373,14 +407,18 @@ void SlideshowApp::drawSlideshowMenu_() {
   slideshowMenuDirty_ = false;
 
   tft.fillScreen(TFT_BLACK);
-  const char* itemKeys[4] = {"slideshow.source_select", "slideshow.delete_menu", "slideshow.auto_speed", "menu.exit"};
+  const char* itemKeys[kSlideshowMenuItems] = {"slideshow.source_select",
+                                               "slideshow.delete_menu",
+                                               "slideshow.auto_speed",
+                                               ken_burns ? "slideshow.ken_burns_on" : "slideshow.ken_burns_off",
+                                               "menu.exit"};
   const int16_t line = TextRenderer::lineHeight();
-  const int16_t spacing = 12;
+  const int16_t spacing = 6;
   const int16_t top = 24;
   TextRenderer::drawCentered(top, i18n.t("slideshow.menu_title"), TFT_WHITE, TFT_BLACK);
 
-  for (uint8_t i = 0; i < 4; ++i) {
-    int16_t y = top + line + spacing + 15 + static_cast<int16_t>(i) * (line + spacing);
+  for (uint8_t i = 0; i < kSlideshowMenuItems; ++i) {
+    int16_t y = top + line + spacing + 10 + static_cast<int16_t>(i) * (line + spacing);
     char buf[64];
     const char* label = i18n.t(itemKeys[i]);
     if (slideshowMenuSelection_ == i) {
@@ -461,10 +499,8 @@ void SlideshowApp::drawAutoSpeedMenu_() {
     bool leftColumn = (i < leftCount);
     uint8_t row = leftColumn ? i : (i - leftCount);
     int16_t y = top + line*2 + 27 + static_cast<int16_t>(row) * (line + spacing);
-    String text = dwellOptionLabel_(i);
-    if (autoSpeedSelection_ == i) {
-      text = String("> ") + text;
-    }
+    char text[24];
+    snprintf(text, sizeof(text), "%s%s", (autoSpeedSelection_ == i) ? "> " : "", dwellOptionLabel_(i));
     uint16_t color = (autoSpeedSelection_ == i) ? TFT_WHITE : TFT_DARKGREY;
     int16_t width = TextRenderer::measure(text);
     int16_t x = columnCenters[leftColumn ? 0 : 1] - (width / 2);
@@ -487,10 +523,143 @@ void SlideshowApp::drawAutoSpeedMenu_() {
                                    TFT_BLACK);
 }
 
-String SlideshowApp::dwellOptionLabel_(uint8_t idx) const {
+void SlideshowApp::openGrid_() {
+  if (files_.empty()) return;
+
+  stopGif_();
+  stopKenBurns_();
+  toastText_.clear();
+  toastUntil_ = 0;
+  toastDirty_ = false;
+  if (!thumbnails_.open(source_, files_.size())) {
+    showToast_(i18n.t("slideshow.no_images"), kToastShortMs);
+    return;
+  }
+
+  menuScreen_ = MenuScreen::Grid;
+  gridSelection_ = idx_;
+  gridShownSelection_ = idx_;
+  gridPaintNext_ = 0;
+  gridPageDirty_ = true;
+}
+
+void SlideshowApp::closeGrid_(bool showSelection) {
+  if (showSelection && gridSelection_ < files_.size()) {
+    idx_ = gridSelection_;
+  }
+  closeMenus_();
+  timeSinceSwitch_ = 0;
+  if (!files_.empty()) {
+    showCurrent_();
+  }
+}
+
+void SlideshowApp::handleGridButton_(BtnEvent e) {
+  const size_t total = files_.size();
+  if (total == 0) {
+    closeMenus_();
+    return;
+  }
+
+  switch (e) {
+    case BtnEvent::Single: {
+      const size_t page = gridSelection_ / kGridCells;
+      gridSelection_ = (gridSelection_ + 1) % total;
+      if (gridSelection_ / kGridCells != page) {
+        gridPageDirty_ = true;
+      }
+      break;
+    }
+    case BtnEvent::Double:
+      gridSelection_ = (gridSelection_ / kGridCells + 1) * kGridCells;
+      if (gridSelection_ >= total) {
+        gridSelection_ = 0;
+      }
+      gridPageDirty_ = true;
+      break;
+    case BtnEvent::Long:
+      closeGrid_(true);
+      break;
+    case BtnEvent::Triple:
+      closeGrid_(false);
+      break;
+    default:
+      break;
+  }
+}
+
+void SlideshowApp::gridCellOrigin_(uint8_t cell, int16_t& x, int16_t& y) const {
+  x = kGridOrigin + static_cast<int16_t>(cell % kGridColumns) * kGridPitch;
+  y = kGridOrigin + static_cast<int16_t>(cell / kGridColumns) * kGridPitch;
+}
+
+void SlideshowApp::drawGridFrame_(size_t index, uint16_t color) {
+  int16_t x = 0;
+  int16_t y = 0;
+  gridCellOrigin_(static_cast<uint8_t>(index % kGridCells), x, y);
+  const int16_t size = ThumbnailCache::kThumbSize;
+  tft.drawRect(x - 4, y - 4, size + 8, size + 8, color);
+  tft.drawRect(x - 3, y - 3, size + 6, size + 6, color);
+}
+
+void SlideshowApp::drawGrid_() {
+  if (files_.empty()) return;
+
+  const size_t pageStart = gridSelection_ / kGridCells * kGridCells;
+  if (gridPageDirty_) {
+    gridPageDirty_ = false;
+    gridPaintNext_ = 0;
+    tft.fillScreen(TFT_BLACK);
+
+    char label[16];
+    const unsigned pageCount = (files_.size() + kGridCells - 1) / kGridCells;
+    snprintf(label, sizeof(label), "%u/%u", static_cast<unsigned>(pageStart / kGridCells + 1), pageCount);
+    TextRenderer::drawHelperCentered(kGridOrigin + kGridColumns * kGridPitch, label, TFT_DARKGREY, TFT_BLACK);
+
+    gridShownSelection_ = gridSelection_;
+    drawGridFrame_(gridSelection_, TFT_WHITE);
+  }
+
+  if (gridShownSelection_ != gridSelection_) {
+    drawGridFrame_(gridShownSelection_, TFT_BLACK);
+    drawGridFrame_(gridSelection_, TFT_WHITE);
+    gridShownSelection_ = gridSelection_;
+  }
+
+  // Cached cells go out in one pass; at most one thumbnail is decoded per
+  // call so buttons stay responsive while a cold page fills in
+  bool decoded = false;
+  while (gridPaintNext_ < kGridCells && pageStart + gridPaintNext_ < files_.size()) {
+    int16_t x = 0;
+    int16_t y = 0;
+    gridCellOrigin_(gridPaintNext_, x, y);
+    const SlideFile& slide = files_[pageStart + gridPaintNext_];
+
+    const ThumbnailCache::Result result = thumbnails_.draw(slide, x, y, !decoded);
+    if (result == ThumbnailCache::Result::Missing || result == ThumbnailCache::Result::Cancelled) {
+      return;
+    }
+    if (result == ThumbnailCache::Result::Generated) {
+      decoded = true;
+    } else if (result == ThumbnailCache::Result::Failed) {
+      const int16_t size = ThumbnailCache::kThumbSize;
+      tft.fillRect(x, y, size, size, TFT_DARKGREY);
+      if (slide.type != SlideMediaType::Jpeg) {
+        const char* tag = (slide.type == SlideMediaType::Gif) ? "GIF"
+                        : (slide.type == SlideMediaType::Qoi) ? "QOI" : "ANM";
+        TextRenderer::draw(x + (size - TextRenderer::measure(tag)) / 2,
+                           y + (size - TextRenderer::lineHeight()) / 2,
+                           tag, TFT_WHITE, TFT_BLACK);
+      }
+    }
+    ++gridPaintNext_;
+  }
+}
+
+const char* SlideshowApp::dwellOptionLabel_(uint8_t idx) const {
   static char buf[16];
   if (idx >= kDwellSteps.size()) {
-    return String();
+    return "";
   }
   uint32_t ms = kDwellSteps[idx];
   if (ms % 60000 == 0) {
@@ -586,7 +755,8 @@ void SlideshowApp::requestDeleteSingle_() {
   if (files_.empty()) return;
 
   deleteState_ = DeleteState::DeleteSingleConfirm;
-  deleteCurrentFile_ = files_[idx_];
+  deleteCurrentFile_ = files_[idx_].path;
+  deleteCurrentSlot_ = files_[idx_].packSlot;
   deleteConfirmSelection_ = 0; // Nein vorauswählen
   markDeleteConfirmDirty_();
   showCurrent_(false, false);
@@ -600,8 +770,9 @@ void SlideshowApp::confirmDeleteSingle_() {
     return;
   }
 
-  performDeleteSingle_(deleteCurrentFile_);
+  performDeleteSingle_(deleteCurrentFile_, deleteCurrentSlot_);
   deleteCurrentFile_.clear();
+  deleteCurrentSlot_ = -1;
 
   if (!rebuildFileListFrom_(SlideSource::Flash) || files_.empty()) {
     deleteState_ = DeleteState::Idle;
@@ -664,8 +835,8 @@ void SlideshowApp::performDeleteAll_() {
     return;
   }
 
-  std::vector<String> flashFiles;
-  if (!readDirectoryEntries_(&LittleFS, kFlashSlidesDir, flashFiles)) {
+  std::vector<SlideFile> flashFiles;
+  if (!readDirectoryEntries_(&LittleFS, kFlashSlidesDir, flashFiles) && !slidePack.isOpen()) {
     showToast_(i18n.t("slideshow.no_images"), kToastLongMs);
     deleteState_ = DeleteState::Idle;
     markDeleteMenuDirty_();
@@ -673,8 +844,11 @@ void SlideshowApp::performDeleteAll_() {
     return;
   }
 
-  deleteCount_ = 0;
-  for (const String& path : flashFiles) {
+  std::vector<SlideFile> packedFiles;
+  slidePack.list(packedFiles);
+  deleteCount_ = slidePack.clear() ? packedFiles.size() : 0;
+  for (const SlideFile& file : flashFiles) {
+    const String& path = file.path;
     if (LittleFS.remove(path.c_str())) {
       deleteCount_++;
       #ifdef USB_DEBUG
@@ -703,8 +877,9 @@ void SlideshowApp::performDeleteAll_() {
   }
 }
 
-void SlideshowApp::performDeleteSingle_(const String& path) {
-  if (LittleFS.remove(path.c_str())) {
+void SlideshowApp::performDeleteSingle_(const String& path, int16_t packSlot) {
+  const bool removed = (packSlot >= 0) ? slidePack.remove(packSlot) : LittleFS.remove(path.c_str());
+  if (removed) {
     #ifdef USB_DEBUG
       Serial.printf("[Delete] Removed: %s\n", path.c_str());
     #endif
@@ -733,10 +908,15 @@ void SlideshowApp::returnToSlideshowMenu_() {
 void SlideshowApp::showCurrent_(bool allowManualOverlay, bool clearScreen) {
   if (files_.empty()) return;
 
-  const String& path = files_[idx_];
+  const SlideFile& slide = files_[idx_];
+  const String& path = slide.path;
 
-  // Check if this is a GIF file
-  if (isGif_(path)) {
+  if (kenBurns_.active && kenBurns_.index != idx_) {
+    stopKenBurns_();
+  }
+
+  // Check if this is an animation (GIF or native delta animation)
+  if (slide.type == SlideMediaType::Gif || slide.type == SlideMediaType::Anim) {
     showCurrentGif_(allowManualOverlay, clearScreen);
     return;
   }
@@ -748,56 +928,97 @@ void SlideshowApp::showCurrent_(bool allowManualOverlay, bool clearScreen) {
     digitalWrite(SD_CS_PIN, HIGH);
   }
 
-  File test = fs->open(path, FILE_READ);
-  if (!test) {
-    #ifdef USB_DEBUG
-      Serial.printf("[Slideshow] open FAIL: %s\n", path.c_str());
-    #endif
-    return;
-  }
-  uint8_t sig[2] = {0, 0};
-  size_t n = test.read(sig, 2);
-  test.close();
-  if (n != 2 || sig[0] != 0xFF || sig[1] != 0xD8) {
-    #ifdef USB_DEBUG
-      Serial.printf("[Slideshow] WARN SOI: %s\n", path.c_str());
-    #endif
-    return;
-  }
+  if (slide.type == SlideMediaType::Qoi) {
+    // Lossless stills decode straight from the file, centred on the panel
+    File file = openSlideFile_(slide, nullptr);
+    uint16_t w = slide.width;
+    uint16_t h = slide.height;
+    if (!file || (w == 0 && !getQoiSize(file, &w, &h))) {
+      #ifdef USB_DEBUG
+        Serial.printf("[Slideshow] WARN QOI header: %s\n", path.c_str());
+      #endif
+      return;
+    }
+    if (clearScreen || w < TFT_W || h < TFT_H) {
+      tft.fillScreen(TFT_BLACK);
+    }
+    const bool ok = drawQoi(file, (TFT_W - static_cast<int>(w)) / 2, (TFT_H - static_cast<int>(h)) / 2);
+    file.close();
+    if (!ok) {
+      #ifdef USB_DEBUG
+        Serial.printf("[Slideshow] draw fail (QOI): %s\n", path.c_str());
+      #endif
+      return;
+    }
+  } else {
+    size_t srcSize = 0;
+    time_t srcMtime = 0;
+    // Flash slides checked at upload (SlideMeta) skip the signature probe
+    if (source_ != SlideSource::Flash || slide.width == 0) {
+      uint8_t sig[2] = {0, 0};
+      size_t n = 0;
+      if (slide.packSlot >= 0) {
+        // Packed slides are read through the pack's open handle
+        n = slidePack.read(slide.packSlot, 0, sig, 2);
+      } else {
+        File test = fs->open(path, FILE_READ);
+        if (!test) {
+          #ifdef USB_DEBUG
+            Serial.printf("[Slideshow] open FAIL: %s\n", path.c_str());
+          #endif
+          return;
+        }
+        n = test.read(sig, 2);
+        srcSize = test.size();
+        srcMtime = test.getLastWrite();
+        test.close();
+      }
+      if (n != 2 || sig[0] != 0xFF || sig[1] != 0xD8) {
+        #ifdef USB_DEBUG
+          Serial.printf("[Slideshow] WARN SOI: %s\n", path.c_str());
+        #endif
+        return;
+      }
+    }
 
-  if (clearScreen) {
-    tft.fillScreen(TFT_BLACK);
-  }
+    // A running pan is redrawn at its current position instead of restarting
+    const bool kenBurns = kenBurns_.active || (ken_burns && startKenBurns_(idx_));
 
-  JRESULT rc = JDR_OK;
-  if (source_ == SlideSource::SDCard) {
-    rc = TJpgDec.drawSdJpg(0, 0, path.c_str());
-  } else {
-    digitalWrite(SD_CS_PIN, HIGH);
-    rc = TJpgDec.drawFsJpg(0, 0, path.c_str(), LittleFS);
-  }
-  if (rc != JDR_OK) {
-    #ifdef USB_DEBUG
-      Serial.printf("[Slideshow] draw fail (%d): %s\n", rc, path.c_str());
-    #endif
-    return;
-  }
+    if (clearScreen && !kenBurns) {
+      tft.fillScreen(TFT_BLACK);
+    }
 
-  String base = path;
-  int sidx = base.lastIndexOf('/');
-  if (sidx >= 0) base = base.substring(sidx + 1);
-  String displayName = base;
-  String lower = base;
-  lower.toLowerCase();
-  if (lower.endsWith(".jpg")) {
-    displayName = base.substring(0, base.length() - 4);
-  } else if (lower.endsWith(".jpeg")) {
-    displayName = base.substring(0, base.length() - 5);
+    JRESULT rc = JDR_OK;
+    if (kenBurns) {
+      renderKenBurnsFrame_();
+    } else if (source_ == SlideSource::SDCard) {
+      if (!previewCache_.draw(path, srcSize, srcMtime)) {
+        #ifdef USB_DEBUG
+          const uint32_t decodeStart = millis();
+        #endif
+        rc = drawSdJpgBuffered(0, 0, path.c_str());
+        #ifdef USB_DEBUG
+          Serial.printf("[Slideshow] SD decode %lu ms (%lu B)\n",
+                        static_cast<unsigned long>(millis() - decodeStart),
+                        static_cast<unsigned long>(srcSize));
+        #endif
+      }
+    } else {
+      rc = drawFlashJpg(0, 0, slide);
+    }
+    if (rc != JDR_OK) {
+      #ifdef USB_DEBUG
+        Serial.printf("[Slideshow] draw fail (%d): %s\n", rc, path.c_str());
+      #endif
+      return;
+    }
   }
 
+  const char* displayName = slide.displayName.c_str();
+
   if (controlMode_ == ControlMode::Manual) {
     if (allowManualOverlay) {
-      manualFilenameLabel_ = displayName;
+      strlcpy(manualFilenameLabel_, displayName, sizeof(manualFilenameLabel_));
       manualFilenameActive_ = true;
       manualFilenameDirty_ = true;
       if (show_filename) {
@@ -807,16 +1028,16 @@ void SlideshowApp::showCurrent_(bool allowManualOverlay, bool clearScreen) {
       }
     } else if (!show_filename) {
       manualFilenameActive_ = false;
-      manualFilenameLabel_.clear();
+      manualFilenameLabel_[0] = '\0';
       manualFilenameUntil_ = 0;
       manualFilenameDirty_ = true;
     }
   } else {
-    if (manualFilenameActive_ || !manualFilenameLabel_.isEmpty()) {
+    if (manualFilenameActive_ || manualFilenameLabel_[0]) {
       manualFilenameDirty_ = true;
     }
     manualFilenameActive_ = false;
-    manualFilenameLabel_.clear();
+    manualFilenameLabel_[0] = '\0';
     manualFilenameUntil_ = 0;
     if (show_filename) {
       int16_t y = TFT_H - TextRenderer::lineHeight() - 4;
@@ -839,8 +1060,16 @@ void SlideshowApp::showCurrent_(bool allowManualOverlay, bool clearScreen) {
 void SlideshowApp::advance_(int step) {
   if (files_.empty()) return;
 
-  // Stop any playing GIF when advancing
+  #ifdef USB_DEBUG
+    // Allocation check for the switch path: after warm-up a JPEG/QOI slide
+    // should log 0 (GIF slides keep their play buffers, stopping one frees them)
+    multi_heap_info_t heapBefore;
+    heap_caps_get_info(&heapBefore, MALLOC_CAP_DEFAULT);
+  #endif
+
+  // Stop any playing GIF or pan when advancing
   stopGif_();
+  stopKenBurns_();
 
   const size_t total = files_.size();
   int64_t next = static_cast<int64_t>(idx_) + step;
@@ -851,6 +1080,13 @@ void SlideshowApp::advance_(int step) {
   idx_ = static_cast<size_t>(next);
   showCurrent_();
   timeSinceSwitch_ = 0;
+
+  #ifdef USB_DEBUG
+    multi_heap_info_t heapAfter;
+    heap_caps_get_info(&heapAfter, MALLOC_CAP_DEFAULT);
+    Serial.printf("[Slideshow] advance: %+d heap blocks\n",
+                  static_cast<int>(heapAfter.allocated_blocks) - static_cast<int>(heapBefore.allocated_blocks));
+  #endif
 }
 
 void SlideshowApp::applyDwell_() {
@@ -859,7 +1095,7 @@ void SlideshowApp::applyDwell_() {
   autoSpeedSelection_ = dwellIdx_;
 }
 
-String SlideshowApp::dwellLabel_() const {
+const char* SlideshowApp::dwellLabel_() const {
   static char buf[12];
   if (dwell_ms % 60000 == 0) {
     snprintf(buf, sizeof(buf), "%lum", dwell_ms / 60000);
@@ -869,24 +1105,26 @@ String SlideshowApp::dwellLabel_() const {
   return buf;
 }
 
-String SlideshowApp::modeLabel_() const {
+const char* SlideshowApp::modeLabel_() const {
+  static char buf[32];
   switch (controlMode_) {
     case ControlMode::Auto:
-      return i18n.t("slideshow.mode_auto", dwellLabel_());
+      return i18n.format(buf, sizeof(buf), "slideshow.mode_auto", dwellLabel_());
     case ControlMode::Manual:
       return i18n.t("slideshow.mode_manual");
     case ControlMode::DeleteMenu:
       return i18n.t("slideshow.mode_delete");
   }
-  return String("?");
+  return "?";
 }
 
-String SlideshowApp::sourceLabel_() const {
-  return String(slideSourceLabel(source_));
+const char* SlideshowApp::sourceLabel_() const {
+  return slideSourceLabel(source_);
 }
 
-String SlideshowApp::dwellToastLabel_() const {
-  return i18n.t("slideshow.duration", dwellLabel_());
+const char* SlideshowApp::dwellToastLabel_() const {
+  static char buf[32];
+  return i18n.format(buf, sizeof(buf), "slideshow.duration", dwellLabel_());
 }
 
 void SlideshowApp::showToast_(const String& txt, uint32_t duration_ms) {
@@ -902,7 +1140,7 @@ void SlideshowApp::showToast_(const String& txt, uint32_t duration_ms) {
 
 void SlideshowApp::drawManualFilenameOverlay_() {
   const bool inManualMode = (controlMode_ == ControlMode::Manual);
-  if (!inManualMode || manualFilenameLabel_.isEmpty() || !manualFilenameActive_) {
+  if (!inManualMode || !manualFilenameLabel_[0] || !manualFilenameActive_) {
     manualFilenameDirty_ = false;
     return;
   }
@@ -915,14 +1153,14 @@ void SlideshowApp::drawManualFilenameOverlay_() {
   if (!show_filename) {
     if (!manualFilenameUntil_) {
       manualFilenameActive_ = false;
-      manualFilenameLabel_.clear();
+      manualFilenameLabel_[0] = '\0';
       manualFilenameDirty_ = false;
       return;
     }
     const uint32_t now = millis();
     if (now >= manualFilenameUntil_) {
       manualFilenameActive_ = false;
-      manualFilenameLabel_.clear();
+      manualFilenameLabel_[0] = '\0';
       manualFilenameUntil_ = 0;
       manualFilenameDirty_ = false;
       showCurrent_(false, false);
@@ -1128,7 +1366,7 @@ void SlideshowApp::drawDeleteSingleConfirmOverlay_() {
 }
 
 
-bool SlideshowApp::readDirectoryEntries_(fs::FS* fs, const String& basePath, std::vector<String>& out) {
+bool SlideshowApp::readDirectoryEntries_(fs::FS* fs, const String& basePath, std::vector<SlideFile>& out) {
   if (!fs) return false;
 
   File root = fs->open(basePath.c_str());
@@ -1141,20 +1379,28 @@ bool SlideshowApp::readDirectoryEntries_(fs::FS* fs, const String& basePath, std
     String base = f.name();
     int s = base.lastIndexOf('/');
     if (s >= 0) base = base.substring(s + 1);
-    if (!isMediaFile_(base)) continue;
+    SlideFile entry;
+    if (!slideMediaTypeFor(base.c_str(), &entry.type)) continue;
 
-    String full = basePath;
-    if (!full.endsWith("/")) full += "/";
-    full += base;
-    out.push_back(full);
+    entry.path = basePath;
+    if (!entry.path.endsWith("/")) entry.path += "/";
+    entry.path += base;
+    entry.displayName = base.substring(0, base.lastIndexOf('.'));
+    entry.size = f.size();
+    entry.mtime = static_cast<uint32_t>(f.getLastWrite());
+    out.push_back(std::move(entry));
   }
   root.close();
-  std::sort(out.begin(), out.end());
+  std::sort(out.begin(), out.end(), slidePathLess);
   return true;
 }
 
 bool SlideshowApp::rebuildFileListFrom_(SlideSource src) {
-  std::vector<String> tmp;
+  // Playback state refers to list positions
+  stopGif_();
+  stopKenBurns_();
+
+  std::vector<SlideFile> tmp;
   fs::FS* fs = filesystemFor(src);
   String base = (src == SlideSource::SDCard) ? dir : String(kFlashSlidesDir);
   if (!readDirectoryEntries_(fs, base, tmp)) {
@@ -1162,7 +1408,14 @@ bool SlideshowApp::rebuildFileListFrom_(SlideSource src) {
     return false;
   }
 
+  if (src == SlideSource::Flash) {
+    slidePack.list(tmp);
+    std::sort(tmp.begin(), tmp.end(), slidePathLess);
+    SlideMeta::apply(tmp);
+  }
+
   files_ = std::move(tmp);
+  previewCache_.reset(files_.size());
   return !files_.empty();
 }
 
@@ -1214,6 +1467,7 @@ void SlideshowApp::init() {
   deleteConfirmDirty_ = true;
   deleteSingleTimer_ = 0;
   deleteCurrentFile_.clear();
+  deleteCurrentSlot_ = -1;
   deleteCount_ = 0;
   menuScreen_ = MenuScreen::None;
   slideshowMenuSelection_ = 0;
@@ -1290,12 +1544,40 @@ void SlideshowApp::tick(uint32_t delta_ms) {
     return;
   }
 
-  if (!auto_mode) return;
+  if (!auto_mode) {
+    runPreviewJob_(kManualPreviewWindowMs);
+    runPackCompaction_(kManualPreviewWindowMs);
+    return;
+  }
 
   timeSinceSwitch_ += delta_ms;
   if (timeSinceSwitch_ >= dwell_ms) {
     advance_(+1);
+    return;
   }
+  runPreviewJob_(dwell_ms - timeSinceSwitch_);
+  runPackCompaction_(dwell_ms - timeSinceSwitch_);
+}
+
+void SlideshowApp::runPreviewJob_(uint32_t windowMs) {
+  // Previews are only worth it for SD photos, and only while the screen is static
+  if (source_ != SlideSource::SDCard || files_.empty() || gifPlaying_) return;
+  if (kenBurns_.active && !kenBurns_.finished) return;
+  if (menuScreen_ != MenuScreen::None || controlMode_ == ControlMode::DeleteMenu) return;
+  if (toastUntil_ || helperLinesUntil_ || manualFilenameUntil_) return;
+  if (windowMs < kPreviewMinWindowMs) return;
+
+  previewCache_.step(files_, idx_ + 1, millis() + windowMs - kPreviewSafetyMarginMs);
+}
+
+void SlideshowApp::runPackCompaction_(uint32_t windowMs) {
+  // Compaction moves the pack under open GIF handles; otherwise the same idle rules as previews
+  if (!slidePack.compactionPending() || gifPlaying_) return;
+  if (kenBurns_.active && !kenBurns_.finished) return;
+  if (menuScreen_ != MenuScreen::None || controlMode_ == ControlMode::DeleteMenu) return;
+  if (windowMs < kPreviewMinWindowMs) return;
+
+  slidePack.compactStep(kPackCompactionBudgetMs);
 }
 
 void SlideshowApp::onButton(uint8_t index, BtnEvent e) {
@@ -1313,6 +1595,10 @@ void SlideshowApp::onButton(uint8_t index, BtnEvent e) {
     handleAutoSpeedMenuButton_(e);
     return;
   }
+  if (menuScreen_ == MenuScreen::Grid) {
+    handleGridButton_(e);
+    return;
+  }
 
   switch (deleteState_) {
     case DeleteState::DeleteAllConfirm:
@@ -1381,6 +1667,8 @@ void SlideshowApp::onButton(uint8_t index, BtnEvent e) {
     case BtnEvent::Double:
       if (controlMode_ == ControlMode::DeleteMenu) {
         returnToSlideshowMenu_();
+      } else if (controlMode_ == ControlMode::Manual) {
+        openGrid_();
       }
       break;
 
@@ -1394,7 +1682,7 @@ void SlideshowApp::onButton(uint8_t index, BtnEvent e) {
             showCurrent_();
           } else {
             manualFilenameActive_ = false;
-            manualFilenameLabel_.clear();
+            manualFilenameLabel_[0] = '\0';
             manualFilenameUntil_ = 0;
             showCurrent_(false, false);
           }
@@ -1445,6 +1733,10 @@ void SlideshowApp::draw() {
     drawAutoSpeedMenu_();
     return;
   }
+  if (menuScreen_ == MenuScreen::Grid) {
+    drawGrid_();
+    return;
+  }
   if (deleteState_ == DeleteState::DeleteAllConfirm) {
     drawDeleteAllConfirmOverlay_();
     return;
@@ -1474,14 +1766,13 @@ void SlideshowApp::draw() {
     emptyMessageShown = false;  // Reset flag when files become available
   }
 
-  // Play GIF frames continuously if a GIF is active
-  if (gifPlaying_) {
-    tft.startWrite();
-    if (!gif_.playFrame(true, NULL)) {
-      // End of GIF reached - loop back to start
-      gif_.reset();
-    }
-    tft.endWrite();
+  if (gifPlaying_ && static_cast<int32_t>(millis() - gifNextFrameAt_) >= 0) {
+    playGifFrame_();
+  }
+
+  if (kenBurns_.active && !kenBurns_.finished &&
+      millis() - kenBurns_.lastFrameAt >= kKenBurnsFrameMs) {
+    renderKenBurnsFrame_();
   }
 
   drawManualFilenameOverlay_();
@@ -1491,6 +1782,7 @@ void SlideshowApp::draw() {
 
 void SlideshowApp::shutdown() {
   stopGif_();
+  stopKenBurns_();
   files_.clear();
 }
 
@@ -1503,6 +1795,129 @@ void SlideshowApp::resume() {
   }
 }
 
+// ============================================================================
+// Ken Burns Implementation
+// ============================================================================
+
+bool SlideshowApp::startKenBurns_(size_t index) {
+  if (index >= files_.size() || files_[index].type != SlideMediaType::Jpeg) return false;
+  const SlideFile& slide = files_[index];
+
+  uint16_t w = slide.width;
+  uint16_t h = slide.height;
+  JRESULT rc = JDR_OK;
+  if (source_ == SlideSource::SDCard) {
+    rc = getSdJpgSizeBuffered(&w, &h, slide.path.c_str());
+  } else if (w == 0) {
+    rc = getFlashJpgSize(&w, &h, slide);
+  }
+  if (rc != JDR_OK || (w <= TFT_W && h <= TFT_H)) {
+    return false;
+  }
+
+  // Smallest magnification at which the photo still covers the whole panel
+  uint8_t cover = kKenBurnsLevelCount;
+  for (uint8_t i = 0; i < kKenBurnsLevelCount; ++i) {
+    if (kenBurnsSize(w, kKenBurnsLevels[i]) >= TFT_W && kenBurnsSize(h, kKenBurnsLevels[i]) >= TFT_H) {
+      cover = i;
+      break;
+    }
+  }
+  if (cover == kKenBurnsLevelCount) {
+    return false;
+  }
+
+  kenBurns_ = KenBurnsState();
+  kenBurns_.active = true;
+  kenBurns_.index = index;
+  kenBurns_.imageW = w;
+  kenBurns_.imageH = h;
+  kenBurns_.startLevel = cover;
+  // Every other slide zooms one level closer halfway through the pan
+  const bool zoomIn = (index % 2 == 1) && (cover + 1 < kKenBurnsLevelCount);
+  kenBurns_.endLevel = zoomIn ? cover + 1 : cover;
+  kenBurns_.reverse = ((index / 2) % 2 == 1);
+  kenBurns_.startedAt = millis();
+
+  #ifdef USB_DEBUG
+    Serial.printf("[Slideshow] Ken Burns %ux%u, level %u->%u\n",
+                  w, h, kenBurns_.startLevel, kenBurns_.endLevel);
+  #endif
+  return true;
+}
+
+void SlideshowApp::renderKenBurnsFrame_() {
+  if (kenBurns_.index >= files_.size()) {
+    stopKenBurns_();
+    return;
+  }
+  const SlideFile& slide = files_[kenBurns_.index];
+  const String& path = slide.path;
+  const uint32_t now = millis();
+  const uint32_t duration = auto_mode ? dwell_ms : kKenBurnsManualMs;
+  float t = duration ? static_cast<float>(now - kenBurns_.startedAt) / duration : 1.0f;
+  if (t >= 1.0f) {
+    t = 1.0f;
+    kenBurns_.finished = true;
+  }
+  kenBurns_.lastFrameAt = now;
+
+  // The view centre travels diagonally in normalised image coordinates,
+  // so the zoom step keeps following the same path
+  const KenBurnsLevel& startLevel = kKenBurnsLevels[kenBurns_.startLevel];
+  const float marginX = (TFT_W / 2.0f) / kenBurnsSize(kenBurns_.imageW, startLevel);
+  const float marginY = (TFT_H / 2.0f) / kenBurnsSize(kenBurns_.imageH, startLevel);
+  const float p = kenBurns_.reverse ? 1.0f - t : t;
+  const float cx = marginX + (1.0f - 2.0f * marginX) * p;
+  const float cy = marginY + (1.0f - 2.0f * marginY) * p;
+
+  const KenBurnsLevel& level = kKenBurnsLevels[(t < 0.5f) ? kenBurns_.startLevel : kenBurns_.endLevel];
+  const int32_t scaledW = kenBurnsSize(kenBurns_.imageW, level);
+  const int32_t scaledH = kenBurnsSize(kenBurns_.imageH, level);
+  const int32_t offX = constrain(static_cast<int32_t>(cx * scaledW) - TFT_W / 2, 0, scaledW - TFT_W);
+  const int32_t offY = constrain(static_cast<int32_t>(cy * scaledH) - TFT_H / 2, 0, scaledH - TFT_H);
+
+  TJpgDec.setJpgScale(level.jpgScale);
+  gfxJpegSetView(offX / level.upscale, offY / level.upscale, level.upscale);
+  JRESULT rc;
+  if (source_ == SlideSource::SDCard) {
+    rc = drawSdJpgBuffered(0, 0, path.c_str());
+  } else {
+    rc = drawFlashJpg(0, 0, slide);
+  }
+  gfxJpegClearView();
+  TJpgDec.setJpgScale(1);
+
+  // JDR_INTR: decode stopped below the view on purpose
+  if (rc != JDR_OK && rc != JDR_INTR) {
+    #ifdef USB_DEBUG
+      Serial.printf("[Slideshow] Ken Burns draw fail (%d): %s\n", rc, path.c_str());
+    #endif
+    kenBurns_.finished = true;
+    return;
+  }
+
+  // The frame covered the whole panel: overlays need to be drawn again
+  if (toastUntil_) {
+    toastDirty_ = true;
+  }
+  if (manualFilenameActive_) {
+    manualFilenameDirty_ = true;
+  }
+  if (helperLinesUntil_) {
+    helperLinesDirty_ = true;
+  }
+  if (controlMode_ != ControlMode::Manual && show_filename) {
+    int16_t y = TFT_H - TextRenderer::lineHeight() - 4;
+    if (y < 0) y = 0;
+    TextRenderer::drawCentered(y, files_[kenBurns_.index].displayName, TFT_WHITE, TFT_BLACK);
+  }
+}
+
+void SlideshowApp::stopKenBurns_() {
+  kenBurns_ = KenBurnsState();
+}
+
 // ============================================================================
 // GIF Support Implementation
 // ============================================================================
@@ -1510,17 +1925,120 @@ void SlideshowApp::resume() {
 // Static file handle for GIF callbacks
 static File gifFile;
 
+// Start of the GIF inside gifFile (non-zero for packed slides)
+static uint32_t gifBase = 0;
+
+// Small GIFs are played from RAM; larger ones read through the shared
+// read-ahead window (BufferedFile) instead of one file access per LZW block
+static uint8_t* gifRamData = nullptr;
+
+// Slide being opened, for gifOpen_
+static const SlideFile* gifOpenSlide = nullptr;
+
 // Static instance pointer for accessing member variables from static callbacks
 static SlideshowApp* currentSlideshowInstance = nullptr;
 
-// Decide whether we can double the GIF without exceeding the display bounds
-static int determineGifScale(int canvasW, int canvasH) {
+// Integer magnification for small GIFs, half size for oversized ones
+static void determineGifScale(int canvasW, int canvasH, int* scale, int* shrink) {
+  *scale = 1;
+  *shrink = 1;
   if (canvasW <= 0 || canvasH <= 0) {
-    return 1;
+    return;
+  }
+  if (canvasW > TFT_W || canvasH > TFT_H) {
+    // Beyond twice the panel the half-size picture is still clipped
+    *shrink = kGifMaxShrink;
+    return;
+  }
+  while (*scale < kGifMaxScale && canvasW * (*scale + 1) <= TFT_W &&
+         canvasH * (*scale + 1) <= TFT_H) {
+    ++*scale;
+  }
+}
+
+// First panel coordinate showing canvas coordinate c (c * scale / shrink,
+// rounded up), clamped to the panel
+static int16_t gifPanelCoord(int c, int offset, int scale, int shrink, int limit) {
+  const int p = offset + (c * scale + shrink - 1) / shrink;
+  return static_cast<int16_t>(std::min(std::max(p, 0), limit));
+}
+
+void SlideshowApp::setupGifScale_(int canvasW, int canvasH) {
+  gifCanvasW_ = canvasW;
+  gifCanvasH_ = canvasH;
+  determineGifScale(canvasW, canvasH, &gifScale_, &gifShrink_);
+  const int outW = (canvasW * gifScale_ + gifShrink_ - 1) / gifShrink_;
+  const int outH = (canvasH * gifScale_ + gifShrink_ - 1) / gifShrink_;
+  gifOffsetX_ = (TFT_W - outW) / 2;
+  gifOffsetY_ = (TFT_H - outH) / 2;
+
+  gifColStart_.resize(canvasW + 1);
+  for (int c = 0; c <= canvasW; c++) {
+    gifColStart_[c] = gifPanelCoord(c, gifOffsetX_, gifScale_, gifShrink_, TFT_W);
+  }
+  gifRowStart_.resize(canvasH + 1);
+  for (int r = 0; r <= canvasH; r++) {
+    gifRowStart_[r] = gifPanelCoord(r, gifOffsetY_, gifScale_, gifShrink_, TFT_H);
+  }
+  // Panel columns outside the picture are never looked up
+  for (int x = 0; x < TFT_W; x++) {
+    const int c = ((x - gifOffsetX_) * gifShrink_) / gifScale_;
+    gifSrcColumn_[x] = static_cast<uint16_t>(std::min(std::max(c, 0), canvasW - 1));
   }
-  const bool needsUpscale = (canvasW < TFT_W) || (canvasH < TFT_H);
-  const bool fitsDouble = (canvasW * 2 <= TFT_W) && (canvasH * 2 <= TFT_H);
-  return (needsUpscale && fitsDouble) ? 2 : 1;
+}
+
+File SlideshowApp::openSlideFile_(const SlideFile& slide, uint32_t* size) {
+  if (slide.packSlot >= 0) {
+    return slidePack.openSlide(slide.packSlot, size);
+  }
+  fs::FS* fs = filesystemFor(source_);
+  if (!fs) {
+    return File();
+  }
+  File f;
+  if (source_ == SlideSource::Flash) {
+    digitalWrite(SD_CS_PIN, HIGH);
+    f = fs->open(slide.path.c_str(), FILE_READ);
+  } else {
+    // Animations seek back on every loop; the link map makes that O(1)
+    f = openSdFastSeek(slide.path.c_str());
+  }
+  if (f && size) {
+    *size = f.size();
+  }
+  return f;
+}
+
+bool SlideshowApp::loadGifToRam_(const SlideFile& slide, int32_t* size) {
+  uint32_t fileSize = 0;
+  File f = openSlideFile_(slide, &fileSize);
+  if (!f) {
+    return false;
+  }
+  // Keep enough heap for the rest of the system after the copy
+  if (fileSize == 0 || fileSize > kGifRamMaxBytes ||
+      ESP.getMaxAllocHeap() < fileSize + kGifHeapReserveBytes) {
+    f.close();
+    return false;
+  }
+  gifRamData = static_cast<uint8_t*>(malloc(fileSize));
+  if (!gifRamData) {
+    f.close();
+    return false;
+  }
+  const size_t n = f.read(gifRamData, fileSize);
+  f.close();
+  if (n != fileSize) {
+    freeGifBuffers_();
+    return false;
+  }
+  *size = static_cast<int32_t>(fileSize);
+  return true;
+}
+
+void SlideshowApp::freeGifBuffers_() {
+  free(gifRamData);
+  gifRamData = nullptr;
 }
 
 void* SlideshowApp::gifOpen_(const char* fname, int32_t* pSize) {
@@ -1528,24 +2046,25 @@ void* SlideshowApp::gifOpen_(const char* fname, int32_t* pSize) {
     Serial.printf("[Slideshow] Opening GIF: %s\n", fname);
   #endif
 
-  gifFile = LittleFS.open(fname, "r");
-  if (!gifFile) {
-    // Try SD card
-    gifFile = SD.open(fname, FILE_READ);
+  SlideshowApp* inst = currentSlideshowInstance;
+  if (!inst || !gifOpenSlide) {
+    return NULL;
   }
-
-  if (gifFile) {
-    *pSize = gifFile.size();
+  uint32_t size = 0;
+  gifFile = openBuffered(inst->openSlideFile_(*gifOpenSlide, &size));
+  if (!gifFile) {
     #ifdef USB_DEBUG
-      Serial.printf("[Slideshow] GIF size: %d bytes\n", *pSize);
+      Serial.println(F("[Slideshow] Failed to open GIF file"));
     #endif
-    return (void*)&gifFile;
+    return NULL;
   }
 
+  gifBase = gifFile.position();
+  *pSize = static_cast<int32_t>(size);
   #ifdef USB_DEBUG
-    Serial.println(F("[Slideshow] Failed to open GIF file"));
+    Serial.printf("[Slideshow] GIF size: %d bytes\n", *pSize);
   #endif
-  return NULL;
+  return (void*)&gifFile;
 }
 
 void SlideshowApp::gifClose_(void* pHandle) {
@@ -1555,13 +2074,22 @@ void SlideshowApp::gifClose_(void* pHandle) {
 }
 
 int32_t SlideshowApp::gifRead_(GIFFILE* pFile, uint8_t* pBuf, int32_t iLen) {
-  int32_t bytesRead = gifFile.read(pBuf, iLen);
-  pFile->iPos = gifFile.position();
+  // A packed GIF is followed by the next slide, never read past its end
+  if (pFile->iSize - pFile->iPos < iLen) {
+    iLen = pFile->iSize - pFile->iPos;
+  }
+  if (iLen <= 0) {
+    return 0;
+  }
+
+  gifFile.seek(gifBase + pFile->iPos);
+  const int32_t bytesRead = gifFile.read(pBuf, iLen);
+  pFile->iPos += std::max<int32_t>(bytesRead, 0);
   return bytesRead;
 }
 
 int32_t SlideshowApp::gifSeek_(GIFFILE* pFile, int32_t iPosition) {
-  gifFile.seek(iPosition);
+  // Reads seek themselves; a seek inside the read-ahead window is free
   pFile->iPos = iPosition;
   return iPosition;
 }
@@ -1576,125 +2104,22 @@ void SlideshowApp::gifDraw_(GIFDRAW* pDraw) {
   if (inst->gifCanvasW_ <= 0 || inst->gifCanvasH_ <= 0) {
     int canvasW = (pDraw->iCanvasWidth > 0) ? pDraw->iCanvasWidth : pDraw->iWidth;
     int canvasH = pDraw->iHeight;
-    inst->gifCanvasW_ = canvasW;
-    inst->gifCanvasH_ = canvasH;
-    inst->gifScale_ = determineGifScale(canvasW, canvasH);
-    inst->gifOffsetX_ = (TFT_W - (canvasW * inst->gifScale_)) / 2;
-    inst->gifOffsetY_ = (TFT_H - (canvasH * inst->gifScale_)) / 2;
+    inst->setupGifScale_(canvasW, canvasH);
   }
 
-  const int scale = inst->gifScale_;
-
-  if (pDraw->y == 0) {
-    int clearX = inst->gifOffsetX_;
-    int clearY = inst->gifOffsetY_;
-    int clearW = inst->gifCanvasW_ * scale;
-    int clearH = inst->gifCanvasH_ * scale;
-
-    if (clearW > 0 && clearH > 0) {
-      if (clearX < 0) {
-        clearW += clearX;
-        clearX = 0;
-      }
-      if (clearY < 0) {
-        clearH += clearY;
-        clearY = 0;
-      }
-      if (clearX < TFT_W && clearY < TFT_H) {
-        if (clearX + clearW > TFT_W) clearW = TFT_W - clearX;
-        if (clearY + clearH > TFT_H) clearH = TFT_H - clearY;
-        if (clearW > 0 && clearH > 0) {
-          tft.fillRect(clearX, clearY, clearW, clearH, TFT_BLACK);
-        }
-      }
-    }
-  }
-
-  if (scale == 1) {
-    uint8_t* s = pDraw->pPixels;
-    int iWidth = pDraw->iWidth;
-    int y = pDraw->iY + pDraw->y + inst->gifOffsetY_;
-    int x = pDraw->iX + inst->gifOffsetX_;
-
-    if (y >= TFT_H || y < 0 || x >= TFT_W) return;
-
-    if (iWidth + x > TFT_W) {
-      iWidth = TFT_W - x;
-    }
-    if (x < 0) {
-      s += (-x);
-      iWidth += x;
-      x = 0;
-    }
-    if (iWidth <= 0) return;
-
-    tft.setAddrWindow(x, y, iWidth, 1);
-
-    if (pDraw->ucDisposalMethod == 2) {
-      for (int idx = 0; idx < iWidth; idx++) {
-        if (s[idx] == pDraw->ucTransparent) {
-          s[idx] = pDraw->ucBackground;
-        }
-      }
-      pDraw->ucHasTransparency = 0;
-    }
-
-    if (pDraw->ucHasTransparency) {
-      uint16_t usTemp[iWidth];
-      int count = 0;
-
-      for (int i = 0; i < iWidth; i++) {
-        if (s[i] != pDraw->ucTransparent) {
-          usTemp[count++] = usPalette[s[i]];
-        } else {
-          if (count > 0) {
-            tft.pushPixels(usTemp, count);
-            count = 0;
-          }
-        }
-      }
-
-      if (count > 0) {
-        tft.pushPixels(usTemp, count);
-      }
-
-    } else {
-      uint16_t usTemp[iWidth];
-      for (int i = 0; i < iWidth; i++) {
-        usTemp[i] = usPalette[s[i]];
-      }
-      tft.pushPixels(usTemp, iWidth);
-    }
+  if (inst->gifCanvas_.active()) {
+    inst->gifCanvas_.drawRow(pDraw);
     return;
   }
 
-  // Scale > 1 path (currently only 2x)
-  uint8_t* s = pDraw->pPixels;
-  int iWidth = pDraw->iWidth;
-  int baseX = inst->gifOffsetX_ + (pDraw->iX * scale);
-  int baseY = inst->gifOffsetY_ + (pDraw->iY + pDraw->y) * scale;
-
-  if (baseY >= TFT_H || baseY + scale <= 0 || baseX >= TFT_W) return;
-
-  // Clip left side if needed
-  if (baseX < 0) {
-    const int skipCols = (-baseX + scale - 1) / scale;
-    if (skipCols >= iWidth) return;
-    baseX += skipCols * scale;
-    s += skipCols;
-    iWidth -= skipCols;
-  }
-
-  // Clip right side if needed
-  int maxWidthPx = TFT_W - baseX;
-  if (maxWidthPx <= 0) return;
-  int maxCols = maxWidthPx / scale;
-  if (maxCols <= 0) return;
-  if (iWidth > maxCols) {
-    iWidth = maxCols;
+  if (pDraw->y == 0) {
+    gifClearCanvas_();
+    inst->gifFrameCache_.markClear();
   }
 
-  if (iWidth <= 0) return;
+  uint8_t* s = pDraw->pPixels;
+  const int iWidth = pDraw->iWidth;
+  const int16_t y = pDraw->iY + pDraw->y;
 
   if (pDraw->ucDisposalMethod == 2) {
     for (int idx = 0; idx < iWidth; idx++) {
@@ -1705,24 +2130,16 @@ void SlideshowApp::gifDraw_(GIFDRAW* pDraw) {
     pDraw->ucHasTransparency = 0;
   }
 
-  auto drawScaledRun = [&](int runStart, int runLen) {
+  // Opaque runs go to the panel and, during the first loop, into the frame cache
+  uint16_t usTemp[iWidth];
+  auto emitRun = [&](int runStart, int runLen) {
     if (runLen <= 0) return;
-    const int runWidth = runLen * scale;
-    uint16_t runBuf[runWidth];
-    int out = 0;
     for (int i = 0; i < runLen; i++) {
-      uint16_t color = usPalette[s[runStart + i]];
-      for (int r = 0; r < scale; r++) {
-        runBuf[out++] = color;
-      }
-    }
-    const int runX = baseX + runStart * scale;
-    for (int v = 0; v < scale; v++) {
-      int drawY = baseY + v;
-      if (drawY < 0 || drawY >= TFT_H) continue;
-      tft.setAddrWindow(runX, drawY, runWidth, 1);
-      tft.pushPixels(runBuf, runWidth);
+      usTemp[i] = usPalette[s[runStart + i]];
     }
+    const int16_t x = pDraw->iX + runStart;
+    gifPushRun_(x, y, usTemp, runLen);
+    inst->gifFrameCache_.addRun(x, y, usTemp, runLen);
   };
 
   if (pDraw->ucHasTransparency) {
@@ -1736,24 +2153,84 @@ void SlideshowApp::gifDraw_(GIFDRAW* pDraw) {
       while (idx < iWidth && s[idx] != pDraw->ucTransparent) {
         idx++;
       }
-      drawScaledRun(runStart, idx - runStart);
+      emitRun(runStart, idx - runStart);
     }
   } else {
-    drawScaledRun(0, iWidth);
+    emitRun(0, iWidth);
+  }
+}
+
+void SlideshowApp::gifClearCanvas_() {
+  SlideshowApp* inst = currentSlideshowInstance;
+  if (!inst || inst->gifColStart_.empty() || inst->gifRowStart_.empty()) return;
+
+  const int16_t x0 = inst->gifColStart_.front();
+  const int16_t y0 = inst->gifRowStart_.front();
+  const int16_t w = inst->gifColStart_.back() - x0;
+  const int16_t h = inst->gifRowStart_.back() - y0;
+  if (w > 0 && h > 0) {
+    tft.fillRect(x0, y0, w, h, TFT_BLACK);
+  }
+}
+
+void SlideshowApp::gifPushRun_(int16_t x, int16_t y, const uint16_t* colors, uint16_t len) {
+  SlideshowApp* inst = currentSlideshowInstance;
+  if (!inst) return;
+
+  // Runs are clipped to the canvas, the tables clip to the panel
+  const int canvasW = static_cast<int>(inst->gifColStart_.size()) - 1;
+  const int canvasH = static_cast<int>(inst->gifRowStart_.size()) - 1;
+  if (y < 0 || y >= canvasH) return;
+  int x0 = x;
+  int x1 = x + len;
+  if (x0 < 0) x0 = 0;
+  if (x1 > canvasW) x1 = canvasW;
+  if (x1 <= x0) return;
+
+  const int16_t outX0 = inst->gifColStart_[x0];
+  const int16_t outX1 = inst->gifColStart_[x1];
+  const int16_t outY0 = inst->gifRowStart_[y];
+  const int16_t outY1 = inst->gifRowStart_[y + 1];
+  const int outW = outX1 - outX0;
+  const int outH = outY1 - outY0;
+  if (outW <= 0 || outH <= 0) return;  // clipped, or a row dropped by the shrink
+
+  // One address window for all panel rows of this canvas row
+  tft.setAddrWindow(outX0, outY0, outW, outH);
+  if (inst->gifScale_ == 1 && inst->gifShrink_ == 1) {
+    tft.pushPixels(colors + (inst->gifSrcColumn_[outX0] - x), outW);
+    return;
+  }
+
+  uint16_t runBuf[TFT_W];
+  const uint16_t* src = inst->gifSrcColumn_ + outX0;
+  const uint16_t* base = colors - x;
+  for (int i = 0; i < outW; i++) {
+    runBuf[i] = base[src[i]];
+  }
+  for (int v = 0; v < outH; v++) {
+    tft.pushPixels(runBuf, outW);
+  }
+}
+
+void SlideshowApp::gifRecordRun_(int16_t x, int16_t y, const uint16_t* colors, uint16_t len) {
+  if (currentSlideshowInstance) {
+    currentSlideshowInstance->gifFrameCache_.addRun(x, y, colors, len);
   }
 }
 
 void SlideshowApp::showCurrentGif_(bool allowManualOverlay, bool clearScreen) {
   if (files_.empty()) return;
 
-  const String& path = files_[idx_];
+  const SlideFile& slide = files_[idx_];
+  const String& path = slide.path;
 
   #ifdef USB_DEBUG
     Serial.printf("[Slideshow] Displaying GIF: %s\n", path.c_str());
   #endif
 
   // If already playing this GIF, don't reopen
-  if (gifPlaying_ && currentGifPath_ == path) {
+  if (gifPlaying_ && gifIndex_ == idx_) {
     return;
   }
 
@@ -1765,18 +2242,8 @@ void SlideshowApp::showCurrentGif_(bool allowManualOverlay, bool clearScreen) {
 
   // Step 2: Show filename for 2 seconds (only in Manual mode)
   if (controlMode_ == ControlMode::Manual && allowManualOverlay) {
-    String base = path;
-    int sidx = base.lastIndexOf('/');
-    if (sidx >= 0) base = base.substring(sidx + 1);
-    String displayName = base;
-    String lower = base;
-    lower.toLowerCase();
-    if (lower.endsWith(".gif")) {
-      displayName = base.substring(0, base.length() - 4);
-    }
-
     // Display filename in center
-    TextRenderer::drawCentered(TFT_H / 2, displayName, TFT_WHITE, TFT_BLACK);
+    TextRenderer::drawCentered(TFT_H / 2, slide.displayName, TFT_WHITE, TFT_BLACK);
 
     // Wait 2 seconds
     delay(2000);
@@ -1791,45 +2258,75 @@ void SlideshowApp::showCurrentGif_(bool allowManualOverlay, bool clearScreen) {
   gifOffsetX_ = 0;
   gifOffsetY_ = 0;
   gifScale_ = 1;
+  gifShrink_ = 1;
 
   // Set the instance pointer for static callbacks
   currentSlideshowInstance = this;
 
-  // Step 4: Open and start GIF
-  if (!gif_.open(path.c_str(), gifOpen_, gifClose_, gifRead_, gifSeek_, gifDraw_)) {
+  // Step 4: Open and start the animation. Native delta animations stream
+  // from their file as they are; GIFs play from RAM if they fit.
+  bool opened = false;
+  if (slide.type == SlideMediaType::Anim) {
+    opened = anim_.open(openSlideFile_(slide, nullptr));
+  } else {
+    int32_t ramSize = 0;
+    opened = loadGifToRam_(slide, &ramSize) && gif_.open(gifRamData, ramSize, gifDraw_);
+    if (!opened) {
+      freeGifBuffers_();
+      gifOpenSlide = &slide;
+      opened = gif_.open(path.c_str(), gifOpen_, gifClose_, gifRead_, gifSeek_, gifDraw_);
+      gifOpenSlide = nullptr;
+    }
+  }
+  if (!opened) {
+    freeGifBuffers_();
     #ifdef USB_DEBUG
       Serial.println(F("[Slideshow] Failed to open GIF"));
     #endif
     return;
   }
 
-  #ifdef USB_DEBUG
-    Serial.printf("[Slideshow] GIF opened: %dx%d\n",
-                  gif_.getCanvasWidth(), gif_.getCanvasHeight());
-  #endif
+  gifPlaying_ = true;
+  gifIndex_ = idx_;
+  gifNextFrameAt_ = millis();
+  gifFrameCount_ = 0;
+  gifStartedAt_ = millis();
+  gifDroppedFrames_ = 0;
 
-  // Cache the logical GIF canvas dimensions for consistent centering
-  gifCanvasW_ = gif_.getCanvasWidth();
-  gifCanvasH_ = gif_.getCanvasHeight();
-  if (gifCanvasW_ <= 0 || gifCanvasH_ <= 0) {
-    // Fallback: first decoded frame will provide the size
-    gifCanvasW_ = 0;
-    gifCanvasH_ = 0;
-    gifOffsetX_ = 0;
-    gifOffsetY_ = 0;
-    gifScale_ = 1;
-  } else {
-    gifScale_ = determineGifScale(gifCanvasW_, gifCanvasH_);
-    gifOffsetX_ = (TFT_W - (gifCanvasW_ * gifScale_)) / 2;
-    gifOffsetY_ = (TFT_H - (gifCanvasH_ * gifScale_)) / 2;
-  }
+  if (!anim_.isOpen()) {
+    #ifdef USB_DEBUG
+      Serial.printf("[Slideshow] GIF opened: %dx%d\n",
+                    gif_.getCanvasWidth(), gif_.getCanvasHeight());
+    #endif
 
-  gifPlaying_ = true;
-  currentGifPath_ = path;
+    // Cache the logical GIF canvas dimensions for consistent centering
+    if (gif_.getCanvasWidth() > 0 && gif_.getCanvasHeight() > 0) {
+      setupGifScale_(gif_.getCanvasWidth(), gif_.getCanvasHeight());
+    }
+    // Otherwise the first decoded frame will provide the size
+
+    // Indexed canvas first: it is what cuts the SPI traffic of every frame
+    if (kGifUseCanvas && gifCanvasW_ > 0 && gifCanvasH_ > 0 && gifShrink_ == 1 &&
+        static_cast<size_t>(gifCanvasW_) * gifCanvasH_ <= GifCanvas::kMaxPixels &&
+        ESP.getMaxAllocHeap() >= static_cast<size_t>(gifCanvasW_) * gifCanvasH_ + kGifHeapReserveBytes) {
+      gifCanvas_.begin(gifCanvasW_, gifCanvasH_, gifScale_, gifOffsetX_, gifOffsetY_);
+    }
+
+    // Record a loop if there is heap to spare for it. Canvas frames only hold
+    // what changed, so recording starts once the first loop has wrapped and
+    // every recorded loop begins from the same picture.
+    const size_t maxAlloc = ESP.getMaxAllocHeap();
+    gifCacheBudget_ = (maxAlloc > kGifHeapReserveBytes)
+                          ? std::min<size_t>(kGifFrameCacheBytes, maxAlloc - kGifHeapReserveBytes)
+                          : 0;
+    if (!gifCanvas_.active()) {
+      gifFrameCache_.begin(gifCacheBudget_);
+    }
+  }
 
   // Don't use the manualFilename overlay system for GIFs
   manualFilenameActive_ = false;
-  manualFilenameLabel_.clear();
+  manualFilenameLabel_[0] = '\0';
   manualFilenameUntil_ = 0;
 
   if (toastUntil_) {
@@ -1838,23 +2335,92 @@ void SlideshowApp::showCurrentGif_(bool allowManualOverlay, bool clearScreen) {
   drawToastOverlay_();
 
   #ifdef USB_DEBUG
-    Serial.printf("[Slideshow] GIF opened (%s): %s\n", slideSourceLabel(source_), path.c_str());
+    Serial.printf("[Slideshow] GIF opened (%s, %s): %s\n", slideSourceLabel(source_),
+                  gifRamData ? "RAM" : "stream", path.c_str());
   #endif
 }
 
+void SlideshowApp::playGifFrame_() {
+  int delayMs = 0;
+  tft.startWrite();
+  if (anim_.isOpen()) {
+    // Delta frames are pushed straight from the file, nothing to cache
+    const int rc = anim_.playFrame(&delayMs);
+    if (rc <= 0) {
+      anim_.seekFrame(0);
+    }
+    if (rc < 0) {
+      delayMs = kAnimRetryMs;
+    }
+  } else if (gifFrameCache_.ready()) {
+    // Later loops: replay the recorded output, no decoding
+    delayMs = gifFrameCache_.replayFrame(gifClearCanvas_, gifPushRun_);
+  } else {
+    // Async mode: the decoder reports the frame delay instead of sleeping on it
+    gifFrameCache_.beginFrame();
+    const int rc = gif_.playFrame(false, &delayMs);
+    if (gifCanvas_.active()) {
+      gifCanvas_.flush(gifFrameCache_.capturing() ? gifRecordRun_ : nullptr);
+    }
+    gifFrameCache_.endFrame(static_cast<uint16_t>(std::max(delayMs, 0)), rc == 0);
+    if (rc == 0) {
+      // Last frame shown - loop back to start
+      gif_.reset();
+      if (gifCanvas_.active()) {
+        gifCanvas_.restartLoop();
+        if (gifCacheBudget_ > 0 && !gifFrameCache_.ready()) {
+          gifFrameCache_.begin(gifCacheBudget_);
+          gifCacheBudget_ = 0;  // one attempt per GIF
+        }
+      }
+    }
+  }
+  tft.endWrite();
+  ++gifFrameCount_;
+
+  // The deadline advances by the nominal delay, so slow frames eat into the
+  // following waits. Once too far behind, the missed slots are written off
+  // instead of rushing through them.
+  gifNextFrameAt_ += static_cast<uint32_t>(std::max(delayMs, 0));
+  const uint32_t now = millis();
+  const int32_t lag = static_cast<int32_t>(now - gifNextFrameAt_);
+  if (lag > static_cast<int32_t>(kGifMaxLagMs)) {
+    if (delayMs > 0) {
+      gifDroppedFrames_ += static_cast<uint32_t>(lag) / static_cast<uint32_t>(delayMs);
+    }
+    gifNextFrameAt_ = now;
+  }
+}
+
 void SlideshowApp::stopGif_() {
   if (gifPlaying_) {
+    #ifdef USB_DEBUG
+      const uint32_t elapsed = millis() - gifStartedAt_;
+      Serial.printf("[Slideshow] GIF stop: %lu frames, %lu dropped, %.1f fps (scale %d/%d%s)\n",
+                    static_cast<unsigned long>(gifFrameCount_),
+                    static_cast<unsigned long>(gifDroppedFrames_),
+                    elapsed ? gifFrameCount_ * 1000.0f / elapsed : 0.0f,
+                    gifScale_, gifShrink_, gifCanvas_.active() ? ", canvas" : "");
+    #endif
     gif_.close();
+    anim_.close();
     if (gifFile) {
       gifFile.close();
     }
+    freeGifBuffers_();
+    gifFrameCache_.reset();
+    gifCanvas_.end();
+    gifCacheBudget_ = 0;
     gifPlaying_ = false;
-    currentGifPath_.clear();
+    gifIndex_ = 0;
     gifCanvasW_ = 0;
     gifCanvasH_ = 0;
     gifOffsetX_ = 0;
     gifOffsetY_ = 0;
     gifScale_ = 1;
+    gifShrink_ = 1;
+    gifColStart_.clear();
+    gifRowStart_.clear();
 
     // Clear instance pointer
     if (currentSlideshowInstance == this) {
@@ -7,6 +7,11 @@
 #include "Core/App.h"
 #include "Core/Storage.h"
 #include "Core/I18n.h"
+#include "Core/SlidePreviewCache.h"
+#include "Core/ThumbnailCache.h"
+#include "Core/GifFrameCache.h"
+#include "Core/GifCanvas.h"
+#include "Core/DeltaAnim.h"
 
 class SlideshowApp : public App {
 public:
@@ -14,6 +19,7 @@ public:
   uint32_t dwell_ms = 5000;
   bool show_filename = false;
   bool auto_mode = true;  // true = Auto-Slideshow, false = Manuell/Delete
+  bool ken_burns = false; // Pan/Zoom für Fotos größer als das Display
 
   const char* name() const override { return i18n.t("apps.slideshow"); }
   void init() override;
@@ -32,7 +38,7 @@ public:
 
 private:
   enum class ControlMode : uint8_t { Auto = 0, Manual = 1, DeleteMenu = 2 };
-  enum class MenuScreen : uint8_t { None = 0, Slideshow, Source, AutoSpeed };
+  enum class MenuScreen : uint8_t { None = 0, Slideshow, Source, AutoSpeed, Grid };
   enum class DeleteState : uint8_t {
     Idle = 0,
     DeleteAllConfirm,
@@ -42,7 +48,7 @@ private:
     Done
   };
 
-  std::vector<String> files_;
+  std::vector<SlideFile> files_;
   size_t idx_ = 0;
   uint32_t timeSinceSwitch_ = 0;
   uint8_t dwellIdx_ = 1;  // 0=1s,1=5s,2=10s,3=30s,4=300s
@@ -53,7 +59,7 @@ private:
   SlideSource source_ = SlideSource::SDCard;
   bool manualFilenameActive_ = false;
   uint32_t manualFilenameUntil_ = 0;
-  String manualFilenameLabel_;
+  char manualFilenameLabel_[64] = {0};
   bool manualFilenameDirty_ = false;
   DeleteState deleteState_ = DeleteState::Idle;
   uint8_t deleteMenuSelection_ = 0;     // 0=Alle löschen, 1=Einzeln, 2=Exit
@@ -62,6 +68,7 @@ private:
   bool deleteConfirmDirty_ = true;
   uint32_t deleteSingleTimer_ = 0;
   String deleteCurrentFile_;
+  int16_t deleteCurrentSlot_ = -1;
   size_t deleteCount_ = 0;
   bool uiLocked_ = false;
   MenuScreen menuScreen_ = MenuScreen::None;
@@ -71,6 +78,10 @@ private:
   bool slideshowMenuDirty_ = false;
   bool sourceMenuDirty_ = false;
   bool autoSpeedMenuDirty_ = false;
+  size_t gridSelection_ = 0;
+  size_t gridShownSelection_ = 0;
+  uint8_t gridPaintNext_ = 0;  // next cell to paint on the current page
+  bool gridPageDirty_ = false;
   String helperLinePrimary_;
   String helperLineSecondary_;
   String helperLineTertiary_;
@@ -81,15 +92,12 @@ private:
   void setSource_(SlideSource src, bool showToast = true);
   void showCurrent_(bool allowManualOverlay = true, bool clearScreen = true);
   void showCurrentGif_(bool allowManualOverlay = true, bool clearScreen = true);
-  bool isJpeg_(const String& n);
-  bool isGif_(const String& n);
-  bool isMediaFile_(const String& n);
   void advance_(int step);
   void applyDwell_();
-  String dwellLabel_() const;
-  String modeLabel_() const;
-  String sourceLabel_() const;
-  String dwellToastLabel_() const;
+  const char* dwellLabel_() const;
+  const char* modeLabel_() const;
+  const char* sourceLabel_() const;
+  const char* dwellToastLabel_() const;
   void showToast_(const String& txt, uint32_t duration_ms);
   void drawToastOverlay_();
   void drawManualFilenameOverlay_();
@@ -101,7 +109,7 @@ private:
   void clearHelperOverlay_();
   bool rebuildFileList_();
   bool rebuildFileListFrom_(SlideSource src);
-  bool readDirectoryEntries_(fs::FS* fs, const String& basePath, std::vector<String>& out);
+  bool readDirectoryEntries_(fs::FS* fs, const String& basePath, std::vector<SlideFile>& out);
   bool ensureFlashReady_();
   bool ensureSdReady_();
   void openSlideshowMenu_();
@@ -114,7 +122,13 @@ private:
   void drawSlideshowMenu_();
   void drawSourceMenu_();
   void drawAutoSpeedMenu_();
-  String dwellOptionLabel_(uint8_t idx) const;
+  void openGrid_();
+  void closeGrid_(bool showSelection);
+  void handleGridButton_(BtnEvent e);
+  void drawGrid_();
+  void gridCellOrigin_(uint8_t cell, int16_t& x, int16_t& y) const;
+  void drawGridFrame_(size_t index, uint16_t color);
+  const char* dwellOptionLabel_(uint8_t idx) const;
   void enterDeleteMenu_();
   void exitDeleteMenu_();
   void requestDeleteAll_();
@@ -125,27 +139,76 @@ private:
   void confirmDeleteSingle_();
   void cancelDeleteSingle_();
   void performDeleteAll_();
-  void performDeleteSingle_(const String& path);
+  void performDeleteSingle_(const String& path, int16_t packSlot);
   void drawDeleteMenuOverlay_();
   void drawDeleteAllConfirmOverlay_();
   void drawDeleteSingleConfirmOverlay_();
   void markDeleteMenuDirty_();
   void markDeleteConfirmDirty_();
   void returnToSlideshowMenu_();
+  void runPreviewJob_(uint32_t windowMs);
+  void runPackCompaction_(uint32_t windowMs);
+  bool startKenBurns_(size_t index);
+  void renderKenBurnsFrame_();
+  void stopKenBurns_();
+
+  // Sidecar previews for oversized SD photos
+  SlidePreviewCache previewCache_;
+
+  // Thumbnail grid browser (manual mode)
+  ThumbnailCache thumbnails_;
+
+  // Ken Burns pan/zoom (region-of-interest decode per frame)
+  struct KenBurnsState {
+    bool active = false;
+    bool finished = false;
+    size_t index = 0;  // slide in files_
+    uint16_t imageW = 0;
+    uint16_t imageH = 0;
+    uint8_t startLevel = 0;  // index into the zoom level table
+    uint8_t endLevel = 0;
+    bool reverse = false;
+    uint32_t startedAt = 0;
+    uint32_t lastFrameAt = 0;
+  };
+  KenBurnsState kenBurns_;
 
   // GIF support
   AnimatedGIF gif_;
   bool gifPlaying_ = false;
-  String currentGifPath_;
+  size_t gifIndex_ = 0;  // slide in files_ while gifPlaying_
+  uint32_t gifNextFrameAt_ = 0;   // millis() deadline of the next frame
+  uint32_t gifFrameCount_ = 0;
+  uint32_t gifDroppedFrames_ = 0; // frame slots written off while running late
+  GifFrameCache gifFrameCache_;
+  size_t gifCacheBudget_ = 0;     // canvas mode records from the second loop on
+  GifCanvas gifCanvas_;
+  DeltaAnim anim_;                 // native .anm slides share the GIF playback state
   int gifOffsetX_ = 0;
   int gifOffsetY_ = 0;
   int gifCanvasW_ = 0;
   int gifCanvasH_ = 0;
-  int gifScale_ = 1;
+  int gifScale_ = 1;               // integer magnification, 1..3
+  int gifShrink_ = 1;              // 2: oversized canvas shown at half size
+  uint32_t gifStartedAt_ = 0;
+  // Canvas -> panel tables, rebuilt per GIF: first panel column/row of every
+  // canvas column/row (plus one past the end), clamped to the panel, and
+  // the canvas column sampled by every panel column
+  std::vector<int16_t> gifColStart_;
+  std::vector<int16_t> gifRowStart_;
+  uint16_t gifSrcColumn_[240];
+  void setupGifScale_(int canvasW, int canvasH);
   static void* gifOpen_(const char* fname, int32_t* pSize);
   static void gifClose_(void* pHandle);
   static int32_t gifRead_(GIFFILE* pFile, uint8_t* pBuf, int32_t iLen);
   static int32_t gifSeek_(GIFFILE* pFile, int32_t iPosition);
   static void gifDraw_(GIFDRAW* pDraw);
+  static void gifClearCanvas_();
+  static void gifPushRun_(int16_t x, int16_t y, const uint16_t* colors, uint16_t len);
+  static void gifRecordRun_(int16_t x, int16_t y, const uint16_t* colors, uint16_t len);
+  File openSlideFile_(const SlideFile& slide, uint32_t* size);
+  bool loadGifToRam_(const SlideFile& slide, int32_t* size);
+  static void freeGifBuffers_();
+  void playGifFrame_();
   void stopGif_();
 };
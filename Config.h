@@ -5,6 +5,11 @@
 // Uncomment to enable USB debug messages (costs ~3-5 KB Flash)
 #define USB_DEBUG
 
+// --- Flash Slides ---
+// Uncomment to store new flash slides (USB upload, SD copy) in /slides.pack
+// instead of single files in /slides. An existing pack is always shown.
+// #define FLASH_SLIDE_PACK
+
 // --- feste Pins (Board) ---
 inline constexpr int SPI_SCK_PIN   = 14;
 inline constexpr int SPI_MOSI_PIN  = 15;
@@ -10,6 +10,11 @@
 #include <cstdlib>
 
 #include "Storage.h"
+#include "ImageProbe.h"
+#include "SlideMeta.h"
+#include "UploadSink.h"
+#include "UploadResume.h"
+#include "HashCache.h"
 
 #include <FS.h>
 #include <LittleFS.h>
@@ -28,13 +33,15 @@ constexpr const char* kLuaScriptsDir     = "/scripts";
 
 struct TransferSession {
   bool active = false;
-  File file;
+  File file;           // "<path>.part" until END
+  String path;
   size_t expected = 0;
   size_t received = 0;
   size_t lastNotified = 0;
   uint32_t startedAt = 0;
   uint32_t lastActivity = 0;
   char filename[kFilenameCapacity];
+  ImageProbe probe;
 };
 
 QueueHandle_t gEventQueue = nullptr;
@@ -81,16 +88,12 @@ void sendStatus(const char* text) {
 }
 
 void cleanupFileOnError() {
-  if (!gSession.filename[0]) return;
-  const String flashPath = String(kFlashSlidesDir) + "/" + gSession.filename;
-  const String luaPath = String(kLuaScriptsDir) + "/" + gSession.filename;
-  const String rootPath = String("/") + gSession.filename;
-  const String candidates[] = {flashPath, luaPath, rootPath};
-  for (const auto& path : candidates) {
-    if (LittleFS.exists(path)) {
-      LittleFS.remove(path);
-    }
+  if (gSession.path.isEmpty()) return;
+  if (gSession.file) {
+    gSession.file.close();
   }
+  // Only the part file: an existing file of that name stays untouched
+  LittleFS.remove(gSession.path + kUploadPartSuffix);
 }
 
 void resetSession() {
@@ -98,6 +101,7 @@ void resetSession() {
     gSession.file.close();
   }
   gSession.file = File();
+  gSession.path = String();
   gSession.active = false;
   gSession.expected = 0;
   gSession.received = 0;
@@ -218,7 +222,7 @@ bool endsWithIgnoreCase(const String& value, const char* suffix) {
   return value.substring(value.length() - suffixLen).equalsIgnoreCase(suffix);
 }
 
-bool beginTransfer(size_t size, const std::string& requestedName) {
+bool beginTransfer(size_t size, const std::string& requestedName, bool resume = false) {
   if (!gTransfersEnabled) {
     sendStatus("ERR:DISABLED");
     postEvent(BleImageTransfer::EventType::Error, "", size, "BLE-Modus nicht aktiv");
@@ -282,7 +286,21 @@ bool beginTransfer(size_t size, const std::string& requestedName) {
     path += filename;
   }
 
-  gSession.file = LittleFS.open(path.c_str(), FILE_WRITE);
+  // RESUME continues the part file a dropped connection left behind
+  gSession.probe.begin(filename);
+  uint32_t resumeCrc = 0;
+  size_t offset = 0;
+  if (resume) {
+    offset = UploadResume::load(path, size, gSession.probe, &resumeCrc);
+  } else {
+    UploadResume::forget(path);
+  }
+  if (offset == 0) {
+    gSession.probe.begin(filename);
+  }
+
+  const String partPath = path + kUploadPartSuffix;
+  gSession.file = LittleFS.open(partPath.c_str(), offset ? FILE_APPEND : FILE_WRITE);
   if (!gSession.file) {
     sendStatus("ERR:OPEN");
     postEvent(BleImageTransfer::EventType::Error, filename, size, "Datei konnte nicht angelegt werden");
@@ -290,17 +308,26 @@ bool beginTransfer(size_t size, const std::string& requestedName) {
   }
 
   gSession.active = true;
+  gSession.path = path;
   gSession.expected = size;
-  gSession.received = 0;
-  gSession.lastNotified = 0;
+  gSession.received = offset;
+  gSession.lastNotified = offset;
   gSession.startedAt = millis();
   gSession.lastActivity = gSession.startedAt;
   std::snprintf(gSession.filename, sizeof(gSession.filename), "%s", filename);
 
   char status[80];
-  std::snprintf(status, sizeof(status), "OK:START:%s:%lu",
-                gSession.filename,
-                static_cast<unsigned long>(size));
+  if (resume) {
+    std::snprintf(status, sizeof(status), "OK:RESUME:%s:%lu:%lu:%08lx",
+                  gSession.filename,
+                  static_cast<unsigned long>(size),
+                  static_cast<unsigned long>(offset),
+                  static_cast<unsigned long>(resumeCrc));
+  } else {
+    std::snprintf(status, sizeof(status), "OK:START:%s:%lu",
+                  gSession.filename,
+                  static_cast<unsigned long>(size));
+  }
   sendStatus(status);
 
   char msg[96];
@@ -315,7 +342,7 @@ bool beginTransfer(size_t size, const std::string& requestedName) {
   return true;
 }
 
-void abortTransfer(const char* reason, BleImageTransfer::EventType evtType) {
+void abortTransfer(const char* reason, BleImageTransfer::EventType evtType, const char* detail = nullptr) {
   if (!gSession.active) return;
 
   cleanupFileOnError();
@@ -331,7 +358,7 @@ void abortTransfer(const char* reason, BleImageTransfer::EventType evtType) {
     sendStatus(status);
   }
 
-  postEvent(evtType, fname, received, reason ? reason : "");
+  postEvent(evtType, fname, received, detail ? detail : (reason ? reason : ""));
   #ifdef USB_DEBUG
     Serial.printf("[BLE] ABORT (%s) after %lu bytes\n",
                   reason ? reason : "no-reason",
@@ -339,6 +366,25 @@ void abortTransfer(const char* reason, BleImageTransfer::EventType evtType) {
   #endif
 }
 
+// Timeout or disconnect: keep the part file for RESUME
+void suspendTransfer(const char* reason) {
+  if (!gSession.active) return;
+  if (gSession.received > 0 && gSession.file) {
+    gSession.file.close();
+    gSession.file = File();
+    UploadResume::save(gSession.path, gSession.expected, gSession.received, gSession.probe.crc());
+    gSession.path = String();  // nothing left for cleanupFileOnError
+  }
+  abortTransfer(reason, BleImageTransfer::EventType::Aborted);
+}
+
+// Decoders could not show it: abort before END instead of failing at display time
+void rejectUnsupported() {
+  char detail[48];
+  std::snprintf(detail, sizeof(detail), "%s", gSession.probe.reason());
+  abortTransfer("FORMAT", BleImageTransfer::EventType::Error, detail);
+}
+
 void completeTransfer() {
   char fname[sizeof(gSession.filename)];
   std::snprintf(fname, sizeof(fname), "%s", gSession.filename);
@@ -346,6 +392,16 @@ void completeTransfer() {
 
   gSession.file.close();
   gSession.file = File();
+  if (!commitPartFile(gSession.path)) {
+    abortTransfer("FLASH", BleImageTransfer::EventType::Error);
+    return;
+  }
+  UploadResume::forget(gSession.path);
+  HashCache::remember(gSession.path, gSession.probe.crc());
+  if (gSession.probe.isMedia()) {
+    SlideMeta::record(fname, received, gSession.probe);
+  }
+  gSession.path = String();
   gSession.active = false;
   gSession.expected = 0;
   gSession.received = 0;
@@ -371,7 +427,8 @@ class ControlCallbacks : public BLECharacteristicCallbacks {
     String value = characteristic->getValue();
     if (value.length() == 0) return;
 
-    if (value.startsWith("START")) {
+    const bool resume = value.startsWith("RESUME");
+    if (resume || value.startsWith("START")) {
       int first = value.indexOf(':');
       if (first < 0 || first + 1 >= value.length()) {
         sendStatus("ERR:STRTFMT");
@@ -384,7 +441,7 @@ class ControlCallbacks : public BLECharacteristicCallbacks {
       String namePart = (second >= 0 && second + 1 < value.length())
                         ? value.substring(second + 1)
                         : String();
-      beginTransfer(sz, std::string(namePart.c_str()));
+      beginTransfer(sz, std::string(namePart.c_str()), resume);
     } else if (value.equals("END")) {
       if (!gSession.active) {
         sendStatus("ERR:NOACTIVE");
@@ -394,6 +451,10 @@ class ControlCallbacks : public BLECharacteristicCallbacks {
         abortTransfer("INCOMPLETE", BleImageTransfer::EventType::Error);
         return;
       }
+      if (gSession.probe.finish() == ImageProbe::Verdict::Unsupported) {
+        rejectUnsupported();
+        return;
+      }
       completeTransfer();
     } else if (value.equals("ABORT")) {
       if (!gSession.active) {
@@ -438,6 +499,10 @@ class ChunkCallbacks : public BLECharacteristicCallbacks {
 
     gSession.received += len;
     gSession.lastActivity = millis();
+    if (gSession.probe.feed(data, len) == ImageProbe::Verdict::Unsupported) {
+      rejectUnsupported();
+      return;
+    }
 
     if (gSession.expected > 0) {
       size_t notifyStep = std::max<size_t>(gSession.expected / 10, 4096);
@@ -465,7 +530,7 @@ class ServerCallbacks : public BLEServerCallbacks {
       Serial.println("[BLE] central disconnected");
     #endif
     if (gSession.active) {
-      abortTransfer("DISCONNECT", BleImageTransfer::EventType::Aborted);
+      suspendTransfer("DISCONNECT");
     }
     BLEDevice::startAdvertising();
   }
@@ -527,7 +592,7 @@ void tick() {
   if (!gSession.active) return;
   uint32_t now = millis();
   if (now - gSession.lastActivity > kTransferTimeoutMs) {
-    abortTransfer("TIMEOUT", EventType::Aborted);
+    suspendTransfer("TIMEOUT");
   }
 }
 
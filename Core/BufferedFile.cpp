@@ -0,0 +1,139 @@
+#include "BufferedFile.h"
+#include "Config.h"
+
+#include <SD.h>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+namespace {
+uint8_t* bufferedShared = nullptr;  // kept across slides once allocated
+bool bufferedSharedBusy = false;
+
+class BufferedFileImpl : public fs::FileImpl {
+ public:
+  explicit BufferedFileImpl(File inner) : inner_(inner), pos_(inner.position()) {
+    if (!bufferedSharedBusy) {
+      if (!bufferedShared) {
+        bufferedShared = static_cast<uint8_t*>(malloc(kBufferedWindowBytes));
+      }
+      if (bufferedShared) {
+        window_ = bufferedShared;
+        bufferedSharedBusy = true;
+        return;
+      }
+    }
+    window_ = static_cast<uint8_t*>(malloc(kBufferedWindowBytes));
+    ownsWindow_ = window_ != nullptr;
+  }
+
+  ~BufferedFileImpl() override { close(); }
+
+  size_t read(uint8_t* buf, size_t size) override {
+    if (!inner_) return 0;
+    if (!window_) {
+      // No memory for a window: plain reads
+      if (inner_.position() != pos_ && !inner_.seek(pos_)) {
+        return 0;
+      }
+      const size_t n = inner_.read(buf, size);
+      pos_ += n;
+      return n;
+    }
+
+    size_t done = 0;
+    while (done < size) {
+      if (pos_ < windowStart_ || pos_ >= windowStart_ + windowLen_) {
+        // Refill from the start of the sector holding pos_
+        windowStart_ = pos_ & ~static_cast<uint32_t>(kBufferedSectorBytes - 1);
+        windowLen_ = inner_.seek(windowStart_) ? inner_.read(window_, kBufferedWindowBytes) : 0;
+        if (pos_ >= windowStart_ + windowLen_) {
+          windowLen_ = 0;
+          break;
+        }
+      }
+      const size_t n = std::min<size_t>(size - done, windowStart_ + windowLen_ - pos_);
+      if (buf) {
+        memcpy(buf + done, window_ + (pos_ - windowStart_), n);
+      }
+      done += n;
+      pos_ += n;
+    }
+    return done;
+  }
+
+  bool seek(uint32_t pos, SeekMode mode) override {
+    if (!inner_) return false;
+    uint32_t target = pos;
+    if (mode == SeekCur) {
+      target = pos_ + pos;
+    } else if (mode == SeekEnd) {
+      target = inner_.size() - pos;
+    }
+    if (target > inner_.size()) {
+      return false;
+    }
+    pos_ = target;  // the next read refills if needed
+    return true;
+  }
+
+  size_t position() const override { return pos_; }
+  size_t size() const override { return inner_.size(); }
+
+  void close() override {
+    if (inner_) {
+      inner_.close();
+    }
+    if (window_ == bufferedShared) {
+      bufferedSharedBusy = false;
+    } else if (ownsWindow_) {
+      free(window_);
+    }
+    window_ = nullptr;
+    ownsWindow_ = false;
+    windowStart_ = 0;
+    windowLen_ = 0;
+  }
+
+  time_t getLastWrite() override { return inner_.getLastWrite(); }
+  const char* path() const override { return inner_.path(); }
+  const char* name() const override { return inner_.name(); }
+
+  // Read-only regular file
+  size_t write(const uint8_t* buf, size_t size) override { return 0; }
+  void flush() override {}
+  bool setBufferSize(size_t size) override { return false; }
+  boolean isDirectory(void) override { return false; }
+  fs::FileImplPtr openNextFile(const char* mode) override { return fs::FileImplPtr(); }
+  boolean seekDir(long position) override { return false; }
+  String getNextFileName(void) override { return String(); }
+  String getNextFileName(bool* isDir) override { return String(); }
+  void rewindDirectory(void) override {}
+  operator bool() override { return static_cast<bool>(inner_); }
+
+ private:
+  File inner_;
+  uint32_t pos_ = 0;
+  uint8_t* window_ = nullptr;
+  bool ownsWindow_ = false;
+  uint32_t windowStart_ = 0;  // offset of the window in the underlying file
+  uint32_t windowLen_ = 0;
+};
+}
+
+File openBuffered(File inner) {
+  if (!inner) {
+    return inner;
+  }
+  return File(std::make_shared<BufferedFileImpl>(inner));
+}
+
+JRESULT drawSdJpgBuffered(int32_t x, int32_t y, const char* path) {
+  File f = openBuffered(SD.open(path, FILE_READ));
+  return f ? TJpgDec.drawFsJpg(x, y, f) : JDR_INP;
+}
+
+JRESULT getSdJpgSizeBuffered(uint16_t* w, uint16_t* h, const char* path) {
+  File f = openBuffered(SD.open(path, FILE_READ));
+  return f ? TJpgDec.getFsJpgSize(w, h, f) : JDR_INP;
+}
@@ -0,0 +1,32 @@
+#ifndef BUFFEREDFILE_H
+#define BUFFEREDFILE_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <TJpg_Decoder.h>
+
+/**
+ * Read-ahead input for the image decoders
+ *
+ * TJpgDec refills its input buffer a few hundred bytes at a time and the
+ * GIF decoder reads one LZW block at a time; every such read is a File
+ * call, on SD a separate card command. openBuffered() wraps a readable
+ * File in a window of kBufferedWindowBytes that always starts on a
+ * 512-byte sector boundary of the underlying file, so FatFs can read
+ * whole sectors straight into it and LittleFS gets few large reads.
+ *
+ * The window memory is allocated once and reused by every decode; a
+ * second file buffered at the same time gets its own window, and without
+ * memory the wrapper just passes reads through. Seeks inside the window
+ * are free, which also covers GIF loop restarts of small files.
+ */
+constexpr size_t kBufferedWindowBytes = 8192;
+constexpr size_t kBufferedSectorBytes = 512;
+
+File openBuffered(File inner);
+
+// TJpgDec SD decodes through the read-ahead window
+JRESULT drawSdJpgBuffered(int32_t x, int32_t y, const char* path);
+JRESULT getSdJpgSizeBuffered(uint16_t* w, uint16_t* h, const char* path);
+
+#endif // BUFFEREDFILE_H
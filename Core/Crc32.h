@@ -0,0 +1,13 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <Arduino.h>
+
+/**
+ * CRC-32 as used by zlib, PNG and Python's zlib.crc32 (reflected, poly
+ * 0xEDB88320), so host tools can check what the brooch reports. Start with
+ * crc = 0 and feed the data in any number of pieces.
+ */
+uint32_t crc32Update(uint32_t crc, const void* data, size_t len);
+
+#endif // CRC32_H
@@ -0,0 +1,149 @@
+#include "DeltaAnim.h"
+#include "Gfx.h"
+#include "Config.h"
+#include <algorithm>
+
+namespace {
+inline uint16_t animLe16(const uint8_t* p) {
+  return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+inline uint32_t animLe32(const uint8_t* p) {
+  return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+         (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+}
+
+bool DeltaAnim::open(File file) {
+  close();
+  if (!file) {
+    return false;
+  }
+  file_ = file;
+  base_ = file_.position();
+
+  uint8_t header[kHeaderSize];
+  if (!readExact_(header, sizeof(header)) || animLe32(header) != kMagic) {
+    close();
+    return false;
+  }
+  width_ = animLe16(header + 4);
+  height_ = animLe16(header + 6);
+  frameCount_ = animLe16(header + 8);
+  indexOffset_ = animLe32(header + 12);
+  if (width_ == 0 || height_ == 0 || width_ > TFT_W || height_ > TFT_H || frameCount_ == 0) {
+    #ifdef USB_DEBUG
+      Serial.printf("[Anim] unsupported: %ux%u, %u frames\n", width_, height_, frameCount_);
+    #endif
+    close();
+    return false;
+  }
+  offsetX_ = (TFT_W - width_) / 2;
+  offsetY_ = (TFT_H - height_) / 2;
+
+  if (!seekFrame(0)) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+void DeltaAnim::close() {
+  if (file_) {
+    file_.close();
+  }
+  file_ = File();
+  width_ = 0;
+  height_ = 0;
+  frameCount_ = 0;
+  nextFrame_ = 0;
+}
+
+bool DeltaAnim::readExact_(void* dst, size_t len) {
+  return file_.read(static_cast<uint8_t*>(dst), len) == len;
+}
+
+bool DeltaAnim::seekFrame(uint16_t frame) {
+  if (!file_ || frame >= frameCount_) {
+    return false;
+  }
+  uint8_t raw[4];
+  if (!file_.seek(base_ + indexOffset_ + frame * 4u) || !readExact_(raw, sizeof(raw))) {
+    return false;
+  }
+  nextFrame_ = frame;
+  return file_.seek(base_ + animLe32(raw));
+}
+
+int DeltaAnim::playFrame(int* delayMs) {
+  if (!file_) return -1;
+
+  uint8_t header[4];
+  if (!readExact_(header, sizeof(header))) {
+    return -1;
+  }
+  if (delayMs) {
+    *delayMs = animLe16(header);
+  }
+  const uint16_t rects = animLe16(header + 2);
+  for (uint16_t i = 0; i < rects; i++) {
+    if (!drawRect_()) {
+      #ifdef USB_DEBUG
+        Serial.printf("[Anim] frame %u: bad rect %u\n", nextFrame_, i);
+      #endif
+      return -1;
+    }
+  }
+
+  // Frames are stored back to back; only the loop needs the index
+  return (++nextFrame_ < frameCount_) ? 1 : 0;
+}
+
+bool DeltaAnim::drawRect_() {
+  uint8_t raw[12];
+  if (!readExact_(raw, sizeof(raw))) {
+    return false;
+  }
+  const uint16_t x = animLe16(raw);
+  const uint16_t y = animLe16(raw + 2);
+  const uint16_t w = animLe16(raw + 4);
+  const uint16_t h = animLe16(raw + 6);
+  if (w == 0 || h == 0 || x + w > width_ || y + h > height_) {
+    return false;
+  }
+
+  // One address window per rect; packets run across its rows
+  tft.setAddrWindow(offsetX_ + x, offsetY_ + y, w, h);
+  uint32_t remaining = static_cast<uint32_t>(w) * h;
+  while (remaining > 0) {
+    uint8_t packet[2];
+    if (!readExact_(packet, sizeof(packet))) {
+      return false;
+    }
+    const uint16_t tag = animLe16(packet);
+    const uint16_t count = tag & ~kRepeatFlag;
+    if (count == 0 || count > remaining) {
+      return false;
+    }
+    if (tag & kRepeatFlag) {
+      uint8_t color[2];
+      if (!readExact_(color, sizeof(color))) {
+        return false;
+      }
+      tft.pushBlock(static_cast<uint16_t>((color[0] << 8) | color[1]), count);
+    } else {
+      // Already in panel byte order: read and push, no conversion
+      uint16_t left = count;
+      while (left > 0) {
+        const uint16_t n = std::min<uint16_t>(left, kBufferPixels);
+        if (!readExact_(buffer_, n * sizeof(uint16_t))) {
+          return false;
+        }
+        tft.pushPixels(buffer_, n);
+        left -= n;
+      }
+    }
+    remaining -= count;
+  }
+  return true;
+}
@@ -0,0 +1,83 @@
+#ifndef DELTAANIM_H
+#define DELTAANIM_H
+
+#include <Arduino.h>
+#include <FS.h>
+
+/**
+ * DeltaAnim - player for the native .anm animation format
+ *
+ * Written by the GIF-Aufbereiter as an alternative to GIF: full RGB565
+ * colour, no LZW, and every frame only carries the rectangles that changed
+ * since the previous one. All integers are little-endian, pixels are
+ * RGB565 high byte first (panel byte order), so literal pixel data goes
+ * from the file to the panel without being touched.
+ *
+ *   Header (24 bytes)
+ *     char[4]  magic "ANM1"
+ *     u16      width, height        (at most the panel size)
+ *     u16      frameCount
+ *     u16      loopCount            (0 = endless, informational)
+ *     u32      indexOffset          (frameCount x u32 frame offsets)
+ *     u32      reserved[2]
+ *   Frame
+ *     u16      delayMs
+ *     u16      rectCount
+ *     rect[]   u16 x, y, w, h; u32 dataBytes; packets
+ *   Packets fill the rect row by row, across row ends:
+ *     u16 0x8000 | n, u16 colour    n pixels of one colour
+ *     u16 n, n x u16 colours        n literal pixels
+ *
+ * Frame 0 is a key frame covering the whole picture, so playback can
+ * start or loop back to it from any state.
+ */
+class DeltaAnim {
+ public:
+  static constexpr uint32_t kMagic = 0x314D4E41;  // "ANM1"
+  static constexpr size_t kHeaderSize = 24;
+
+  /**
+   * Take over an open file positioned at the animation's first byte (flash
+   * slide pack handles start mid-file) and draw it centred on the panel.
+   */
+  bool open(File file);
+  void close();
+  bool isOpen() const { return file_; }
+
+  uint16_t width() const { return width_; }
+  uint16_t height() const { return height_; }
+  uint16_t frameCount() const { return frameCount_; }
+
+  /**
+   * Draw the next frame inside an open SPI transaction. Returns 1 if more
+   * frames follow, 0 after the last frame and -1 on a read or format
+   * error, like AnimatedGIF::playFrame.
+   */
+  int playFrame(int* delayMs);
+
+  /**
+   * Continue with the given frame; frame 0 restarts the loop.
+   */
+  bool seekFrame(uint16_t frame);
+
+ private:
+  static constexpr size_t kBufferPixels = 512;
+  static constexpr uint16_t kRepeatFlag = 0x8000;
+
+  bool readExact_(void* dst, size_t len);
+  bool drawRect_();
+
+  File file_;
+  uint32_t base_ = 0;
+  uint16_t width_ = 0;
+  uint16_t height_ = 0;
+  uint16_t frameCount_ = 0;
+  uint32_t indexOffset_ = 0;
+  uint16_t nextFrame_ = 0;
+  int16_t offsetX_ = 0;
+  int16_t offsetY_ = 0;
+
+  uint16_t buffer_[kBufferPixels];
+};
+
+#endif // DELTAANIM_H
@@ -0,0 +1,119 @@
+#include "DeltaSync.h"
+
+#include <algorithm>
+
+uint32_t deltaWeakSum(const uint8_t* data, size_t len) {
+  uint32_t a = 0;
+  uint32_t b = 0;
+  for (size_t i = 0; i < len; ++i) {
+    a += data[i];
+    b += static_cast<uint32_t>(len - i) * data[i];
+  }
+  return (a & 0xFFFF) | ((b & 0xFFFF) << 16);
+}
+
+bool DeltaDecoder::begin(File source, size_t blockSize, Emit emit, void* ctx) {
+  end();
+  if (!source || blockSize < kDeltaMinBlock || blockSize > kDeltaMaxBlock) {
+    if (source) {
+      source.close();
+    }
+    return false;
+  }
+  source_ = source;
+  sourceSize_ = source_.size();
+  blockSize_ = blockSize;
+  produced_ = 0;
+  headerGot_ = 0;
+  literalLeft_ = 0;
+  field_ = Field::Op;
+  emit_ = emit;
+  ctx_ = ctx;
+  return true;
+}
+
+void DeltaDecoder::end() {
+  if (source_) {
+    source_.close();
+  }
+  source_ = File();
+  emit_ = nullptr;
+  ctx_ = nullptr;
+}
+
+bool DeltaDecoder::copy_(uint32_t block, uint16_t count) {
+  const size_t start = static_cast<size_t>(block) * blockSize_;
+  if (count == 0 || block >= (sourceSize_ + blockSize_ - 1) / blockSize_ || !source_.seek(start)) {
+    return false;
+  }
+  // The last block of the old file may be short
+  size_t left = std::min(static_cast<size_t>(count) * blockSize_, sourceSize_ - start);
+  while (left > 0) {
+    const size_t n = source_.read(buf_, std::min(sizeof(buf_), left));
+    if (n == 0) {
+      return false;
+    }
+    produced_ += n;
+    if (!emit_(ctx_, buf_, n)) {
+      return false;
+    }
+    left -= n;
+  }
+  return true;
+}
+
+bool DeltaDecoder::feed(const uint8_t* data, size_t len) {
+  if (!source_ || !emit_) {
+    return false;
+  }
+  size_t i = 0;
+  while (i < len) {
+    switch (field_) {
+      case Field::Op:
+        op_ = data[i++];
+        if (op_ != kDeltaLiteral && op_ != kDeltaCopy) {
+          return false;
+        }
+        headerGot_ = 0;
+        field_ = Field::Header;
+        break;
+
+      case Field::Header: {
+        const uint8_t need = (op_ == kDeltaLiteral) ? 2 : 6;
+        header_[headerGot_++] = data[i++];
+        if (headerGot_ < need) {
+          break;
+        }
+        if (op_ == kDeltaLiteral) {
+          literalLeft_ = static_cast<uint16_t>(header_[0] | (header_[1] << 8));
+          field_ = literalLeft_ ? Field::Literal : Field::Op;
+          break;
+        }
+        const uint32_t block = static_cast<uint32_t>(header_[0]) | (static_cast<uint32_t>(header_[1]) << 8) |
+                               (static_cast<uint32_t>(header_[2]) << 16) |
+                               (static_cast<uint32_t>(header_[3]) << 24);
+        if (!copy_(block, static_cast<uint16_t>(header_[4] | (header_[5] << 8)))) {
+          return false;
+        }
+        field_ = Field::Op;
+        break;
+      }
+
+      case Field::Literal: {
+        // Literal bytes go out straight from the input
+        const size_t n = std::min<size_t>(literalLeft_, len - i);
+        produced_ += n;
+        if (!emit_(ctx_, data + i, n)) {
+          return false;
+        }
+        literalLeft_ -= n;
+        i += n;
+        if (literalLeft_ == 0) {
+          field_ = Field::Op;
+        }
+        break;
+      }
+    }
+  }
+  return true;
+}
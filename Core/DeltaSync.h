@@ -0,0 +1,77 @@
+#ifndef DELTASYNC_H
+#define DELTASYNC_H
+
+#include <Arduino.h>
+#include <FS.h>
+
+/**
+ * Block-level delta uploads (SIGS / DELTA)
+ *
+ * rsync-style: the device splits the file it already has into blocks of a
+ * size chosen by the host and reports a weak rolling sum and a CRC-32 for
+ * each (SIGS). The host looks for those blocks at every offset of the new
+ * version and sends only a stream of operations:
+ *
+ *   'L' <u16 len> <len literal bytes>
+ *   'C' <u32 first block> <u16 block count>   copy from the old file
+ *
+ * (little endian). The decoder replays the stream against the old file and
+ * hands the new version on in pieces; the receiver writes it to the .part
+ * file and renames that over the old one. The host encoder is
+ * tools/usb_protocol.py (make_delta).
+ */
+constexpr uint8_t kDeltaLiteral = 'L';
+constexpr uint8_t kDeltaCopy = 'C';
+constexpr size_t kDeltaMinBlock = 64;
+constexpr size_t kDeltaMaxBlock = 2048;
+
+/**
+ * rsync's weak sum of one block: a = sum of the bytes, b = sum of
+ * (len - i) * byte[i], both mod 2^16, packed as a | b << 16. The host can
+ * roll it forward one byte at a time.
+ */
+uint32_t deltaWeakSum(const uint8_t* data, size_t len);
+
+class DeltaDecoder {
+ public:
+  // Output sink; returning false stops the decoder with an error
+  using Emit = bool (*)(void* ctx, const uint8_t* data, size_t len);
+
+  ~DeltaDecoder() { end(); }
+
+  // Takes over source (the old version, opened for reading)
+  bool begin(File source, size_t blockSize, Emit emit, void* ctx);
+  // Closes the old version; call before the new one replaces it
+  void end();
+
+  /**
+   * Decode len delta bytes. False on a corrupt stream (unknown operation,
+   * copy past the end of the old file), a read error, or when emit refused
+   * the output.
+   */
+  bool feed(const uint8_t* data, size_t len);
+
+  size_t produced() const { return produced_; }
+
+ private:
+  enum class Field : uint8_t { Op = 0, Header, Literal };
+
+  bool copy_(uint32_t block, uint16_t count);
+
+  static constexpr size_t kCopyChunk = 512;
+
+  File source_;
+  size_t sourceSize_ = 0;
+  size_t blockSize_ = 0;
+  uint8_t buf_[kCopyChunk];
+  size_t produced_ = 0;
+  uint8_t op_ = 0;
+  uint8_t header_[6];      // operation arguments
+  uint8_t headerGot_ = 0;
+  uint16_t literalLeft_ = 0;
+  Field field_ = Field::Op;
+  Emit emit_ = nullptr;
+  void* ctx_ = nullptr;
+};
+
+#endif // DELTASYNC_H
@@ -4,12 +4,81 @@
 TFT_eSPI tft;
 SPIClass sdSPI(VSPI);
 
-static bool tft_output_cb(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t* bitmap) {
+namespace {
+struct JpegView {
+  bool active = false;
+  int16_t x = 0;
+  int16_t y = 0;
+  uint8_t upscale = 1;
+};
+JpegView jpegView;
+
+bool pushViewBlock(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t* bitmap) {
+  const int16_t up = jpegView.upscale;
+  const int16_t viewW = (tft.width() + up - 1) / up;
+  const int16_t viewH = (tft.height() + up - 1) / up;
+  const int16_t vx = x - jpegView.x;
+  const int16_t vy = y - jpegView.y;
+
+  // MCU rows arrive top to bottom: nothing below the view is needed anymore
+  if (vy >= viewH) return false;
+  if (vy + h <= 0 || vx >= viewW || vx + w <= 0) return true;
+
+  if (up == 1) {
+    tft.pushImage(vx, vy, w, h, bitmap);  // pushImage clips to the panel
+    return true;
+  }
+
+  const int16_t c0 = max<int16_t>(0, -vx);
+  const int16_t c1 = min<int16_t>(w, viewW - vx);
+  const int16_t r0 = max<int16_t>(0, -vy);
+  const int16_t r1 = min<int16_t>(h, viewH - vy);
+
+  uint16_t line[16 * kGfxJpegMaxUpscale];  // one MCU row, magnified
+  const int16_t maxCols = sizeof(line) / sizeof(line[0]) / up;
+  for (int16_t r = r0; r < r1; ++r) {
+    const uint16_t* src = bitmap + r * w;
+    for (int16_t cs = c0; cs < c1; cs += maxCols) {
+      const int16_t ce = min<int16_t>(c1, cs + maxCols);
+      int16_t out = 0;
+      for (int16_t c = cs; c < ce; ++c) {
+        for (int16_t k = 0; k < up; ++k) {
+          line[out++] = src[c];
+        }
+      }
+      const int16_t segX = (vx + cs) * up;
+      const int16_t segW = min<int16_t>(out, tft.width() - segX);
+      if (segW <= 0) break;
+      for (int16_t k = 0; k < up; ++k) {
+        const int16_t dstY = (vy + r) * up + k;
+        if (dstY >= tft.height()) break;
+        tft.setAddrWindow(segX, dstY, segW, 1);
+        tft.pushPixels(line, segW);
+      }
+    }
+  }
+  return true;
+}
+}
+
+bool gfxJpegOutput(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t* bitmap) {
+  if (jpegView.active) return pushViewBlock(x, y, w, h, bitmap);
   if (x >= tft.width() || y >= tft.height()) return false;
   tft.pushImage(x, y, w, h, bitmap);
   return true;
 }
 
+void gfxJpegSetView(int16_t srcX, int16_t srcY, uint8_t upscale) {
+  jpegView.active = true;
+  jpegView.x = srcX;
+  jpegView.y = srcY;
+  jpegView.upscale = constrain(upscale, 1, kGfxJpegMaxUpscale);
+}
+
+void gfxJpegClearView() {
+  jpegView = JpegView();
+}
+
 void gfxBegin() {
   // CS-Leitungen sicher HIGH
   pinMode(TFT_CS_PIN, OUTPUT); digitalWrite(TFT_CS_PIN, HIGH);
@@ -54,7 +123,7 @@ void gfxBegin() {
   TextRenderer::begin();
 
   // JPEG-Decoder (nach TFT, aber unabhängig vom SD-Init)
-  TJpgDec.setCallback(tft_output_cb);
+  TJpgDec.setCallback(gfxJpegOutput);
   TJpgDec.setSwapBytes(true);
 
   #ifdef USB_DEBUG
@@ -19,4 +19,16 @@ extern SPIClass sdSPI;
 
 void gfxBegin();
 
+// Default TJpgDec output: pushes decoded blocks straight to the panel.
+// Modules that temporarily redirect the decoder restore this afterwards.
+bool gfxJpegOutput(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t* bitmap);
+
+// Region-of-interest decode for gfxJpegOutput. While a view is set, decoder
+// coordinates are image coordinates: blocks outside the panel-sized window
+// at (srcX, srcY) are dropped, visible ones are magnified by `upscale`, and
+// the decode is interrupted (JDR_INTR) once it passes the bottom edge.
+constexpr uint8_t kGfxJpegMaxUpscale = 3;
+void gfxJpegSetView(int16_t srcX, int16_t srcY, uint8_t upscale);
+void gfxJpegClearView();
+
 #endif // CORE_GFX_H
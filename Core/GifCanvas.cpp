@@ -0,0 +1,345 @@
+#include "GifCanvas.h"
+#include "Gfx.h"
+#include "Config.h"
+#include <algorithm>
+
+namespace {
+constexpr uint16_t kCanvasBackground = 0x0000;  // black, same in either byte order
+
+// Palette entries are RGB565 in panel (big-endian) byte order
+inline uint16_t canvasColorToHost(uint16_t c) {
+  return static_cast<uint16_t>((c >> 8) | (c << 8));
+}
+}
+
+bool GifCanvas::begin(int16_t width, int16_t height, int scale, int offsetX, int offsetY) {
+  end();
+  if (width <= 0 || height <= 0 || scale <= 0 ||
+      static_cast<size_t>(width) * static_cast<size_t>(height) > kMaxPixels) {
+    return false;
+  }
+
+  const size_t pixels = static_cast<size_t>(width) * static_cast<size_t>(height);
+  pixels_ = static_cast<uint8_t*>(malloc(pixels));
+  if (!pixels_) {
+    return false;
+  }
+  // The screen was just cleared, so a blank canvas matches the panel
+  memset(pixels_, 0, pixels);
+
+  width_ = width;
+  height_ = height;
+  scale_ = scale;
+  offsetX_ = offsetX;
+  offsetY_ = offsetY;
+  dirtyX0_.assign(height_, width_);
+  dirtyX1_.assign(height_, 0);
+
+  // Only canvas pixels that land completely on the panel are pushed
+  visX0_ = static_cast<int16_t>(std::max(0, (-offsetX + scale - 1) / scale));
+  visX1_ = static_cast<int16_t>(std::min<int>(width_, (TFT_W - offsetX) / scale));
+  visY0_ = static_cast<int16_t>(std::max(0, (-offsetY + scale - 1) / scale));
+  visY1_ = static_cast<int16_t>(std::min<int>(height_, (TFT_H - offsetY) / scale));
+
+  resetPalette_();
+  framePaletteValid_ = false;
+  compareColors_ = false;
+  frameStarted_ = false;
+  disposeActive_ = false;
+  disposePending_ = false;
+  return true;
+}
+
+void GifCanvas::end() {
+  free(pixels_);
+  pixels_ = nullptr;
+  width_ = 0;
+  height_ = 0;
+  dirtyX0_.clear();
+  dirtyX0_.shrink_to_fit();
+  dirtyX1_.clear();
+  dirtyX1_.shrink_to_fit();
+}
+
+void GifCanvas::resetPalette_() {
+  std::fill(slotLive_, slotLive_ + 256, false);
+  palette_[0] = kCanvasBackground;
+  slotLive_[0] = true;
+  paletteUsed_ = 1;
+  freeCount_ = 0;
+}
+
+GifCanvas::Rect GifCanvas::clip_(const Rect& r) const {
+  Rect out;
+  const int16_t x0 = std::max<int16_t>(r.x, 0);
+  const int16_t y0 = std::max<int16_t>(r.y, 0);
+  const int16_t x1 = std::min<int16_t>(r.x + r.w, width_);
+  const int16_t y1 = std::min<int16_t>(r.y + r.h, height_);
+  if (x1 > x0 && y1 > y0) {
+    out.x = x0;
+    out.y = y0;
+    out.w = x1 - x0;
+    out.h = y1 - y0;
+  }
+  return out;
+}
+
+void GifCanvas::startFrame_(GIFDRAW* pDraw) {
+  frameStarted_ = true;
+  freeScanned_ = false;
+  frameRect_.x = pDraw->iX;
+  frameRect_.y = pDraw->iY;
+  frameRect_.w = pDraw->iWidth;
+  frameRect_.h = pDraw->iHeight;
+  frameTransparent_ = pDraw->ucHasTransparency;
+  transparentIndex_ = pDraw->ucTransparent;
+  frameDisposal_ = pDraw->ucDisposalMethod;
+
+  // The previous frame's "restore to background" is applied while this one
+  // is composited, so pixels that end up unchanged are never pushed
+  disposeActive_ = disposePending_;
+  disposeRect_ = clip_(pendingRect_);
+  disposePending_ = false;
+
+  const bool covers = frameRect_.x <= 0 && frameRect_.y <= 0 &&
+                      frameRect_.x + frameRect_.w >= width_ &&
+                      frameRect_.y + frameRect_.h >= height_;
+  const bool disposeCovers = disposeActive_ && disposeRect_.w == width_ &&
+                             disposeRect_.h == height_;
+  if (covers && (!frameTransparent_ || disposeCovers)) {
+    // Every pixel gets rewritten: start a fresh canvas palette instead of
+    // accumulating colours, and detect changes by colour for this frame
+    memcpy(previousPalette_, palette_, sizeof(palette_));
+    compareColors_ = true;
+    resetPalette_();
+    framePaletteValid_ = false;
+  }
+
+  if (!framePaletteValid_ ||
+      memcmp(framePalette_, pDraw->pPalette, sizeof(framePalette_)) != 0) {
+    memcpy(framePalette_, pDraw->pPalette, sizeof(framePalette_));
+    std::fill(remap_, remap_ + 256, kUnmapped);
+    framePaletteValid_ = true;
+  }
+}
+
+void GifCanvas::drawRow(GIFDRAW* pDraw) {
+  if (!pixels_) return;
+  if (pDraw->y == 0 || !frameStarted_) {
+    startFrame_(pDraw);
+  }
+
+  const int16_t y = pDraw->iY + pDraw->y;
+  if (y < 0 || y >= height_) return;
+
+  uint8_t* row = pixels_ + static_cast<size_t>(y) * width_;
+  const bool inDispose = disposeActive_ && y >= disposeRect_.y &&
+                         y < disposeRect_.y + disposeRect_.h;
+  const uint8_t* s = pDraw->pPixels;
+  int16_t x = pDraw->iX;
+  for (int i = 0; i < pDraw->iWidth; i++, x++) {
+    if (x < 0 || x >= width_) continue;
+    const uint8_t px = s[i];
+    if (frameTransparent_ && px == transparentIndex_) {
+      // Transparent shows what lies below: the background inside the
+      // disposed area, the previous picture everywhere else
+      if (inDispose && x >= disposeRect_.x && x < disposeRect_.x + disposeRect_.w) {
+        setPixel_(row, x, y, 0);
+      }
+      continue;
+    }
+    setPixel_(row, x, y, colorIndex_(px));
+  }
+}
+
+void GifCanvas::setPixel_(uint8_t* row, int16_t x, int16_t y, uint8_t idx) {
+  const uint8_t old = row[x];
+  const bool changed = compareColors_ ? previousPalette_[old] != palette_[idx] : old != idx;
+  row[x] = idx;
+  if (changed) {
+    if (x < dirtyX0_[y]) dirtyX0_[y] = x;
+    if (x + 1 > dirtyX1_[y]) dirtyX1_[y] = x + 1;
+  }
+}
+
+uint8_t GifCanvas::colorIndex_(uint8_t frameIndex) {
+  if (remap_[frameIndex] == kUnmapped) {
+    remap_[frameIndex] = findOrInsert_(framePalette_[frameIndex]);
+  }
+  return static_cast<uint8_t>(remap_[frameIndex]);
+}
+
+uint8_t GifCanvas::findOrInsert_(uint16_t color) {
+  for (uint16_t i = 0; i < paletteUsed_; i++) {
+    if (slotLive_[i] && palette_[i] == color) {
+      return static_cast<uint8_t>(i);
+    }
+  }
+
+  uint8_t slot = 0;
+  if (paletteUsed_ < 256) {
+    slot = static_cast<uint8_t>(paletteUsed_++);
+  } else if (freeCount_ > 0 || collectFreeSlots_()) {
+    slot = freeSlots_[--freeCount_];
+  } else {
+    return nearest_(color);
+  }
+  palette_[slot] = color;
+  slotLive_[slot] = true;
+  return slot;
+}
+
+bool GifCanvas::collectFreeSlots_() {
+  // At most one scan per frame; it finds nothing new until pixels change
+  if (freeScanned_) return false;
+  freeScanned_ = true;
+
+  bool used[256] = {};
+  used[0] = true;
+  const size_t pixels = static_cast<size_t>(width_) * static_cast<size_t>(height_);
+  for (size_t i = 0; i < pixels; i++) {
+    used[pixels_[i]] = true;
+  }
+  for (uint16_t i = 0; i < 256; i++) {
+    if (remap_[i] != kUnmapped) {
+      used[remap_[i]] = true;
+    }
+  }
+
+  freeCount_ = 0;
+  for (uint16_t i = 1; i < 256; i++) {
+    slotLive_[i] = used[i];
+    if (!used[i]) {
+      freeSlots_[freeCount_++] = static_cast<uint8_t>(i);
+    }
+  }
+  #ifdef USB_DEBUG
+    Serial.printf("[GifCanvas] palette full, %u slots recycled\n",
+                  static_cast<unsigned>(freeCount_));
+  #endif
+  return freeCount_ > 0;
+}
+
+uint8_t GifCanvas::nearest_(uint16_t color) const {
+  const uint16_t c = canvasColorToHost(color);
+  const int r = c >> 11;
+  const int g = (c >> 5) & 0x3F;
+  const int b = c & 0x1F;
+
+  uint8_t best = 0;
+  int bestDist = INT32_MAX;
+  for (uint16_t i = 0; i < paletteUsed_; i++) {
+    if (!slotLive_[i]) continue;
+    const uint16_t p = canvasColorToHost(palette_[i]);
+    // Green has twice the resolution, red and blue are weighted up to match
+    const int dr = ((p >> 11) - r) * 2;
+    const int dg = ((p >> 5) & 0x3F) - g;
+    const int db = ((p & 0x1F) - b) * 2;
+    const int dist = dr * dr + dg * dg + db * db;
+    if (dist < bestDist) {
+      bestDist = dist;
+      best = static_cast<uint8_t>(i);
+    }
+  }
+  return best;
+}
+
+void GifCanvas::clearRect_(const Rect& r, const Rect& skip) {
+  for (int16_t y = r.y; y < r.y + r.h; y++) {
+    uint8_t* row = pixels_ + static_cast<size_t>(y) * width_;
+    for (int16_t x = r.x; x < r.x + r.w; x++) {
+      if (!skip.contains(x, y)) {
+        setPixel_(row, x, y, 0);
+      }
+    }
+  }
+}
+
+void GifCanvas::flush(RowFn record) {
+  if (!pixels_) return;
+
+  if (!frameStarted_ && disposePending_) {
+    // Frame without any rows: the pending disposal still takes effect
+    disposeActive_ = true;
+    disposeRect_ = clip_(pendingRect_);
+    disposePending_ = false;
+    frameRect_ = Rect();
+  }
+  if (disposeActive_) {
+    // Disposed pixels the new frame did not cover at all
+    clearRect_(disposeRect_, frameRect_);
+    disposeActive_ = false;
+  }
+  if (frameStarted_ && frameDisposal_ == 2) {
+    disposePending_ = true;
+    pendingRect_ = frameRect_;
+  }
+  frameStarted_ = false;
+  compareColors_ = false;
+
+  // Consecutive changed rows share one address window
+  int16_t y = visY0_;
+  while (y < visY1_) {
+    if (dirtyX1_[y] <= dirtyX0_[y]) {
+      ++y;
+      continue;
+    }
+    const int16_t y0 = y;
+    int16_t x0 = dirtyX0_[y];
+    int16_t x1 = dirtyX1_[y];
+    while (y < visY1_ && dirtyX1_[y] > dirtyX0_[y]) {
+      x0 = std::min(x0, dirtyX0_[y]);
+      x1 = std::max(x1, dirtyX1_[y]);
+      ++y;
+    }
+    x0 = std::max(x0, visX0_);
+    x1 = std::min(x1, visX1_);
+    if (x1 > x0) {
+      pushBand_(x0, x1, y0, y, record);
+    }
+  }
+  std::fill(dirtyX0_.begin(), dirtyX0_.end(), width_);
+  std::fill(dirtyX1_.begin(), dirtyX1_.end(), 0);
+}
+
+void GifCanvas::pushBand_(int16_t x0, int16_t x1, int16_t y0, int16_t y1, RowFn record) {
+  const int len = x1 - x0;
+  const int wideLen = len * scale_;
+  tft.setAddrWindow(offsetX_ + x0 * scale_, offsetY_ + y0 * scale_,
+                    wideLen, (y1 - y0) * scale_);
+
+  for (int16_t y = y0; y < y1; y++) {
+    const uint8_t* row = pixels_ + static_cast<size_t>(y) * width_ + x0;
+    for (int i = 0; i < len; i++) {
+      line_[i] = palette_[row[i]];
+    }
+    if (record) {
+      record(x0, y, line_, static_cast<uint16_t>(len));
+    }
+
+    if (scale_ == 1) {
+      tft.pushPixels(line_, len);
+      continue;
+    }
+    int out = 0;
+    for (int i = 0; i < len; i++) {
+      for (int r = 0; r < scale_; r++) {
+        wide_[out++] = line_[i];
+      }
+    }
+    for (int v = 0; v < scale_; v++) {
+      tft.pushPixels(wide_, wideLen);
+    }
+  }
+}
+
+void GifCanvas::restartLoop() {
+  if (!pixels_) return;
+  // Overrides whatever the last frame asked for: the whole canvas goes back
+  // to the background while the first frame is composited
+  disposePending_ = true;
+  pendingRect_.x = 0;
+  pendingRect_.y = 0;
+  pendingRect_.w = width_;
+  pendingRect_.h = height_;
+}
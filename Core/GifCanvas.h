@@ -0,0 +1,126 @@
+#ifndef GIFCANVAS_H
+#define GIFCANVAS_H
+
+#include <Arduino.h>
+#include <vector>
+#include <AnimatedGIF.h>
+
+/**
+ * GifCanvas - 8-bit indexed compositing canvas for GIF playback
+ *
+ * The decoder's rows are composited into one byte per canvas pixel,
+ * including transparency and the "restore to background" disposal, instead
+ * of being drawn straight to the panel. Every write that changes what a
+ * pixel shows extends the changed span of its row. At the end of a frame
+ * consecutive changed rows are pushed as one address window each, so
+ * sparse animations only cost the SPI traffic of what actually moved.
+ *
+ * Frames may bring their own (local) palettes. Canvas indices refer to a
+ * canvas palette with black (the background) at index 0; frame colours are
+ * mapped into it on first use. Slots no longer present on the canvas are
+ * recycled, and only a canvas showing more than 256 colours at once falls
+ * back to the nearest existing colour.
+ *
+ * "Restore to previous" disposal is treated like "do not dispose".
+ */
+class GifCanvas {
+ public:
+  using RowFn = void (*)(int16_t x, int16_t y, const uint16_t* colors, uint16_t len);
+
+  static constexpr size_t kMaxPixels = 240 * 240;
+
+  /**
+   * Allocate a blank canvas for a GIF of width x height, shown magnified by
+   * scale with its top-left corner at (offsetX, offsetY) on the panel.
+   */
+  bool begin(int16_t width, int16_t height, int scale, int offsetX, int offsetY);
+  void end();
+  bool active() const { return pixels_ != nullptr; }
+
+  /**
+   * Composite one decoded row (AnimatedGIF draw callback).
+   */
+  void drawRow(GIFDRAW* pDraw);
+
+  /**
+   * Finish the frame and push the changed rows. record, if given, receives
+   * every pushed row unscaled, in canvas coordinates.
+   */
+  void flush(RowFn record);
+
+  /**
+   * The next frame starts on a blank canvas (loop restart). Only pixels
+   * that differ from the current picture are pushed again.
+   */
+  void restartLoop();
+
+ private:
+  struct Rect {
+    int16_t x = 0;
+    int16_t y = 0;
+    int16_t w = 0;
+    int16_t h = 0;
+    bool contains(int16_t px, int16_t py) const {
+      return px >= x && px < x + w && py >= y && py < y + h;
+    }
+  };
+
+  static constexpr uint16_t kUnmapped = 0xFFFF;
+
+  void startFrame_(GIFDRAW* pDraw);
+  void clearRect_(const Rect& r, const Rect& skip);
+  void setPixel_(uint8_t* row, int16_t x, int16_t y, uint8_t idx);
+  uint8_t colorIndex_(uint8_t frameIndex);
+  uint8_t findOrInsert_(uint16_t color);
+  void resetPalette_();
+  bool collectFreeSlots_();
+  uint8_t nearest_(uint16_t color) const;
+  Rect clip_(const Rect& r) const;
+  void pushBand_(int16_t x0, int16_t x1, int16_t y0, int16_t y1, RowFn record);
+
+  uint8_t* pixels_ = nullptr;
+  int16_t width_ = 0;
+  int16_t height_ = 0;
+  int scale_ = 1;
+  int offsetX_ = 0;
+  int offsetY_ = 0;
+  int16_t visX0_ = 0;  // canvas columns/rows that land on the panel
+  int16_t visX1_ = 0;
+  int16_t visY0_ = 0;
+  int16_t visY1_ = 0;
+
+  // Changed span per canvas row, x1 <= x0 means unchanged
+  std::vector<int16_t> dirtyX0_;
+  std::vector<int16_t> dirtyX1_;
+
+  // Canvas palette (panel byte order) and the current frame's mapping into it
+  uint16_t palette_[256];
+  bool slotLive_[256];
+  uint16_t paletteUsed_ = 1;
+  uint8_t freeSlots_[256];
+  uint16_t freeCount_ = 0;
+  bool freeScanned_ = false;   // free slots already collected this frame
+  uint16_t framePalette_[256];
+  bool framePaletteValid_ = false;
+  uint16_t remap_[256];
+
+  // Palette swapped out by a frame that repaints the whole canvas; changes
+  // are detected by colour instead of index during that frame
+  uint16_t previousPalette_[256];
+  bool compareColors_ = false;
+
+  bool frameStarted_ = false;
+  Rect frameRect_;
+  bool frameTransparent_ = false;
+  uint8_t transparentIndex_ = 0;
+  uint8_t frameDisposal_ = 0;
+  bool disposeActive_ = false;   // disposal of the previous frame, applied lazily
+  Rect disposeRect_;
+  bool disposePending_ = false;  // disposal of this frame, for the next one
+  Rect pendingRect_;
+
+  uint16_t line_[240];
+  uint16_t wide_[240];
+};
+
+#endif // GIFCANVAS_H
@@ -0,0 +1,172 @@
+#include "GifFrameCache.h"
+#include "Config.h"
+#include <algorithm>
+
+namespace {
+constexpr size_t kGifCacheInitialWords = 2048;
+constexpr uint16_t kGifFrameCleared = 0x0100;  // frame tag flag: canvas cleared first
+}
+
+void GifFrameCache::begin(size_t budgetBytes) {
+  reset();
+  budget_ = budgetBytes / sizeof(uint16_t);
+  capturing_ = budget_ > 0;
+}
+
+void GifFrameCache::reset() {
+  free(data_);
+  data_ = nullptr;
+  used_ = 0;
+  capacity_ = 0;
+  budget_ = 0;
+  frameStart_ = 0;
+  replayPos_ = 0;
+  capturing_ = false;
+  ready_ = false;
+}
+
+void GifFrameCache::drop_() {
+  #ifdef USB_DEBUG
+    Serial.printf("[GifCache] over budget after %u bytes, live decode\n",
+                  static_cast<unsigned>(bytes()));
+  #endif
+  reset();
+}
+
+bool GifFrameCache::reserve_(size_t words) {
+  if (used_ + words <= capacity_) {
+    return true;
+  }
+  if (used_ + words > budget_) {
+    return false;
+  }
+  // Grow by half to keep reallocations rare, but never past the budget
+  size_t capacity = std::max(kGifCacheInitialWords, capacity_ + capacity_ / 2);
+  capacity = std::min(std::max(capacity, used_ + words), budget_);
+  uint16_t* data = static_cast<uint16_t*>(realloc(data_, capacity * sizeof(uint16_t)));
+  if (!data) {
+    return false;
+  }
+  data_ = data;
+  capacity_ = capacity;
+  return true;
+}
+
+bool GifFrameCache::push_(uint16_t word) {
+  if (!reserve_(1)) {
+    return false;
+  }
+  data_[used_++] = word;
+  return true;
+}
+
+void GifFrameCache::beginFrame() {
+  if (!capturing_) return;
+  frameStart_ = used_;
+  if (!push_(kTagFrame) || !push_(0)) {
+    drop_();
+  }
+}
+
+void GifFrameCache::markClear() {
+  if (!capturing_) return;
+  data_[frameStart_] |= kGifFrameCleared;
+}
+
+void GifFrameCache::addRun(int16_t x, int16_t y, const uint16_t* colors, uint16_t len) {
+  if (!capturing_) return;
+
+  while (len > 0) {
+    const uint16_t runLen = std::min(len, kMaxRun);
+    // Worst case: header plus one literal packet
+    if (!reserve_(4 + 1 + runLen)) {
+      drop_();
+      return;
+    }
+    data_[used_++] = kTagRun;
+    data_[used_++] = static_cast<uint16_t>(x);
+    data_[used_++] = static_cast<uint16_t>(y);
+    data_[used_++] = runLen;
+
+    // Packets: repeat (flag | count, colour) or literal (count, colours...)
+    uint16_t i = 0;
+    while (i < runLen) {
+      uint16_t same = 1;
+      while (i + same < runLen && colors[i + same] == colors[i]) {
+        ++same;
+      }
+      if (same >= 3) {
+        data_[used_++] = kRepeatFlag | same;
+        data_[used_++] = colors[i];
+        i += same;
+        continue;
+      }
+      // Literal up to the next stretch of three equal pixels
+      uint16_t lit = 0;
+      while (i + lit < runLen) {
+        if (i + lit + 2 < runLen && colors[i + lit] == colors[i + lit + 1] &&
+            colors[i + lit] == colors[i + lit + 2]) {
+          break;
+        }
+        ++lit;
+      }
+      data_[used_++] = lit;
+      memcpy(data_ + used_, colors + i, lit * sizeof(uint16_t));
+      used_ += lit;
+      i += lit;
+    }
+
+    x += runLen;
+    colors += runLen;
+    len -= runLen;
+  }
+}
+
+void GifFrameCache::endFrame(uint16_t delayMs, bool lastFrame) {
+  if (!capturing_) return;
+  data_[frameStart_ + 1] = delayMs;
+  if (lastFrame) {
+    capturing_ = false;
+    ready_ = true;
+    replayPos_ = 0;
+    #ifdef USB_DEBUG
+      Serial.printf("[GifCache] loop recorded: %u bytes\n", static_cast<unsigned>(bytes()));
+    #endif
+  }
+}
+
+uint16_t GifFrameCache::replayFrame(ClearFn clear, RunFn run) {
+  if (!ready_ || used_ == 0) return 0;
+  if (replayPos_ >= used_) {
+    replayPos_ = 0;
+  }
+
+  const uint16_t tag = data_[replayPos_];
+  const uint16_t delayMs = data_[replayPos_ + 1];
+  replayPos_ += 2;
+  if (tag & kGifFrameCleared) {
+    clear();
+  }
+
+  while (replayPos_ < used_ && data_[replayPos_] == kTagRun) {
+    const int16_t x = static_cast<int16_t>(data_[replayPos_ + 1]);
+    const int16_t y = static_cast<int16_t>(data_[replayPos_ + 2]);
+    const uint16_t len = data_[replayPos_ + 3];
+    replayPos_ += 4;
+
+    uint16_t filled = 0;
+    while (filled < len) {
+      const uint16_t header = data_[replayPos_++];
+      const uint16_t count = header & ~kRepeatFlag;
+      if (header & kRepeatFlag) {
+        std::fill(line_ + filled, line_ + filled + count, data_[replayPos_++]);
+      } else {
+        memcpy(line_ + filled, data_ + replayPos_, count * sizeof(uint16_t));
+        replayPos_ += count;
+      }
+      filled += count;
+    }
+    run(x, y, line_, len);
+  }
+  return delayMs;
+}
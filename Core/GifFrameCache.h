@@ -0,0 +1,70 @@
+#ifndef GIFFRAMECACHE_H
+#define GIFFRAMECACHE_H
+
+#include <Arduino.h>
+
+/**
+ * GifFrameCache - replay buffer for looping GIF animations
+ *
+ * While one loop of a GIF is decoded, every frame's output is
+ * recorded as it reaches the panel: whether the canvas was cleared, the
+ * opaque pixel runs of each row (canvas coordinates, RGB565 in panel byte
+ * order, run-length compressed) and the frame delay. Once the decoder
+ * wraps around, later loops are replayed from this buffer without any LZW
+ * decode, palette lookup or file access.
+ *
+ * The buffer grows on demand up to a fixed budget. A GIF that does not fit
+ * is dropped from the cache and simply keeps decoding live.
+ */
+class GifFrameCache {
+ public:
+  using ClearFn = void (*)();
+  using RunFn = void (*)(int16_t x, int16_t y, const uint16_t* colors, uint16_t len);
+
+  ~GifFrameCache() { reset(); }
+
+  /**
+   * Start recording a new animation with at most budgetBytes of memory.
+   */
+  void begin(size_t budgetBytes);
+  void reset();
+
+  bool capturing() const { return capturing_; }
+  bool ready() const { return ready_; }
+  size_t bytes() const { return used_ * sizeof(uint16_t); }
+
+  // Recording, driven from the decoder's draw callback
+  void beginFrame();
+  void markClear();
+  void addRun(int16_t x, int16_t y, const uint16_t* colors, uint16_t len);
+  void endFrame(uint16_t delayMs, bool lastFrame);
+
+  /**
+   * Replay the next frame through the given callbacks and return its delay.
+   * Wraps to the first frame after the last one.
+   */
+  uint16_t replayFrame(ClearFn clear, RunFn run);
+
+ private:
+  static constexpr uint16_t kTagFrame = 1;
+  static constexpr uint16_t kTagRun = 2;
+  static constexpr uint16_t kRepeatFlag = 0x8000;
+  static constexpr uint16_t kMaxRun = 256;  // longer rows are stored as several runs
+
+  bool reserve_(size_t words);
+  bool push_(uint16_t word);
+  void drop_();
+
+  uint16_t* data_ = nullptr;
+  size_t used_ = 0;       // in uint16_t words
+  size_t capacity_ = 0;
+  size_t budget_ = 0;
+  size_t frameStart_ = 0;
+  size_t replayPos_ = 0;
+  bool capturing_ = false;
+  bool ready_ = false;
+
+  uint16_t line_[kMaxRun];
+};
+
+#endif // GIFFRAMECACHE_H
@@ -0,0 +1,195 @@
+#include "HashCache.h"
+#include "Crc32.h"
+#include "Storage.h"
+
+#include <LittleFS.h>
+#include <mbedtls/sha256.h>
+#include <sys/stat.h>
+#include <cstring>
+
+namespace {
+constexpr size_t kHashReadBytes = 8192;
+constexpr uint8_t kHashHasCrc = 0x01;
+constexpr uint8_t kHashHasSha = 0x02;
+
+bool hashStat(const String& path, uint32_t* size, uint32_t* mtime) {
+  struct stat st;
+  if (::stat((String(kLittleFsBasePath) + path).c_str(), &st) != 0 || S_ISDIR(st.st_mode)) {
+    return false;
+  }
+  *size = static_cast<uint32_t>(st.st_size);
+  *mtime = static_cast<uint32_t>(st.st_mtime);
+  return true;
+}
+
+bool hashRead(File& f, size_t slot, HashCache::Record& rec) {
+  return f.seek(slot * sizeof(rec)) &&
+         f.read(reinterpret_cast<uint8_t*>(&rec), sizeof(rec)) == sizeof(rec);
+}
+
+bool hashWrite(File& f, size_t slot, const HashCache::Record& rec) {
+  return f.seek(slot * sizeof(rec)) &&
+         f.write(reinterpret_cast<const uint8_t*>(&rec), sizeof(rec)) == sizeof(rec);
+}
+
+// Slot holding path, or -1; *freeSlot gets the first empty slot (or the end)
+int hashFind(File& f, const String& path, HashCache::Record& rec, size_t* freeSlot) {
+  const size_t slots = f.size() / sizeof(HashCache::Record);
+  *freeSlot = slots;
+  for (size_t slot = 0; slot < slots && hashRead(f, slot, rec); ++slot) {
+    if (!rec.path[0]) {
+      if (*freeSlot == slots) {
+        *freeSlot = slot;
+      }
+      continue;
+    }
+    rec.path[HashCache::kPathLen - 1] = '\0';
+    if (path == rec.path) {
+      return static_cast<int>(slot);
+    }
+  }
+  return -1;
+}
+
+// Merge rec into the cache file, replacing an older record of the same path
+void hashStore(const HashCache::Record& rec) {
+  File f = LittleFS.exists(HashCache::kPath) ? LittleFS.open(HashCache::kPath, "r+")
+                                             : LittleFS.open(HashCache::kPath, FILE_WRITE);
+  if (!f) {
+    return;
+  }
+  HashCache::Record existing;
+  size_t freeSlot = 0;
+  const int slot = hashFind(f, String(rec.path), existing, &freeSlot);
+  hashWrite(f, slot >= 0 ? static_cast<size_t>(slot) : freeSlot, rec);
+  f.close();
+}
+
+void hashCopyDigest(const HashCache::Record& rec, HashCache::Algo algo, uint8_t* digest) {
+  if (algo == HashCache::Algo::Sha256) {
+    std::memcpy(digest, rec.sha256, sizeof(rec.sha256));
+  } else {
+    digest[0] = static_cast<uint8_t>(rec.crc >> 24);
+    digest[1] = static_cast<uint8_t>(rec.crc >> 16);
+    digest[2] = static_cast<uint8_t>(rec.crc >> 8);
+    digest[3] = static_cast<uint8_t>(rec.crc);
+  }
+}
+}
+
+namespace HashCache {
+
+static_assert(sizeof(Record) == 128, "hash cache records are 128 bytes on flash");
+
+bool compute(const String& path, Algo algo, uint8_t* digest, uint32_t* size, bool* cached) {
+  uint32_t mtime = 0;
+  *cached = false;
+  if (!hashStat(path, size, &mtime)) {
+    return false;
+  }
+  const uint8_t want = (algo == Algo::Sha256) ? kHashHasSha : kHashHasCrc;
+
+  Record rec{};
+  bool known = false;
+  if (path.length() < kPathLen && LittleFS.exists(kPath)) {
+    File f = LittleFS.open(kPath, FILE_READ);
+    size_t freeSlot = 0;
+    known = f && hashFind(f, path, rec, &freeSlot) >= 0 && rec.size == *size && rec.mtime == mtime;
+    if (f) {
+      f.close();
+    }
+    if (known && (rec.valid & want)) {
+      hashCopyDigest(rec, algo, digest);
+      *cached = true;
+      return true;
+    }
+  }
+
+  File file = LittleFS.open(path, FILE_READ);
+  if (!file) {
+    return false;
+  }
+  uint8_t* buffer = static_cast<uint8_t*>(malloc(kHashReadBytes));
+  uint8_t fallback[512];
+  const size_t bufferSize = buffer ? kHashReadBytes : sizeof(fallback);
+  if (!buffer) {
+    buffer = fallback;
+  }
+
+  uint32_t crc = 0;
+  mbedtls_sha256_context sha;
+  mbedtls_sha256_init(&sha);
+  mbedtls_sha256_starts(&sha, 0);
+  size_t total = 0;
+  for (;;) {
+    const size_t n = file.read(buffer, bufferSize);
+    if (n == 0) {
+      break;
+    }
+    // Both at once: the next request for the other one is free
+    crc = crc32Update(crc, buffer, n);
+    mbedtls_sha256_update(&sha, buffer, n);
+    total += n;
+    delay(0);
+  }
+  file.close();
+  if (buffer != fallback) {
+    free(buffer);
+  }
+  if (total != *size) {
+    mbedtls_sha256_free(&sha);
+    return false;
+  }
+
+  if (!known) {
+    rec = Record{};
+    std::strncpy(rec.path, path.c_str(), sizeof(rec.path) - 1);
+    rec.size = *size;
+    rec.mtime = mtime;
+  }
+  rec.crc = crc;
+  mbedtls_sha256_finish(&sha, rec.sha256);
+  mbedtls_sha256_free(&sha);
+  rec.valid = kHashHasCrc | kHashHasSha;
+  hashCopyDigest(rec, algo, digest);
+  if (path.length() < kPathLen) {
+    hashStore(rec);
+  }
+  #ifdef USB_DEBUG
+    Serial.printf("[Hash] %s %lu bytes crc %08lx\n", path.c_str(), static_cast<unsigned long>(total),
+                  static_cast<unsigned long>(crc));
+  #endif
+  return true;
+}
+
+void remember(const String& path, uint32_t crc) {
+  Record rec{};
+  if (path.length() >= kPathLen || !hashStat(path, &rec.size, &rec.mtime)) {
+    forget(path);
+    return;
+  }
+  std::strncpy(rec.path, path.c_str(), sizeof(rec.path) - 1);
+  rec.crc = crc;
+  rec.valid = kHashHasCrc;
+  hashStore(rec);
+}
+
+void forget(const String& path) {
+  if (path.length() >= kPathLen || !LittleFS.exists(kPath)) {
+    return;
+  }
+  File f = LittleFS.open(kPath, "r+");
+  if (!f) {
+    return;
+  }
+  Record rec;
+  size_t freeSlot = 0;
+  const int slot = hashFind(f, path, rec, &freeSlot);
+  if (slot >= 0) {
+    const Record empty{};
+    hashWrite(f, static_cast<size_t>(slot), empty);
+  }
+  f.close();
+}
+
+}  // namespace HashCache
@@ -0,0 +1,53 @@
+#ifndef HASHCACHE_H
+#define HASHCACHE_H
+
+#include <Arduino.h>
+
+/**
+ * File hashes for skip-unchanged syncs (HASH / HASHDIR)
+ *
+ * compute() streams a LittleFS file through CRC-32 or SHA-256 and keeps
+ * the result in kPath: one fixed 128-byte record per path with size,
+ * modification time and both digests. A later request for the same path
+ * is answered from the record as long as size and mtime still match, so
+ * re-checking a set of fonts does not read them again.
+ *
+ * The receivers call forget() when they replace or delete a file;
+ * remember() stores the CRC an upload computed anyway. Writers that do
+ * neither are caught by the size/mtime check.
+ */
+namespace HashCache {
+
+enum class Algo : uint8_t { Crc32 = 0, Sha256 };
+
+constexpr const char* kPath = "/.hashes";
+constexpr size_t kPathLen = 80;
+constexpr size_t kMaxDigest = 32;
+
+struct Record {
+  char path[kPathLen];
+  uint32_t size;
+  uint32_t mtime;
+  uint32_t crc;
+  uint8_t sha256[32];
+  uint8_t valid;        // bit 0: crc, bit 1: sha256
+  uint8_t reserved[3];
+};
+
+inline size_t digestLen(Algo algo) { return algo == Algo::Sha256 ? 32 : 4; }
+
+/**
+ * Digest of a LittleFS file (CRC-32 big-endian, so its hex reads like
+ * zlib.crc32). False if the file cannot be read. *cached tells whether
+ * the file was read at all.
+ */
+bool compute(const String& path, Algo algo, uint8_t* digest, uint32_t* size, bool* cached);
+
+// CRC of a file that was just written completely (upload), keyed by its current size and mtime
+void remember(const String& path, uint32_t crc);
+
+void forget(const String& path);
+
+}  // namespace HashCache
+
+#endif // HASHCACHE_H
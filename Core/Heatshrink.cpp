@@ -0,0 +1,95 @@
+#include "Heatshrink.h"
+
+bool HeatshrinkDecoder::begin(Emit emit, void* ctx) {
+  if (!window_) {
+    window_ = static_cast<uint8_t*>(malloc(kWindowSize));
+  }
+  outLen_ = 0;
+  produced_ = 0;
+  bits_ = 0;
+  bitCount_ = 0;
+  field_ = Field::Tag;
+  distance_ = 0;
+  emit_ = emit;
+  ctx_ = ctx;
+  return window_ != nullptr;
+}
+
+void HeatshrinkDecoder::end() {
+  free(window_);
+  window_ = nullptr;
+  emit_ = nullptr;
+  ctx_ = nullptr;
+}
+
+bool HeatshrinkDecoder::put_(uint8_t b) {
+  window_[produced_ & (kWindowSize - 1)] = b;
+  ++produced_;
+  out_[outLen_++] = b;
+  return outLen_ < kOutChunk || flush_();
+}
+
+bool HeatshrinkDecoder::flush_() {
+  if (outLen_ == 0) {
+    return true;
+  }
+  const bool ok = emit_(ctx_, out_, outLen_);
+  outLen_ = 0;
+  return ok;
+}
+
+bool HeatshrinkDecoder::feed(const uint8_t* data, size_t len) {
+  if (!window_ || !emit_) {
+    return false;
+  }
+  for (size_t i = 0; i < len; ++i) {
+    bits_ = (bits_ << 8) | data[i];
+    bitCount_ += 8;
+
+    // Every field is at most 11 bits, so one byte completes at most a few
+    for (;;) {
+      uint8_t need = 1;
+      switch (field_) {
+        case Field::Tag:      need = 1; break;
+        case Field::Literal:  need = 8; break;
+        case Field::Distance: need = kHeatshrinkWindowBits; break;
+        case Field::Length:   need = kHeatshrinkLookaheadBits; break;
+      }
+      if (bitCount_ < need) {
+        break;
+      }
+      bitCount_ -= need;
+      const uint16_t value = static_cast<uint16_t>((bits_ >> bitCount_) & ((1u << need) - 1));
+      bits_ &= (1u << bitCount_) - 1;
+
+      switch (field_) {
+        case Field::Tag:
+          field_ = value ? Field::Literal : Field::Distance;
+          break;
+        case Field::Literal:
+          if (!put_(static_cast<uint8_t>(value))) {
+            return false;
+          }
+          field_ = Field::Tag;
+          break;
+        case Field::Distance:
+          distance_ = value + 1;
+          field_ = Field::Length;
+          break;
+        case Field::Length: {
+          if (distance_ > produced_) {
+            return false;  // reaches before the start of the file
+          }
+          for (uint16_t n = 0; n <= value; ++n) {
+            if (!put_(window_[(produced_ - distance_) & (kWindowSize - 1)])) {
+              return false;
+            }
+          }
+          field_ = Field::Tag;
+          break;
+        }
+      }
+    }
+  }
+  return flush_();
+}
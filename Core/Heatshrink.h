@@ -0,0 +1,59 @@
+#ifndef HEATSHRINK_H
+#define HEATSHRINK_H
+
+#include <Arduino.h>
+
+/**
+ * Streaming decoder for heatshrink-compressed uploads (BZSTART)
+ *
+ * heatshrink is LZSS with a bit stream, most significant bit first: a 1
+ * bit and 8 literal bits, or a 0 bit, kHeatshrinkWindowBits of distance-1
+ * and kHeatshrinkLookaheadBits of length-1. The decoder keeps the last
+ * 2^kHeatshrinkWindowBits output bytes as history and hands the output on
+ * in small pieces, so its RAM is the window plus one piece, whatever the
+ * file size. The host encoder is tools/heatshrink.py; the reference
+ * `heatshrink -e -w 11 -l 4` produces the same format.
+ */
+constexpr uint8_t kHeatshrinkWindowBits = 11;
+constexpr uint8_t kHeatshrinkLookaheadBits = 4;
+
+class HeatshrinkDecoder {
+ public:
+  // Output sink; returning false stops the decoder with an error
+  using Emit = bool (*)(void* ctx, const uint8_t* data, size_t len);
+
+  ~HeatshrinkDecoder() { end(); }
+
+  bool begin(Emit emit, void* ctx);
+  void end();
+
+  /**
+   * Decode len compressed bytes. False on a corrupt stream (reference
+   * before the first output byte) or when emit refused the output.
+   */
+  bool feed(const uint8_t* data, size_t len);
+
+  size_t produced() const { return produced_; }
+
+ private:
+  enum class Field : uint8_t { Tag = 0, Literal, Distance, Length };
+
+  bool put_(uint8_t b);
+  bool flush_();
+
+  static constexpr size_t kWindowSize = static_cast<size_t>(1) << kHeatshrinkWindowBits;
+  static constexpr size_t kOutChunk = 256;
+
+  uint8_t* window_ = nullptr;
+  uint8_t out_[kOutChunk];
+  size_t outLen_ = 0;
+  size_t produced_ = 0;
+  uint32_t bits_ = 0;      // pending input bits, right-aligned
+  uint8_t bitCount_ = 0;
+  Field field_ = Field::Tag;
+  uint16_t distance_ = 0;
+  Emit emit_ = nullptr;
+  void* ctx_ = nullptr;
+};
+
+#endif // HEATSHRINK_H
@@ -1,5 +1,7 @@
 #include "I18n.h"
 
+#include <algorithm>
+
 // Global instance
 I18n i18n;
 
@@ -129,6 +131,24 @@ String I18n::t(const char* key, const String& p0, const String& p1, const String
   return result;
 }
 
+const char* I18n::format(char* out, size_t outLen, const char* key, const char* p0) {
+  if (!out || outLen == 0) {
+    return out;
+  }
+  const char* tmpl = t(key);
+  const char* slot = strstr(tmpl, "{0}");
+  if (!slot) {
+    strlcpy(out, tmpl, outLen);
+    return out;
+  }
+  const size_t prefix = std::min(static_cast<size_t>(slot - tmpl), outLen - 1);
+  memcpy(out, tmpl, prefix);
+  out[prefix] = '\0';
+  strlcat(out, p0 ? p0 : "", outLen);
+  strlcat(out, slot + 3, outLen);
+  return out;
+}
+
 bool I18n::setLanguage(const char* lang) {
   if (!lang || langCount_ == 0) {
     return false;
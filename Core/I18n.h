@@ -56,6 +56,14 @@ public:
    */
   String t(const char* key, const String& p0, const String& p1, const String& p2);
 
+  /**
+   * Translate with one parameter substitution into a caller buffer.
+   * Same result as t(key, p0), but without heap allocation.
+   *
+   * @return out (always NUL-terminated, truncated if too small)
+   */
+  const char* format(char* out, size_t outLen, const char* key, const char* p0);
+
   /**
    * Change the active language.
    *
@@ -0,0 +1,272 @@
+#include "ImageProbe.h"
+#include "Crc32.h"
+#include "DeltaAnim.h"
+#include "QoiImage.h"
+#include "Config.h"
+#include <cstring>
+
+namespace {
+constexpr uint16_t kProbeGifMaxWidth = 480;  // AnimatedGIF line buffer (MAX_WIDTH)
+constexpr size_t kProbeGifHeaderSize = 10;   // signature + logical screen size
+constexpr size_t kProbeQoiHeaderSize = 14;
+
+// JPEG markers
+constexpr uint8_t kProbeSof0 = 0xC0;  // baseline, the only SOF TJpgDec decodes
+constexpr uint8_t kProbeSof2 = 0xC2;  // progressive
+constexpr uint8_t kProbeDht = 0xC4;
+constexpr uint8_t kProbeJpg = 0xC8;
+constexpr uint8_t kProbeDac = 0xCC;
+constexpr uint8_t kProbeSos = 0xDA;
+constexpr uint8_t kProbeEoi = 0xD9;
+constexpr uint8_t kProbeTem = 0x01;
+
+inline bool probeIsSof(uint8_t m) {
+  return m >= 0xC0 && m <= 0xCF && m != kProbeDht && m != kProbeJpg && m != kProbeDac;
+}
+
+inline bool probeIsStandalone(uint8_t m) {
+  return m == kProbeTem || (m >= 0xD0 && m <= 0xD7);  // TEM, RSTn
+}
+
+inline uint16_t probeBe16(const uint8_t* p) {
+  return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+inline uint16_t probeLe16(const uint8_t* p) {
+  return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+inline uint32_t probeBe32(const uint8_t* p) {
+  return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+         (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+}
+
+void ImageProbe::begin(const char* filename) {
+  media_ = slideMediaTypeFor(filename, &type_);
+  verdict_ = media_ ? Verdict::NeedMore : Verdict::Ok;
+  reason_ = "";
+  width_ = 0;
+  height_ = 0;
+  crc_ = 0;
+  jpegState_ = JpegState::Soi0;
+  marker_ = 0;
+  segmentLeft_ = 0;
+  headerLen_ = 0;
+  switch (type_) {
+    case SlideMediaType::Gif:  headerNeed_ = kProbeGifHeaderSize; break;
+    case SlideMediaType::Qoi:  headerNeed_ = kProbeQoiHeaderSize; break;
+    case SlideMediaType::Anim: headerNeed_ = DeltaAnim::kHeaderSize; break;
+    default:                   headerNeed_ = 0; break;
+  }
+}
+
+ImageProbe::Verdict ImageProbe::feed(const uint8_t* data, size_t len) {
+  crc_ = crc32Update(crc_, data, len);
+  for (size_t i = 0; i < len && verdict_ == Verdict::NeedMore; ++i) {
+    if (type_ == SlideMediaType::Jpeg) {
+      feedJpeg_(data[i]);
+    } else {
+      header_[headerLen_++] = data[i];
+      if (headerLen_ == headerNeed_) {
+        checkFixedHeader_();
+      }
+    }
+  }
+  return verdict_;
+}
+
+ImageProbe::Verdict ImageProbe::finish() {
+  if (verdict_ == Verdict::NeedMore) {
+    reject_("Header unvollständig");
+  }
+  return verdict_;
+}
+
+void ImageProbe::accept_(uint32_t w, uint32_t h) {
+  width_ = static_cast<uint16_t>(w);
+  height_ = static_cast<uint16_t>(h);
+  verdict_ = Verdict::Ok;
+}
+
+void ImageProbe::reject_(const char* reason) {
+  reason_ = reason;
+  verdict_ = Verdict::Unsupported;
+  #ifdef USB_DEBUG
+    Serial.printf("[Probe] unsupported: %s\n", reason);
+  #endif
+}
+
+void ImageProbe::feedJpeg_(uint8_t b) {
+  switch (jpegState_) {
+    case JpegState::Soi0:
+      if (b != 0xFF) {
+        reject_("kein JPEG");
+        return;
+      }
+      jpegState_ = JpegState::Soi1;
+      return;
+    case JpegState::Soi1:
+      if (b != 0xD8) {
+        reject_("kein JPEG");
+        return;
+      }
+      jpegState_ = JpegState::Marker;
+      return;
+    case JpegState::Marker:
+      if (b != 0xFF) {
+        reject_("JPEG defekt");
+        return;
+      }
+      jpegState_ = JpegState::Code;
+      return;
+    case JpegState::Code:
+      if (b == 0xFF) {
+        return;  // fill byte
+      }
+      if (probeIsStandalone(b)) {
+        jpegState_ = JpegState::Marker;
+        return;
+      }
+      if (b == 0x00) {
+        reject_("JPEG defekt");
+        return;
+      }
+      if (b == kProbeSos || b == kProbeEoi) {
+        reject_("JPEG ohne Bildgröße");
+        return;
+      }
+      marker_ = b;
+      jpegState_ = JpegState::LenHi;
+      return;
+    case JpegState::LenHi:
+      segmentLeft_ = static_cast<uint32_t>(b) << 8;
+      jpegState_ = JpegState::LenLo;
+      return;
+    case JpegState::LenLo:
+      segmentLeft_ |= b;
+      if (segmentLeft_ < 2) {
+        reject_("JPEG defekt");
+        return;
+      }
+      segmentLeft_ -= 2;  // the length counts itself
+      if (probeIsSof(marker_)) {
+        if (marker_ == kProbeSof2 || marker_ == kProbeSof2 + 8) {
+          reject_("JPEG progressiv");
+          return;
+        }
+        if (marker_ != kProbeSof0) {
+          reject_("JPEG nicht Baseline");
+          return;
+        }
+        headerLen_ = 0;
+        headerNeed_ = 6;  // precision, height, width, component count
+        jpegState_ = JpegState::Sof;
+        return;
+      }
+      jpegState_ = segmentLeft_ ? JpegState::Skip : JpegState::Marker;
+      return;
+    case JpegState::Skip:
+      if (--segmentLeft_ == 0) {
+        jpegState_ = JpegState::Marker;
+      }
+      return;
+    case JpegState::Sof:
+      if (headerLen_ >= segmentLeft_) {
+        reject_("JPEG defekt");
+        return;
+      }
+      header_[headerLen_++] = b;
+      if (headerLen_ == 6) {
+        const uint8_t components = header_[5];
+        if (components != 1 && components != 3) {
+          reject_(components == 4 ? "JPEG CMYK" : "JPEG Farbraum");
+          return;
+        }
+        headerNeed_ = 6 + components * 3u;
+      }
+      if (headerLen_ == headerNeed_) {
+        checkSof_();
+      }
+      return;
+  }
+}
+
+void ImageProbe::checkSof_() {
+  const uint16_t h = probeBe16(header_ + 1);
+  const uint16_t w = probeBe16(header_ + 3);
+  if (header_[0] != 8) {
+    reject_("JPEG 12 Bit");
+    return;
+  }
+  if (w == 0 || h == 0) {
+    reject_("JPEG ohne Bildgröße");
+    return;
+  }
+  // Luma may be subsampled 2x1 or 2x2, chroma never
+  const uint8_t components = header_[5];
+  for (uint8_t i = 0; i < components; ++i) {
+    const uint8_t sampling = header_[6 + i * 3 + 1];
+    const bool ok = (i == 0) ? (sampling == 0x11 || sampling == 0x21 || sampling == 0x22)
+                             : (sampling == 0x11);
+    if (!ok) {
+      reject_("JPEG Abtastung");
+      return;
+    }
+  }
+  accept_(w, h);
+}
+
+void ImageProbe::checkFixedHeader_() {
+  switch (type_) {
+    case SlideMediaType::Gif: {
+      if (std::memcmp(header_, "GIF87a", 6) != 0 && std::memcmp(header_, "GIF89a", 6) != 0) {
+        reject_("kein GIF");
+        return;
+      }
+      const uint16_t w = probeLe16(header_ + 6);
+      const uint16_t h = probeLe16(header_ + 8);
+      if (w == 0 || h == 0) {
+        reject_("GIF ohne Bildgröße");
+        return;
+      }
+      if (w > kProbeGifMaxWidth) {
+        reject_("GIF zu breit");
+        return;
+      }
+      accept_(w, h);
+      return;
+    }
+    case SlideMediaType::Qoi: {
+      if (std::memcmp(header_, "qoif", 4) != 0) {
+        reject_("kein QOI");
+        return;
+      }
+      const uint32_t w = probeBe32(header_ + 4);
+      const uint32_t h = probeBe32(header_ + 8);
+      if (w == 0 || h == 0 || w > kQoiMaxSide || h > kQoiMaxSide) {
+        reject_("QOI Bildgröße");
+        return;
+      }
+      accept_(w, h);
+      return;
+    }
+    case SlideMediaType::Anim: {
+      if (std::memcmp(header_, "ANM1", 4) != 0) {
+        reject_("kein ANM");
+        return;
+      }
+      const uint16_t w = probeLe16(header_ + 4);
+      const uint16_t h = probeLe16(header_ + 6);
+      const uint16_t frames = probeLe16(header_ + 8);
+      if (w == 0 || h == 0 || w > TFT_W || h > TFT_H || frames == 0) {
+        reject_("ANM Bildgröße");
+        return;
+      }
+      accept_(w, h);
+      return;
+    }
+    default:
+      return;
+  }
+}
@@ -0,0 +1,77 @@
+#ifndef IMAGEPROBE_H
+#define IMAGEPROBE_H
+
+#include <Arduino.h>
+
+#include "Storage.h"
+
+/**
+ * ImageProbe - checks slide uploads while their bytes stream in
+ *
+ * The receivers feed every chunk through the probe. It parses just enough
+ * of the header to tell whether the slideshow can show the file: the SOF
+ * segment of a JPEG (TJpgDec only decodes 8-bit baseline with Y, YCbCr
+ * 4:4:4, 4:2:2 or 4:2:0), the logical screen descriptor of a GIF, or the
+ * fixed headers of QOI and .anm. A file the decoders would refuse is
+ * reported as Unsupported as soon as the deciding bytes have arrived, so
+ * the upload can be aborted before END instead of failing on every
+ * slideshow cycle.
+ *
+ * Dimensions, media type and a CRC-32 over all bytes are kept for the
+ * slide metadata (SlideMeta.h). Files that are no slide media (configs,
+ * scripts) are only hashed.
+ */
+class ImageProbe {
+ public:
+  enum class Verdict : uint8_t { NeedMore = 0, Ok, Unsupported };
+
+  void begin(const char* filename);
+  Verdict feed(const uint8_t* data, size_t len);
+
+  /**
+   * All bytes are in. A media file whose header never completed is
+   * Unsupported from here on.
+   */
+  Verdict finish();
+
+  /**
+   * Resumed upload: the headers of the kept part were fed again, the CRC
+   * of the whole part comes from the resume record.
+   */
+  void restoreCrc(uint32_t crc) { crc_ = crc; }
+
+  bool isMedia() const { return media_; }
+  Verdict verdict() const { return verdict_; }
+  const char* reason() const { return reason_; }
+  SlideMediaType type() const { return type_; }
+  uint16_t width() const { return width_; }
+  uint16_t height() const { return height_; }
+  uint32_t crc() const { return crc_; }
+
+ private:
+  enum class JpegState : uint8_t { Soi0, Soi1, Marker, Code, LenHi, LenLo, Skip, Sof };
+
+  void feedJpeg_(uint8_t b);
+  void checkSof_();
+  void checkFixedHeader_();
+  void accept_(uint32_t w, uint32_t h);
+  void reject_(const char* reason);
+
+  bool media_ = false;
+  SlideMediaType type_ = SlideMediaType::Jpeg;
+  Verdict verdict_ = Verdict::NeedMore;
+  const char* reason_ = "";
+  uint16_t width_ = 0;
+  uint16_t height_ = 0;
+  uint32_t crc_ = 0;
+
+  JpegState jpegState_ = JpegState::Soi0;
+  uint8_t marker_ = 0;
+  uint32_t segmentLeft_ = 0;
+
+  uint8_t header_[24];  // fixed headers (GIF 10, QOI 14, ANM 24) or the SOF body
+  size_t headerLen_ = 0;
+  size_t headerNeed_ = 0;
+};
+
+#endif // IMAGEPROBE_H
@@ -0,0 +1,179 @@
+#include "QoiImage.h"
+#include "Gfx.h"
+#include "Config.h"
+#include <algorithm>
+
+namespace {
+constexpr size_t kQoiHeaderSize = 14;
+constexpr size_t kQoiInputBytes = 2048;
+
+constexpr uint8_t kQoiOpIndex = 0x00;
+constexpr uint8_t kQoiOpDiff = 0x40;
+constexpr uint8_t kQoiOpLuma = 0x80;
+constexpr uint8_t kQoiOpRun = 0xC0;
+constexpr uint8_t kQoiOpRgb = 0xFE;
+constexpr uint8_t kQoiOpRgba = 0xFF;
+constexpr uint8_t kQoiMask2 = 0xC0;
+
+struct QoiPixel {
+  uint8_t r = 0;
+  uint8_t g = 0;
+  uint8_t b = 0;
+  uint8_t a = 255;
+};
+
+inline uint32_t qoiBe32(const uint8_t* p) {
+  return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+         (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+bool qoiReadHeader(File& file, uint32_t* w, uint32_t* h) {
+  uint8_t header[kQoiHeaderSize];
+  if (file.read(header, sizeof(header)) != sizeof(header) ||
+      header[0] != 'q' || header[1] != 'o' || header[2] != 'i' || header[3] != 'f') {
+    return false;
+  }
+  *w = qoiBe32(header + 4);
+  *h = qoiBe32(header + 8);
+  return *w > 0 && *h > 0 && *w <= kQoiMaxSide && *h <= kQoiMaxSide;
+}
+
+// RGB565 in panel byte order, alpha over black
+inline uint16_t qoiToPanel(const QoiPixel& px) {
+  uint8_t r = px.r;
+  uint8_t g = px.g;
+  uint8_t b = px.b;
+  if (px.a != 255) {
+    r = static_cast<uint8_t>((r * px.a) / 255);
+    g = static_cast<uint8_t>((g * px.a) / 255);
+    b = static_cast<uint8_t>((b * px.a) / 255);
+  }
+  const uint16_t c = static_cast<uint16_t>(((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3));
+  return static_cast<uint16_t>((c >> 8) | (c << 8));
+}
+
+// Buffered byte source; reads past the end yield zeros and set failed
+class QoiInput {
+ public:
+  explicit QoiInput(File& file) : file_(file) {}
+
+  uint8_t next() {
+    if (pos_ == len_) {
+      len_ = file_.read(buffer_, sizeof(buffer_));
+      pos_ = 0;
+      if (len_ == 0) {
+        failed_ = true;
+        return 0;
+      }
+    }
+    return buffer_[pos_++];
+  }
+
+  bool failed() const { return failed_; }
+
+ private:
+  File& file_;
+  uint8_t buffer_[kQoiInputBytes];
+  size_t pos_ = 0;
+  size_t len_ = 0;
+  bool failed_ = false;
+};
+}
+
+bool getQoiSize(File& file, uint16_t* w, uint16_t* h) {
+  const size_t start = file.position();
+  uint32_t width = 0;
+  uint32_t height = 0;
+  const bool ok = qoiReadHeader(file, &width, &height);
+  file.seek(start);
+  if (!ok) {
+    return false;
+  }
+  *w = static_cast<uint16_t>(width);
+  *h = static_cast<uint16_t>(height);
+  return true;
+}
+
+bool drawQoi(File& file, int16_t x, int16_t y) {
+  uint32_t width = 0;
+  uint32_t height = 0;
+  if (!qoiReadHeader(file, &width, &height)) {
+    return false;
+  }
+
+  // Part of the image that lands on the panel
+  const int32_t colStart = std::max<int32_t>(0, -x);
+  const int32_t colEnd = std::min<int32_t>(width, TFT_W - x);
+  const int32_t rowStart = std::max<int32_t>(0, -y);
+  const int32_t rowEnd = std::min<int32_t>(height, TFT_H - y);
+  const bool visible = colEnd > colStart && rowEnd > rowStart;
+
+  QoiInput in(file);
+  // The spec starts the index all zero (a = 0); only the previous pixel is opaque black
+  QoiPixel index[64];
+  for (QoiPixel& slot : index) {
+    slot = {0, 0, 0, 0};
+  }
+  QoiPixel px;
+  uint16_t color = qoiToPanel(px);
+  uint16_t row[TFT_W];
+  uint32_t run = 0;
+
+  tft.startWrite();
+  if (visible) {
+    tft.setAddrWindow(x + colStart, y + rowStart, colEnd - colStart, rowEnd - rowStart);
+  }
+  for (uint32_t py = 0; py < height && !in.failed(); ++py) {
+    if (static_cast<int32_t>(py) >= rowEnd) {
+      break;  // nothing below is shown
+    }
+    for (uint32_t pxX = 0; pxX < width; ++pxX) {
+      if (run > 0) {
+        --run;
+      } else {
+        const uint8_t b1 = in.next();
+        if (b1 == kQoiOpRgb) {
+          px.r = in.next();
+          px.g = in.next();
+          px.b = in.next();
+        } else if (b1 == kQoiOpRgba) {
+          px.r = in.next();
+          px.g = in.next();
+          px.b = in.next();
+          px.a = in.next();
+        } else if ((b1 & kQoiMask2) == kQoiOpIndex) {
+          px = index[b1];
+        } else if ((b1 & kQoiMask2) == kQoiOpDiff) {
+          px.r += ((b1 >> 4) & 0x03) - 2;
+          px.g += ((b1 >> 2) & 0x03) - 2;
+          px.b += (b1 & 0x03) - 2;
+        } else if ((b1 & kQoiMask2) == kQoiOpLuma) {
+          const uint8_t b2 = in.next();
+          const int vg = (b1 & 0x3F) - 32;
+          px.r += vg - 8 + ((b2 >> 4) & 0x0F);
+          px.g += vg;
+          px.b += vg - 8 + (b2 & 0x0F);
+        } else {
+          run = b1 & 0x3F;  // run of length + 1, this pixel included
+        }
+        index[(px.r * 3 + px.g * 5 + px.b * 7 + px.a * 11) & 63] = px;
+        color = qoiToPanel(px);
+      }
+      if (static_cast<int32_t>(pxX) >= colStart && static_cast<int32_t>(pxX) < colEnd) {
+        row[pxX - colStart] = color;
+      }
+    }
+    if (visible && static_cast<int32_t>(py) >= rowStart) {
+      tft.pushPixels(row, colEnd - colStart);
+    }
+  }
+  tft.endWrite();
+
+  if (in.failed()) {
+    #ifdef USB_DEBUG
+      Serial.println(F("[QOI] truncated image"));
+    #endif
+    return false;
+  }
+  return true;
+}
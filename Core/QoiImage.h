@@ -0,0 +1,28 @@
+#ifndef QOIIMAGE_H
+#define QOIIMAGE_H
+
+#include <Arduino.h>
+#include <FS.h>
+
+/**
+ * QOI still images (https://qoiformat.org), the lossless alternative to
+ * JPEG for graphics, text and pixel art. Decoding is a single pass of
+ * byte-sized ops without any transform, so it streams straight from the
+ * file: every row is converted to RGB565 as it completes and pushed into
+ * one address window covering the visible part of the image.
+ *
+ * Alpha is composited over black. Images larger than the panel are
+ * cropped to the part that lands on it.
+ */
+
+// Larger headers are refused before decoding (and at upload, ImageProbe)
+constexpr uint32_t kQoiMaxSide = 4096;
+
+// Both start at the file's current position (flash slide pack handles
+// start mid-file). getQoiSize restores it, drawQoi consumes the image.
+bool getQoiSize(File& file, uint16_t* w, uint16_t* h);
+
+// Draws with the image's top-left corner at (x, y), which may lie off-panel
+bool drawQoi(File& file, int16_t x, int16_t y);
+
+#endif // QOIIMAGE_H
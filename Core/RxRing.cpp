@@ -0,0 +1,68 @@
+#include "RxRing.h"
+
+#include <algorithm>
+#include <cstring>
+
+bool RxRing::begin(size_t capacity) {
+  if (buf_) {
+    return true;
+  }
+  if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+    return false;
+  }
+  buf_ = static_cast<uint8_t*>(malloc(capacity));
+  if (!buf_) {
+    return false;
+  }
+  mask_ = capacity - 1;
+  head_.store(0, std::memory_order_relaxed);
+  tail_.store(0, std::memory_order_relaxed);
+  return true;
+}
+
+void RxRing::end() {
+  free(buf_);
+  buf_ = nullptr;
+  mask_ = 0;
+}
+
+size_t RxRing::space() const {
+  return capacity() - (head_.load(std::memory_order_relaxed) - tail_.load(std::memory_order_acquire));
+}
+
+uint8_t* RxRing::writeSpan(size_t* len) {
+  const size_t head = head_.load(std::memory_order_relaxed);
+  const size_t offset = head & mask_;
+  *len = std::min(space(), capacity() - offset);
+  return buf_ + offset;
+}
+
+void RxRing::commit(size_t len) {
+  head_.store(head_.load(std::memory_order_relaxed) + len, std::memory_order_release);
+}
+
+size_t RxRing::available() const {
+  return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_relaxed);
+}
+
+int RxRing::read() {
+  const size_t tail = tail_.load(std::memory_order_relaxed);
+  if (head_.load(std::memory_order_acquire) == tail) {
+    return -1;
+  }
+  const uint8_t b = buf_[tail & mask_];
+  tail_.store(tail + 1, std::memory_order_release);
+  return b;
+}
+
+size_t RxRing::read(uint8_t* out, size_t len) {
+  const size_t tail = tail_.load(std::memory_order_relaxed);
+  len = std::min(len, head_.load(std::memory_order_acquire) - tail);
+  // At most two pieces: up to the end of the buffer, then from its start
+  const size_t offset = tail & mask_;
+  const size_t first = std::min(len, capacity() - offset);
+  std::memcpy(out, buf_ + offset, first);
+  std::memcpy(out + first, buf_, len - first);
+  tail_.store(tail + len, std::memory_order_release);
+  return len;
+}
@@ -0,0 +1,47 @@
+#ifndef RXRING_H
+#define RXRING_H
+
+#include <Arduino.h>
+#include <atomic>
+
+/**
+ * Lock-free single-producer/single-consumer byte ring for serial input
+ *
+ * The UART receive callback (HardwareSerial::onReceive, its own task) moves
+ * bytes from the driver into the ring as soon as they arrive; the protocol
+ * parser in loop() reads them out whenever it gets to it. A long draw call
+ * then only fills the ring instead of overflowing the small driver buffer.
+ *
+ * Exactly one task may call the producer side (writeSpan/commit/space), and
+ * exactly one the consumer side (available/read). Head and tail are
+ * free-running counters published with release/acquire ordering, so
+ * neither side ever takes a lock. The capacity must be a power of two.
+ */
+class RxRing {
+ public:
+  ~RxRing() { end(); }
+
+  bool begin(size_t capacity);
+  void end();
+  bool ready() const { return buf_ != nullptr; }
+
+  // Producer: contiguous free space at the write position (may be less than space())
+  uint8_t* writeSpan(size_t* len);
+  void commit(size_t len);
+  size_t space() const;
+
+  // Consumer
+  size_t available() const;
+  int read();
+  size_t read(uint8_t* out, size_t len);
+
+  size_t capacity() const { return mask_ + 1; }
+
+ private:
+  uint8_t* buf_ = nullptr;
+  size_t mask_ = 0;
+  std::atomic<size_t> head_{0};  // written by the producer
+  std::atomic<size_t> tail_{0};  // written by the consumer
+};
+
+#endif // RXRING_H
@@ -1,5 +1,6 @@
 #include "SDCopyEngine.h"
 #include "Storage.h"
+#include "SlidePack.h"
 #include "Config.h"
 #include <algorithm>
 
@@ -143,8 +144,8 @@ bool SDCopyEngine::prepare() {
       ci.destPath = String("/scripts/") + filename;
       accepted = true;
     }
-    // JPEG images
-    else if (lower.endsWith(".jpg") || lower.endsWith(".jpeg")) {
+    // JPEG and QOI images
+    else if (lower.endsWith(".jpg") || lower.endsWith(".jpeg") || lower.endsWith(".qoi")) {
       ci.type = FileType::Jpg;
       String destName = filename;
       String ext = ".jpg";
@@ -158,15 +159,15 @@ bool SDCopyEngine::prepare() {
 
       // Auto-rename if file exists
       int counter = 1;
-      while (LittleFS.exists(ci.destPath) && counter < 1000) {
+      while (slidePack.nameTaken(destName) && counter < 1000) {
         destName = base + "-" + String(counter) + ext;
         ci.destPath = String(kFlashSlidesDir) + "/" + destName;
         ++counter;
       }
       accepted = true;
     }
-    // GIF images
-    else if (lower.endsWith(".gif")) {
+    // GIF images and native delta animations
+    else if (lower.endsWith(".gif") || lower.endsWith(".anm")) {
       ci.type = FileType::Gif;
       String destName = filename;
       String ext = ".gif";
@@ -180,7 +181,7 @@ bool SDCopyEngine::prepare() {
 
       // Auto-rename if file exists
       int counter = 1;
-      while (LittleFS.exists(ci.destPath) && counter < 1000) {
+      while (slidePack.nameTaken(destName) && counter < 1000) {
         destName = base + "-" + String(counter) + ext;
         ci.destPath = String(kFlashSlidesDir) + "/" + destName;
         ++counter;
@@ -249,10 +250,23 @@ void SDCopyEngine::tick() {
 
       const CopyItem& item = queue_[queueIndex_];
       srcFile_ = SD.open(item.path.c_str(), FILE_READ);
-      dstFile_ = LittleFS.open(item.destPath.c_str(), FILE_WRITE);
       fileBytesDone_ = 0;
 
-      if (!srcFile_ || !dstFile_) {
+      // Slides go into the flash slide pack when it is enabled
+      SlideMediaType packType;
+      const bool isSlide = (item.type == FileType::Jpg || item.type == FileType::Gif) &&
+                           slideMediaTypeFor(item.name.c_str(), &packType);
+      toPack_ = isSlide && SlidePack::enabledForUploads();
+      bool dstOk;
+      if (toPack_) {
+        const char* destName = strrchr(item.destPath.c_str(), '/');
+        dstOk = slidePack.beginAppend(destName ? destName + 1 : item.destPath.c_str(), packType, item.size);
+      } else {
+        dstFile_ = LittleFS.open(item.destPath.c_str(), FILE_WRITE);
+        dstOk = static_cast<bool>(dstFile_);
+      }
+
+      if (!srcFile_ || !dstOk) {
         String msg = "Error at: " + item.name;
         finalize_(Outcome::Error, msg);
         return;
@@ -264,7 +278,15 @@ void SDCopyEngine::tick() {
     if (available == 0) {
       // File complete, close and move to next
       srcFile_.close();
-      dstFile_.close();
+      if (toPack_) {
+        toPack_ = false;
+        if (!slidePack.commitAppend()) {
+          finalize_(Outcome::Error, "Write error");
+          return;
+        }
+      } else {
+        dstFile_.close();
+      }
       ++queueIndex_;
       continue;
     }
@@ -277,7 +299,8 @@ void SDCopyEngine::tick() {
       return;
     }
 
-    if (dstFile_.write(buffer_, n) != n) {
+    const bool written = toPack_ ? slidePack.write(buffer_, n) : (dstFile_.write(buffer_, n) == n);
+    if (!written) {
       finalize_(Outcome::Error, "Write error");
       return;
     }
@@ -351,6 +374,10 @@ bool SDCopyEngine::ensureFlashReady_() {
 void SDCopyEngine::closeFiles_() {
   if (srcFile_) srcFile_.close();
   if (dstFile_) dstFile_.close();
+  if (toPack_) {
+    slidePack.abortAppend();
+    toPack_ = false;
+  }
 }
 
 void SDCopyEngine::finalize_(Outcome outcome, const String& message) {
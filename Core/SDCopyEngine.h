@@ -108,6 +108,7 @@ class SDCopyEngine {
 
   File srcFile_;
   File dstFile_;
+  bool toPack_ = false;  // current file is appended to the flash slide pack
   uint8_t* buffer_ = nullptr;
 };
 
@@ -0,0 +1,147 @@
+#include "SdFastSeek.h"
+
+#include <SD.h>
+#include <ff.h>
+#include <ctime>
+#include <memory>
+#include <vector>
+
+#if FF_USE_FASTSEEK
+namespace {
+// SD is the only FatFs volume in this firmware (flash is LittleFS), so it
+// is always mounted as logical drive 0
+constexpr const char* kSdFatDrive = "0:";
+constexpr DWORD kLinkMapInitialWords = 32;    // 15 fragments
+constexpr DWORD kLinkMapMaxWords = 1024;      // 4 KB, beyond that seek the slow way
+
+class SdFastSeekFile : public fs::FileImpl {
+ public:
+  ~SdFastSeekFile() override { close(); }
+
+  bool open(const char* path) {
+    path_ = path;
+    const String fatPath = String(kSdFatDrive) + path;
+    if (f_open(&fil_, fatPath.c_str(), FA_READ) != FR_OK) {
+      return false;
+    }
+    open_ = true;
+    buildLinkMap_();
+    return true;
+  }
+
+  size_t read(uint8_t* buf, size_t size) override {
+    UINT done = 0;
+    if (!open_ || f_read(&fil_, buf, size, &done) != FR_OK) {
+      return 0;
+    }
+    return done;
+  }
+
+  bool seek(uint32_t pos, SeekMode mode) override {
+    if (!open_) return false;
+    FSIZE_t target = pos;
+    if (mode == SeekCur) {
+      target = f_tell(&fil_) + pos;
+    } else if (mode == SeekEnd) {
+      target = f_size(&fil_) - pos;
+    }
+    // With a link map FatFs refuses to seek past the end instead of growing
+    if (target > f_size(&fil_)) {
+      return false;
+    }
+    return f_lseek(&fil_, target) == FR_OK;
+  }
+
+  size_t position() const override { return open_ ? f_tell(&fil_) : 0; }
+  size_t size() const override { return open_ ? f_size(&fil_) : 0; }
+
+  void close() override {
+    if (open_) {
+      f_close(&fil_);
+      open_ = false;
+    }
+    linkMap_.clear();
+    linkMap_.shrink_to_fit();
+  }
+
+  time_t getLastWrite() override {
+    FILINFO info;
+    const String fatPath = String(kSdFatDrive) + path_;
+    if (f_stat(fatPath.c_str(), &info) != FR_OK) {
+      return 0;
+    }
+    struct tm t = {};
+    t.tm_year = ((info.fdate >> 9) & 0x7F) + 80;
+    t.tm_mon = ((info.fdate >> 5) & 0x0F) - 1;
+    t.tm_mday = info.fdate & 0x1F;
+    t.tm_hour = (info.ftime >> 11) & 0x1F;
+    t.tm_min = (info.ftime >> 5) & 0x3F;
+    t.tm_sec = (info.ftime & 0x1F) * 2;
+    t.tm_isdst = -1;
+    return mktime(&t);
+  }
+
+  const char* path() const override { return path_.c_str(); }
+  const char* name() const override {
+    const int slash = path_.lastIndexOf('/');
+    return path_.c_str() + slash + 1;
+  }
+
+  // Read-only regular file
+  size_t write(const uint8_t* buf, size_t size) override { return 0; }
+  void flush() override {}
+  bool setBufferSize(size_t size) override { return false; }
+  boolean isDirectory(void) override { return false; }
+  fs::FileImplPtr openNextFile(const char* mode) override { return fs::FileImplPtr(); }
+  boolean seekDir(long position) override { return false; }
+  String getNextFileName(void) override { return String(); }
+  String getNextFileName(bool* isDir) override { return String(); }
+  void rewindDirectory(void) override {}
+  operator bool() override { return open_; }
+
+ private:
+  void buildLinkMap_() {
+    // FatFs reports the words it needs when the table is too small
+    DWORD words = kLinkMapInitialWords;
+    while (words <= kLinkMapMaxWords) {
+      linkMap_.assign(words, 0);
+      linkMap_[0] = words;
+      fil_.cltbl = linkMap_.data();
+      const FRESULT rc = f_lseek(&fil_, CREATE_LINKMAP);
+      if (rc == FR_OK) {
+        #ifdef USB_DEBUG
+          Serial.printf("[SD] fast-seek %s: %lu fragments\n", path_.c_str(),
+                        static_cast<unsigned long>((linkMap_[0] - 1) / 2));
+        #endif
+        return;
+      }
+      if (rc != FR_NOT_ENOUGH_CORE || linkMap_[0] <= words) {
+        break;
+      }
+      words = linkMap_[0];
+    }
+    fil_.cltbl = nullptr;
+    linkMap_.clear();
+    linkMap_.shrink_to_fit();
+    #ifdef USB_DEBUG
+      Serial.printf("[SD] fast-seek off for %s\n", path_.c_str());
+    #endif
+  }
+
+  FIL fil_ = {};
+  bool open_ = false;
+  String path_;
+  std::vector<DWORD> linkMap_;
+};
+}
+#endif
+
+File openSdFastSeek(const char* path) {
+#if FF_USE_FASTSEEK
+  auto impl = std::make_shared<SdFastSeekFile>();
+  if (impl->open(path)) {
+    return File(impl);
+  }
+#endif
+  return SD.open(path, FILE_READ);
+}
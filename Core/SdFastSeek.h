@@ -0,0 +1,24 @@
+#ifndef SDFASTSEEK_H
+#define SDFASTSEEK_H
+
+#include <Arduino.h>
+#include <FS.h>
+
+/**
+ * SD media files with FatFs fast-seek
+ *
+ * A plain SD File walks the FAT cluster chain from the start of the file
+ * on every backward seek, which on a fragmented card makes each GIF loop
+ * restart cost as many FAT reads as the file has clusters. Files opened
+ * here go straight to FatFs with a cluster link map (CREATE_LINKMAP) that
+ * is built once per open, so any seek is a table lookup.
+ *
+ * Fast-seek has to be compiled into FatFs (CONFIG_FATFS_USE_FASTSEEK in
+ * the core's sdkconfig). Without it, or if the direct open fails, this
+ * returns a normal SD.open handle, so callers never need to care.
+ * Read-only; the handle works wherever a File does (GIF callbacks,
+ * DeltaAnim, QOI).
+ */
+File openSdFastSeek(const char* path);
+
+#endif // SDFASTSEEK_H
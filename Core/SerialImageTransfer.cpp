@@ -10,40 +10,129 @@
 
 #include <FS.h>
 #include <LittleFS.h>
+#include <dirent.h>
+#include <sys/stat.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/queue.h>
 
 #include "Storage.h"
+#include "SlidePack.h"
+#include "ImageProbe.h"
+#include "SlideMeta.h"
+#include "Crc32.h"
+#include "UploadSink.h"
+#include "UploadResume.h"
+#include "HashCache.h"
+#include "Heatshrink.h"
+#include "DeltaSync.h"
+#include "RxRing.h"
 
 namespace SerialTransferInternal {
 
-constexpr size_t   kMaxImageSize      = 320 * 1024;   // 320 KB Sicherheitslimit
 constexpr uint32_t kTransferTimeoutMs = 15000;        // 15s Inaktivität -> Abbruch
 constexpr size_t   kChunkBufferSize   = 1024;         // Puffer für eingehende Blöcke
 constexpr size_t   kFilenameCapacity  = sizeof(SerialImageTransfer::Event::filename);
 constexpr const char* kLuaScriptsDir  = "/scripts";
 constexpr size_t   kLineBufferSize    = 160;
+constexpr size_t   kRxBufferSize      = 4096;
+// Der UART-Callback schiebt alles sofort in diesen Ring; tick() liest daraus. Ein langes
+// draw() (JPEG, Lua-Frame) füllt dann nur den Ring, statt den Treiberpuffer überlaufen
+// zu lassen. Reicht ein Rohupload (START) über den Ring hinaus, wartet der Callback,
+// und der Treiberpuffer fängt den Rest.
+constexpr size_t   kRxRingSize        = 16384;
+
+// Binärmodus (BSTART): nummerierte Blöcke mit CRC-32 statt rohem Datenstrom.
+// Rahmen: A5 5A | u16 seq | u16 len | len Bytes | u32 CRC über seq, len, Daten
+// (little-endian). Es dürfen nur so viele Blöcke unterwegs sein, wie in den
+// RX-Puffer passen; jedes ACK meldet den ersten fehlenden Block, die schon
+// vorab angekommenen Blöcke (Bitmaske) und die neue Fenstergrenze.
+constexpr uint8_t  kFrameSync0        = 0xA5;
+constexpr uint8_t  kFrameSync1        = 0x5A;
+constexpr size_t   kFramePayload      = 1024;
+constexpr size_t   kFrameOverhead     = 10;
+constexpr uint16_t kFrameWindow       = kRxBufferSize / (kFramePayload + kFrameOverhead);
+constexpr size_t   kMaxFramedSize     = 65536 * kFramePayload;  // 16-Bit-Blocknummern
+// BZSTART: heatshrink-komprimierte Blöcke; ein Block entpackt bis zu 8x, dann wird
+// so lange auf den Schreib-Task gewartet
+constexpr uint32_t kInflateSinkWaitMs = 3000;
+// BATCH <n> <bytes>: n Dateien in einer Sitzung, jede wie gewohnt mit START/BSTART/BZSTART
+// und END. Umbenannt wird im Hintergrund, während schon die nächste Datei ankommt;
+// SystemUI sieht nur ein Started- und ein Completed-Ereignis für den ganzen Stapel.
+constexpr uint16_t kMaxBatchFiles     = 1000;
+// READ/BREAD lesen so viel auf einmal; BREAD schickt den Bereich in Rahmen wie beim
+// Upload (Block 0 = offset) und zum Schluss die CRC-32 des ganzen Bereichs.
+// Pfade unter /sd/ liegen auf der SD-Karte.
+constexpr size_t   kReadBufferBytes   = 8192;
+constexpr const char* kSdReadPrefix   = "/sd/";
+// BLIST <flags> <cursor> [pfad]: Verzeichnisliste binär und seitenweise ab Eintrag cursor.
+// Antwort USB OK BLIST <einträge> <nächster cursor, 0 = fertig> <bytes>, dann ein Rahmen
+// wie bei BREAD mit den Einträgen: u8 flags | u32 size | [u32 mtime] | [u32 crc] | u8 len | name
+// (name relativ zum Startverzeichnis, Unterverzeichnisse mit '/').
+constexpr uint8_t  kListRecursive     = 0x01;  // Anfrage: Unterverzeichnisse mitnehmen
+constexpr uint8_t  kListMtime         = 0x02;  // Anfrage und Eintrag: mit Änderungszeit
+constexpr uint8_t  kListHash          = 0x04;  // Anfrage und Eintrag: mit CRC-32 (SlideMeta)
+constexpr uint8_t  kListEntryDir      = 0x01;  // Eintrag: Verzeichnis
+constexpr uint8_t  kListMaxDepth      = 8;
+constexpr size_t   kListMaxName       = 255;
 
 enum class RxState : uint8_t { Idle = 0, Receiving, AwaitEnd };
+enum class FrameState : uint8_t { Sync0 = 0, Sync1, Header, Payload, Crc };
+
+struct FrameParser {
+  FrameState state = FrameState::Sync0;
+  uint8_t header[4];   // seq, len
+  uint8_t crc[4];
+  size_t got = 0;
+  uint16_t seq = 0;
+  uint16_t len = 0;
+};
 
 struct TransferSession {
   RxState state = RxState::Idle;
-  File file;
   size_t expected = 0;
   size_t received = 0;
+  size_t base = 0;           // RESUME-Offset, ab hier zählen die Blöcke
+  bool packed = false;       // BZSTART/DELTA: expected/received zählen übertragene Bytes
+  bool delta = false;        // DELTA: Datenstrom aus Literalen und Blöcken der alten Datei
+  uint32_t deltaCrc = 0;     // angekündigte CRC-32 der neuen Fassung
+  size_t outSize = 0;        // Dateigröße nach dem Entpacken
   size_t lastNotified = 0;
   uint32_t startedAt = 0;
   uint32_t lastActivity = 0;
   bool endHintSent = false;
   bool progressPending = false;
-  uint8_t* ramBuffer = nullptr;
-  size_t ramCapacity = 0;
   char filename[kFilenameCapacity];
   char targetDir[kFilenameCapacity];
+  ImageProbe probe;
+  bool framed = false;
+  uint16_t nextSeq = 0;      // erster noch fehlender Block
+  uint32_t aheadMask = 0;    // Bit i: Block nextSeq + i liegt schon vor
+  uint16_t frameErrors = 0;
+};
+
+struct BatchSession {
+  bool active = false;
+  uint16_t files = 0;        // angekündigt
+  uint16_t done = 0;
+  uint16_t failed = 0;
+  size_t bytes = 0;          // angekündigte Übertragungsbytes aller Dateien
+  size_t received = 0;       // davon in abgeschlossenen Dateien
+  size_t stored = 0;         // Dateigrößen der fertigen Dateien
+  uint32_t lastActivity = 0;
 };
 
 QueueHandle_t gEventQueue = nullptr;
 TransferSession gSession;
+BatchSession gBatch;
+size_t gDiscardLeft = 0;       // Rest eines abgelehnten Uploads, wird verworfen
+uint32_t gDiscardActivity = 0;
+FrameParser gFrame;
+uint8_t gFramePayload[kFramePayload];
+uint8_t gFrameSlots[kFrameWindow][kFramePayload];  // vorab angekommene Blöcke, Index seq % Fenster
+UploadSink gSink;  // schreibt den Upload im Hintergrund in den Flash
+HeatshrinkDecoder gInflate;
+DeltaDecoder gDelta;
+RxRing gRxRing;
 bool gTransfersEnabled = false;
 bool gExpertMode = false;
 char gLineBuffer[kLineBufferSize];
@@ -52,6 +141,36 @@ size_t gLineLength = 0;
 void sendOk(const char* code, const char* fmt, ...);
 void sendErr(const char* code, const char* fmt, ...);
 
+// Läuft im UART-Event-Task (einziger Schreiber des Rings): Treiberpuffer leeren
+void onSerialReceive() {
+  for (;;) {
+    const int available = Serial.available();
+    if (available <= 0) {
+      return;
+    }
+    size_t room = 0;
+    uint8_t* span = gRxRing.writeSpan(&room);
+    if (room == 0) {
+      vTaskDelay(1);  // Ring voll: warten, bis tick() liest
+      continue;
+    }
+    gRxRing.commit(Serial.read(span, std::min(room, static_cast<size_t>(available))));
+  }
+}
+
+// Eingang für den Parser; ohne Ring (kein Speicher beim Start) direkt vom Treiber
+int rxAvailable() {
+  return gRxRing.ready() ? static_cast<int>(gRxRing.available()) : Serial.available();
+}
+
+int rxRead() {
+  return gRxRing.ready() ? gRxRing.read() : Serial.read();
+}
+
+size_t rxReadBytes(uint8_t* buffer, size_t len) {
+  return gRxRing.ready() ? gRxRing.read(buffer, len) : Serial.readBytes(buffer, len);
+}
+
 bool isProtectedPath(const String& path) {
   // Expert mode bypasses all protection
   if (gExpertMode) return false;
@@ -150,6 +269,7 @@ void deleteFileAtPath(const char* rawPath) {
     sendErr("DELFAIL", "%s", path.c_str());
     return;
   }
+  HashCache::forget(path);
 
   sendOk("DELETE", "%s", path.c_str());
 }
@@ -184,6 +304,21 @@ void postEvent(SerialImageTransfer::EventType type,
   xQueueSend(gEventQueue, &evt, 0);
 }
 
+// Ereignis einer einzelnen Datei; im Stapel zählt nur das Ergebnis für die Schlussmeldung
+void postFileEvent(SerialImageTransfer::EventType type,
+                   const char* filename,
+                   size_t size,
+                   const char* message) {
+  if (!gBatch.active) {
+    postEvent(type, filename, size, message);
+    return;
+  }
+  gBatch.lastActivity = millis();
+  if (type == SerialImageTransfer::EventType::Error || type == SerialImageTransfer::EventType::Aborted) {
+    ++gBatch.failed;
+  }
+}
+
 void sendFormatted(const char* prefix, const char* code, const char* fmt, va_list args) {
   Serial.print(prefix);
   Serial.print(' ');
@@ -192,7 +327,7 @@ void sendFormatted(const char* prefix, const char* code, const char* fmt, va_lis
   }
   if (fmt && fmt[0]) {
     Serial.print(' ');
-    char buffer[120];
+    char buffer[192];  // HASH mit SHA-256 und Pfad
     std::vsnprintf(buffer, sizeof(buffer), fmt, args);
     Serial.print(buffer);
   }
@@ -213,72 +348,112 @@ void sendErr(const char* code, const char* fmt = nullptr, ...) {
   va_end(args);
 }
 
-void cleanupFileOnError() {
-  if (!gSession.filename[0]) return;
-  const char* dir = gSession.targetDir[0] ? gSession.targetDir : kFlashSlidesDir;
-  String path = String(dir) + "/" + gSession.filename;
-  if (!LittleFS.exists(path)) {
-    return;
-  }
-  // Datei nur löschen, wenn sie aktuell nicht geöffnet ist. Falls open() scheitert (z. B. weil
-  // gerade eine Slideshow sie verwendet), lassen wir den unlink aus und generieren später einen
-  // neuen Dateinamen.
-  File test = LittleFS.open(path.c_str(), FILE_READ);
-  if (test) {
-    test.close();
-    LittleFS.remove(path);
+// LIST/BLIST laufen über die VFS-Schnittstelle: readdir() und stat() lesen nur die
+// Verzeichniseinträge, statt wie openNextFile() jede Datei zu öffnen
+class ListWalker {
+ public:
+  ~ListWalker() { close(); }
+
+  // devicePath wie bei LIST, "/sd/..." auf der SD-Karte
+  bool open(const String& devicePath, bool recursive) {
+    const bool sd = devicePath == "/sd" || devicePath.startsWith(kSdReadPrefix);
+    base_ = sd ? devicePath : String(kLittleFsBasePath) + (devicePath == "/" ? String() : devicePath);
+    sd_ = sd;
+    recursive_ = recursive;
+    dirs_[0] = opendir(base_.c_str());
+    depth_ = dirs_[0] ? 0 : -1;
+    rel_[0] = String();
+    pending_ = String();
+    return dirs_[0] != nullptr;
+  }
+
+  // Nächster Eintrag, name relativ zum Startverzeichnis; false am Ende
+  bool next(String* name, bool* isDir) {
+    if (pending_.length() && depth_ + 1 < kListMaxDepth) {
+      DIR* sub = opendir((base_ + "/" + pending_).c_str());
+      if (sub) {
+        dirs_[++depth_] = sub;
+        rel_[depth_] = pending_ + "/";
+      }
+    }
+    pending_ = String();
+    while (depth_ >= 0) {
+      struct dirent* entry = readdir(dirs_[depth_]);
+      if (!entry) {
+        closedir(dirs_[depth_]);
+        dirs_[depth_--] = nullptr;
+        continue;
+      }
+      if (std::strcmp(entry->d_name, ".") == 0 || std::strcmp(entry->d_name, "..") == 0) {
+        continue;
+      }
+      *name = rel_[depth_] + entry->d_name;
+      if (name->length() > kListMaxName) {
+        continue;
+      }
+      *isDir = entry->d_type == DT_DIR;
+      if (*isDir && recursive_) {
+        pending_ = *name;
+      }
+      return true;
+    }
+    return false;
   }
-}
 
-void listDirectory(const char* dirArg) {
-  String dir = (dirArg && dirArg[0]) ? String(dirArg) : String("/");
-  dir.trim();
-  if (dir.isEmpty()) dir = "/";
-  if (!dir.startsWith("/")) {
-    dir = "/" + dir;
+  bool stat(const String& name, struct stat* st) const {
+    return ::stat((base_ + "/" + name).c_str(), st) == 0;
   }
 
-  // Normalise trailing slash (except root)
-  while (dir.length() > 1 && dir.endsWith("/")) {
-    dir.remove(dir.length() - 1);
-  }
+  bool onSd() const { return sd_; }
 
-  File root = LittleFS.open(dir.c_str(), FILE_READ);
-  if (!root) {
-    sendErr("LISTOPEN", "%s", dir.c_str());
-    return;
-  }
-  if (!root.isDirectory()) {
-    root.close();
-    sendErr("LISTTYPE", "%s", dir.c_str());
-    return;
+  void close() {
+    while (depth_ >= 0) {
+      closedir(dirs_[depth_]);
+      dirs_[depth_--] = nullptr;
+    }
   }
 
-  size_t count = 0;
-  while (true) {
-    File entry = root.openNextFile();
-    if (!entry) break;
+ private:
+  DIR* dirs_[kListMaxDepth] = {};
+  String rel_[kListMaxDepth];
+  String base_;
+  String pending_;   // zuletzt geliefertes Verzeichnis, beim nächsten Aufruf betreten
+  int8_t depth_ = -1;
+  bool recursive_ = false;
+  bool sd_ = false;
+};
 
-    String name = entry.name();
-    if (name.startsWith(dir)) {
-      name = name.substring(dir.length());
-    }
-    if (name.startsWith("/")) {
-      name.remove(0, 1);
-    }
-    if (name.isEmpty()) {
-      name = entry.name();
+String listDevicePath(const char* dirArg) {
+  String dir = (dirArg && dirArg[0]) ? normalizePath(dirArg) : String("/");
+  return dir.isEmpty() ? String("/") : dir;
+}
+
+void listDirectory(const char* dirArg) {
+  const String dir = listDevicePath(dirArg);
+
+  ListWalker walker;
+  if (!walker.open(dir, false)) {
+    struct stat st;
+    const String path = dir.startsWith(kSdReadPrefix) ? dir : String(kLittleFsBasePath) + dir;
+    if (::stat(path.c_str(), &st) == 0 && !S_ISDIR(st.st_mode)) {
+      sendErr("LISTTYPE", "%s", dir.c_str());
+    } else {
+      sendErr("LISTOPEN", "%s", dir.c_str());
     }
+    return;
+  }
 
-    bool isDir = entry.isDirectory();
-    unsigned long size = isDir ? 0UL : static_cast<unsigned long>(entry.size());
+  size_t count = 0;
+  String name;
+  bool isDir = false;
+  while (walker.next(&name, &isDir)) {
+    struct stat st;
+    unsigned long size = (!isDir && walker.stat(name, &st)) ? static_cast<unsigned long>(st.st_size) : 0UL;
     sendOk("LIST", "%c %s %lu", isDir ? 'D' : 'F', name.c_str(), size);
-    entry.close();
     ++count;
     delay(0);
   }
 
-  root.close();
   sendOk("LISTDONE", "%lu", static_cast<unsigned long>(count));
 }
 
@@ -292,59 +467,82 @@ void sendFsInfo() {
          static_cast<unsigned long>(available));
 }
 
-void sendFile(const char* path) {
-  if (!path || !path[0]) {
-    sendErr("READPATH", "Kein Pfad angegeben");
-    return;
+// Lesepuffer vom Heap; ohne Speicher die Upload-Blockpuffer, beim Lesen sind sie frei
+uint8_t* acquireReadBuffer(size_t* size) {
+  uint8_t* buffer = static_cast<uint8_t*>(malloc(kReadBufferBytes));
+  if (buffer) {
+    *size = kReadBufferBytes;
+    return buffer;
   }
+  *size = sizeof(gFrameSlots);
+  return gFrameSlots[0];
+}
 
-  String filePath = String(path);
-  filePath.trim();
+void releaseReadBuffer(uint8_t* buffer) {
+  if (buffer != gFrameSlots[0]) {
+    free(buffer);
+  }
+}
 
-  // Ensure path starts with /
-  if (!filePath.startsWith("/")) {
-    filePath = "/" + filePath;
+// Öffnet eine Datei für READ/BREAD und meldet Fehler selbst
+File openForRead(const char* rawPath, String* filename) {
+  if (!rawPath || !rawPath[0]) {
+    sendErr("READPATH", "Kein Pfad angegeben");
+    return File();
+  }
+
+  String filePath = normalizePath(rawPath);
+  fs::FS* fs = &LittleFS;
+  if (filePath.startsWith(kSdReadPrefix)) {
+    fs = &SD;
+    filePath.remove(0, std::strlen(kSdReadPrefix) - 1);
   }
 
-  if (!LittleFS.exists(filePath.c_str())) {
+  if (!fs->exists(filePath.c_str())) {
     sendErr("READNOENT", "Datei nicht gefunden: %s", filePath.c_str());
-    return;
+    return File();
   }
 
-  File file = LittleFS.open(filePath.c_str(), FILE_READ);
+  File file = fs->open(filePath.c_str(), FILE_READ);
   if (!file) {
     sendErr("READOPEN", "Datei konnte nicht geoeffnet werden");
-    return;
+    return File();
   }
 
   if (file.isDirectory()) {
     file.close();
     sendErr("READDIR", "Pfad ist ein Verzeichnis");
-    return;
+    return File();
   }
 
-  size_t fileSize = file.size();
-
   // Extract filename from path
-  String filename = filePath;
-  int lastSlash = filename.lastIndexOf('/');
+  *filename = filePath;
+  int lastSlash = filename->lastIndexOf('/');
   if (lastSlash >= 0) {
-    filename = filename.substring(lastSlash + 1);
+    *filename = filename->substring(lastSlash + 1);
+  }
+  return file;
+}
+
+void sendFile(const char* path) {
+  String filename;
+  File file = openForRead(path, &filename);
+  if (!file) {
+    return;
   }
 
+  size_t fileSize = file.size();
+
   // Send header
   sendOk("READ", "%lu %s", static_cast<unsigned long>(fileSize), filename.c_str());
 
-  #ifdef USB_DEBUG
-    Serial.printf("[USB] READ %s (%lu bytes)\n", filePath.c_str(), static_cast<unsigned long>(fileSize));
-  #endif
-
-  // Send file content as raw bytes
-  uint8_t buffer[512];
+  // Send file content as raw bytes, one large read per buffer
+  size_t bufferSize = 0;
+  uint8_t* buffer = acquireReadBuffer(&bufferSize);
   size_t totalSent = 0;
 
-  while (file.available()) {
-    size_t bytesRead = file.readBytes((char*)buffer, sizeof(buffer));
+  while (totalSent < fileSize) {
+    size_t bytesRead = file.read(buffer, std::min(bufferSize, fileSize - totalSent));
     if (bytesRead == 0) break;
 
     Serial.write(buffer, bytesRead);
@@ -352,40 +550,346 @@ void sendFile(const char* path) {
     delay(0); // Yield to prevent watchdog
   }
 
+  releaseReadBuffer(buffer);
   file.close();
 
   // Send end marker
   sendOk("READEND", "%lu", static_cast<unsigned long>(totalSent));
 
   #ifdef USB_DEBUG
-    Serial.printf("[USB] READEND %lu bytes\n", static_cast<unsigned long>(totalSent));
+    Serial.printf("[USB] READ %s: %lu bytes\n", filename.c_str(), static_cast<unsigned long>(totalSent));
   #endif
 }
 
-void resetSession() {
-  if (gSession.file) {
-    gSession.file.close();
+void sendReadFrame(uint16_t seq, const uint8_t* data, size_t len) {
+  uint8_t head[6] = {kFrameSync0, kFrameSync1,
+                     static_cast<uint8_t>(seq), static_cast<uint8_t>(seq >> 8),
+                     static_cast<uint8_t>(len), static_cast<uint8_t>(len >> 8)};
+  const uint32_t crc = crc32Update(crc32Update(0, head + 2, 4), data, len);
+  const uint8_t tail[4] = {static_cast<uint8_t>(crc), static_cast<uint8_t>(crc >> 8),
+                           static_cast<uint8_t>(crc >> 16), static_cast<uint8_t>(crc >> 24)};
+  Serial.write(head, sizeof(head));
+  Serial.write(data, len);
+  Serial.write(tail, sizeof(tail));
+}
+
+// BREAD <offset> <length> <path>; length 0 = bis zum Dateiende
+void sendFileRange(const char* args) {
+  char* endPtr = nullptr;
+  const unsigned long offset = std::strtoul(args, &endPtr, 10);
+  const char* lenPtr = endPtr;
+  const unsigned long requested = std::strtoul(lenPtr, &endPtr, 10);
+  if (args == lenPtr || lenPtr == endPtr) {
+    sendErr("READFMT", "BREAD <offset> <length> <filepath>");
+    return;
   }
-  if (gSession.ramBuffer) {
-    free(gSession.ramBuffer);
-    gSession.ramBuffer = nullptr;
-    gSession.ramCapacity = 0;
+  while (*endPtr == ' ') ++endPtr;
+
+  String filename;
+  File file = openForRead(endPtr, &filename);
+  if (!file) {
+    return;
   }
-  gSession.file = File();
+
+  const size_t fileSize = file.size();
+  if (offset > fileSize || (offset > 0 && !file.seek(offset))) {
+    file.close();
+    sendErr("READRANGE", "%lu > %lu", offset, static_cast<unsigned long>(fileSize));
+    return;
+  }
+  size_t length = fileSize - offset;
+  if (requested > 0 && requested < length) {
+    length = requested;
+  }
+  if (length > kMaxFramedSize) {
+    length = kMaxFramedSize;  // 16-Bit-Blocknummern; der Host fragt den Rest einzeln an
+  }
+
+  sendOk("BREAD", "%s %lu %lu %lu %u", filename.c_str(), static_cast<unsigned long>(fileSize),
+         offset, static_cast<unsigned long>(length), static_cast<unsigned>(kFramePayload));
+
+  // Puffergröße ist ein Vielfaches der Blockgröße, Blöcke liegen also nie über zwei Lesevorgängen
+  size_t bufferSize = 0;
+  uint8_t* buffer = acquireReadBuffer(&bufferSize);
+  uint32_t rangeCrc = 0;
+  size_t sent = 0;
+  uint16_t seq = 0;
+
+  while (sent < length) {
+    const size_t want = std::min(bufferSize, length - sent);
+    const size_t bytesRead = file.read(buffer, want);
+    for (size_t pos = 0; pos < bytesRead; pos += kFramePayload) {
+      sendReadFrame(seq++, buffer + pos, std::min(kFramePayload, bytesRead - pos));
+    }
+    rangeCrc = crc32Update(rangeCrc, buffer, bytesRead);
+    sent += bytesRead;
+    if (bytesRead < want) break;  // Lesefehler; BREADEND meldet, wie weit es ging
+    delay(0);
+  }
+
+  releaseReadBuffer(buffer);
+  file.close();
+  sendOk("BREADEND", "%lu %08lx", static_cast<unsigned long>(sent), static_cast<unsigned long>(rangeCrc));
+}
+
+void putLe32(uint8_t* out, uint32_t value) {
+  out[0] = static_cast<uint8_t>(value);
+  out[1] = static_cast<uint8_t>(value >> 8);
+  out[2] = static_cast<uint8_t>(value >> 16);
+  out[3] = static_cast<uint8_t>(value >> 24);
+}
+
+// SIGS <blocksize> <path>: je Block der vorhandenen Datei u32 Rollsumme und u32 CRC-32,
+// gerahmt wie BREAD; Grundlage für DELTA. SIGSEND trägt die CRC der ganzen Datei.
+void sendSignatures(const char* args) {
+  char* endPtr = nullptr;
+  const unsigned long blockSize = std::strtoul(args, &endPtr, 10);
+  if (args == endPtr || blockSize < kDeltaMinBlock || blockSize > kDeltaMaxBlock) {
+    sendErr("SIGSFMT", "SIGS <blocksize %u-%u> <filepath>", static_cast<unsigned>(kDeltaMinBlock),
+            static_cast<unsigned>(kDeltaMaxBlock));
+    return;
+  }
+  while (*endPtr == ' ') ++endPtr;
+
+  String filename;
+  File file = openForRead(endPtr, &filename);
+  if (!file) {
+    return;
+  }
+
+  const size_t fileSize = file.size();
+  const size_t count = (fileSize + blockSize - 1) / blockSize;
+  sendOk("SIGS", "%s %lu %lu %lu %u", filename.c_str(), static_cast<unsigned long>(fileSize), blockSize,
+         static_cast<unsigned long>(count), static_cast<unsigned>(kFramePayload));
+
+  // Immer ganze Blöcke lesen; der Lesepuffer fasst mindestens einen größten Block
+  size_t bufferSize = 0;
+  uint8_t* buffer = acquireReadBuffer(&bufferSize);
+  const size_t readSize = bufferSize - bufferSize % blockSize;
+  uint8_t frame[kFramePayload];
+  size_t frameLen = 0;
+  uint16_t seq = 0;
+  uint32_t fileCrc = 0;
+  size_t blocks = 0;
+
+  while (blocks < count) {
+    const size_t bytesRead = file.read(buffer, readSize);
+    if (bytesRead == 0) break;
+    for (size_t pos = 0; pos < bytesRead; pos += blockSize) {
+      const size_t len = std::min<size_t>(blockSize, bytesRead - pos);
+      putLe32(frame + frameLen, deltaWeakSum(buffer + pos, len));
+      putLe32(frame + frameLen + 4, crc32Update(0, buffer + pos, len));
+      frameLen += 8;
+      ++blocks;
+      if (frameLen == sizeof(frame)) {
+        sendReadFrame(seq++, frame, frameLen);
+        frameLen = 0;
+      }
+    }
+    fileCrc = crc32Update(fileCrc, buffer, bytesRead);
+    if (bytesRead < readSize) break;
+    delay(0);
+  }
+  if (frameLen > 0) {
+    sendReadFrame(seq, frame, frameLen);
+  }
+
+  releaseReadBuffer(buffer);
+  file.close();
+  sendOk("SIGSEND", "%lu %08lx", static_cast<unsigned long>(blocks), static_cast<unsigned long>(fileCrc));
+}
+
+void sendBinaryList(const char* args) {
+  char* endPtr = nullptr;
+  const unsigned long flags = std::strtoul(args, &endPtr, 10);
+  const char* cursorPtr = endPtr;
+  const unsigned long cursor = std::strtoul(cursorPtr, &endPtr, 10);
+  if (args == cursorPtr || cursorPtr == endPtr) {
+    sendErr("LISTFMT", "BLIST <flags> <cursor> [directory]");
+    return;
+  }
+  while (*endPtr == ' ') ++endPtr;
+  const String dir = listDevicePath(endPtr);
+
+  ListWalker walker;
+  if (!walker.open(dir, flags & kListRecursive)) {
+    sendErr("LISTOPEN", "%s", dir.c_str());
+    return;
+  }
+
+  // CRCs gibt es nur für Slides, die mit Metadaten hochgeladen wurden
+  std::vector<SlideMeta::Checksum> checksums;
+  const String slidesDir = String(kFlashSlidesDir) + "/";
+  const String dirPrefix = (dir == "/") ? dir : dir + "/";
+  if ((flags & kListHash) && !walker.onSd() && (slidesDir.startsWith(dirPrefix) || dirPrefix == slidesDir)) {
+    SlideMeta::loadChecksums(checksums);
+  }
+
+  size_t bufferSize = 0;
+  uint8_t* buffer = acquireReadBuffer(&bufferSize);
+  size_t used = 0;
+  unsigned long index = 0;
+  unsigned long nextCursor = 0;
+  unsigned entries = 0;
+  String name;
+  bool isDir = false;
+
+  while (walker.next(&name, &isDir)) {
+    if (index++ < cursor) {
+      continue;  // frühere Seiten: nur weiterzählen, kein stat()
+    }
+    const size_t need = 1 + 4 + 4 + 4 + 1 + name.length();
+    if (used + need > bufferSize) {
+      nextCursor = index - 1;
+      break;
+    }
+
+    struct stat st;
+    const bool haveStat = (!isDir || (flags & kListMtime)) && walker.stat(name, &st);
+    uint8_t entryFlags = isDir ? kListEntryDir : 0;
+    uint8_t* record = buffer + used;
+    size_t pos = 1;
+    putLe32(record + pos, (!isDir && haveStat) ? static_cast<uint32_t>(st.st_size) : 0);
+    pos += 4;
+    if ((flags & kListMtime) && haveStat) {
+      entryFlags |= kListMtime;
+      putLe32(record + pos, static_cast<uint32_t>(st.st_mtime));
+      pos += 4;
+    }
+    uint32_t crc = 0;
+    const String path = dirPrefix + name;
+    if (!isDir && haveStat && !checksums.empty() && path.startsWith(slidesDir) &&
+        path.indexOf('/', slidesDir.length()) < 0) {
+      if (SlideMeta::findChecksum(checksums, path.c_str() + slidesDir.length(), st.st_size, &crc)) {
+        entryFlags |= kListHash;
+        putLe32(record + pos, crc);
+        pos += 4;
+      }
+    }
+    record[0] = entryFlags;
+    record[pos++] = static_cast<uint8_t>(name.length());
+    std::memcpy(record + pos, name.c_str(), name.length());
+    used += pos + name.length();
+    ++entries;
+  }
+
+  sendOk("BLIST", "%u %lu %lu", entries, nextCursor, static_cast<unsigned long>(used));
+  sendReadFrame(0, buffer, used);
+  releaseReadBuffer(buffer);
+}
+
+// HASH/HASHDIR [CRC32|SHA256] <pfad>: optionales Verfahren vor dem Pfad, Standard CRC-32
+HashCache::Algo parseHashAlgo(const char** args) {
+  HashCache::Algo algo = HashCache::Algo::Crc32;
+  if (std::strncmp(*args, "SHA256 ", 7) == 0) {
+    algo = HashCache::Algo::Sha256;
+    *args += 7;
+  } else if (std::strncmp(*args, "CRC32 ", 6) == 0) {
+    *args += 6;
+  }
+  while (**args == ' ') ++*args;
+  return algo;
+}
+
+bool isSdPath(const String& path) {
+  return path == "/sd" || path.startsWith(kSdReadPrefix);
+}
+
+// USB OK HASH <verfahren> <size> <hex> <pfad>
+bool sendHash(const String& path, HashCache::Algo algo, bool* cached) {
+  uint8_t digest[HashCache::kMaxDigest];
+  uint32_t size = 0;
+  if (!HashCache::compute(path, algo, digest, &size, cached)) {
+    return false;
+  }
+  char hex[2 * HashCache::kMaxDigest + 1];
+  const size_t len = HashCache::digestLen(algo);
+  for (size_t i = 0; i < len; ++i) {
+    std::snprintf(hex + 2 * i, 3, "%02x", digest[i]);
+  }
+  sendOk("HASH", "%s %lu %s %s", algo == HashCache::Algo::Sha256 ? "SHA256" : "CRC32",
+         static_cast<unsigned long>(size), hex, path.c_str());
+  return true;
+}
+
+void hashFile(const char* args) {
+  const HashCache::Algo algo = parseHashAlgo(&args);
+  const String path = normalizePath(args);
+  if (path.isEmpty() || isSdPath(path)) {
+    sendErr("HASHFMT", "HASH [CRC32|SHA256] <filepath>");
+    return;
+  }
+  bool cached = false;
+  if (!sendHash(path, algo, &cached)) {
+    sendErr("HASHNOENT", "%s", path.c_str());
+  }
+}
+
+// Alle Dateien unter dir, eine HASH-Zeile je Datei, dann HASHDONE <dateien> <aus dem Cache>
+void hashDirectory(const char* args) {
+  const HashCache::Algo algo = parseHashAlgo(&args);
+  const String dir = listDevicePath(args);
+  if (isSdPath(dir)) {
+    sendErr("HASHFMT", "HASHDIR [CRC32|SHA256] <directory>");
+    return;
+  }
+  ListWalker walker;
+  if (!walker.open(dir, true)) {
+    sendErr("LISTOPEN", "%s", dir.c_str());
+    return;
+  }
+
+  const String prefix = (dir == "/") ? String() : dir;
+  unsigned files = 0;
+  unsigned fromCache = 0;
+  String name;
+  bool isDir = false;
+  while (walker.next(&name, &isDir)) {
+    bool cached = false;
+    if (!isDir && sendHash(prefix + "/" + name, algo, &cached)) {
+      ++files;
+      fromCache += cached ? 1 : 0;
+    }
+  }
+  sendOk("HASHDONE", "%u %u", files, fromCache);
+}
+
+void resetSession() {
+  // Ein nicht abgeschlossener Upload verwirft seine .part-Datei bzw. den Pack-Eintrag
+  gSink.abort();
   gSession.state = RxState::Idle;
   gSession.expected = 0;
   gSession.received = 0;
+  gSession.base = 0;
+  gSession.packed = false;
+  gSession.delta = false;
+  gSession.deltaCrc = 0;
+  gSession.outSize = 0;
+  gInflate.end();
+  gDelta.end();
   gSession.lastNotified = 0;
   gSession.startedAt = 0;
   gSession.lastActivity = 0;
   gSession.endHintSent = false;
   gSession.progressPending = false;
+  gSession.framed = false;
+  gSession.nextSeq = 0;
+  gSession.aheadMask = 0;
+  gSession.frameErrors = 0;
+  gFrame = FrameParser();
   std::memset(gSession.filename, 0, sizeof(gSession.filename));
   std::memset(gSession.targetDir, 0, sizeof(gSession.targetDir));
 }
 
-bool validateSize(size_t sz) {
-  return sz > 0 && sz <= kMaxImageSize;
+bool validateSize(size_t sz, bool framed) {
+  // Keine feste Obergrenze mehr: der Upload wird gestreamt, der Platz im Flash entscheidet
+  return sz > 0 && (!framed || sz <= kMaxFramedSize);
+}
+
+size_t flashFreeBytes() {
+  const size_t total = LittleFS.totalBytes();
+  const size_t used = LittleFS.usedBytes();
+  return (total >= used) ? (total - used) : 0;
 }
 
 bool endsWithIgnoreCase(const String& value, const char* suffix) {
@@ -446,7 +950,7 @@ void generateUniqueFilename(char* out, size_t outLen, const char* dir) {
 
   String path = String(dir) + "/" + out;
   uint16_t attempt = 1;
-  while (LittleFS.exists(path) && attempt < 1000) {
+  while ((LittleFS.exists(path) || slidePack.contains(out)) && attempt < 1000) {
     std::snprintf(out, outLen, "usb_%08lu_%u.jpg",
                   static_cast<unsigned long>(now), attempt);
     path = String(dir) + "/" + out;
@@ -475,8 +979,9 @@ void ensureUniqueOnFs(char* nameBuf, size_t bufLen, const char* dir) {
     base = base.substring(0, dotIdx);
   }
 
-  String path = String(dir) + "/" + String(nameBuf);
-  if (!LittleFS.exists(path)) {
+  // Im Stapel kann eine gleichnamige Datei noch als .part auf ihr Umbenennen warten
+  const String dirPrefix = String(kFlashSlidesDir) + "/";
+  if (!slidePack.nameTaken(String(nameBuf)) && !gSink.pending(dirPrefix + nameBuf)) {
     return;
   }
 
@@ -485,8 +990,7 @@ void ensureUniqueOnFs(char* nameBuf, size_t bufLen, const char* dir) {
     if (candidate.length() >= static_cast<int>(bufLen)) {
       continue;
     }
-    path = String(dir) + "/" + candidate;
-    if (!LittleFS.exists(path)) {
+    if (!slidePack.nameTaken(candidate) && !gSink.pending(dirPrefix + candidate)) {
       std::snprintf(nameBuf, bufLen, "%s", candidate.c_str());
       return;
     }
@@ -495,21 +999,43 @@ void ensureUniqueOnFs(char* nameBuf, size_t bufLen, const char* dir) {
   generateUniqueFilename(nameBuf, bufLen, dir);
 }
 
-bool beginTransfer(size_t size, const char* requestedName, const char* targetDir = nullptr) {
+String sessionPath() {
+  const char* dir = gSession.targetDir[0] ? gSession.targetDir : kFlashSlidesDir;
+  return String(dir) + "/" + gSession.filename;
+}
+
+// Bisher erzeugte Dateibytes bei BZSTART/DELTA
+size_t unpackedBytes() {
+  return gSession.delta ? gDelta.produced() : gInflate.produced();
+}
+
+bool emitUnpacked(void* ctx, const uint8_t* data, size_t len) {
+  if (unpackedBytes() > gSession.outSize ||
+      gSink.write(data, len, pdMS_TO_TICKS(kInflateSinkWaitMs)) != len) {
+    return false;
+  }
+  return gSession.probe.feed(data, len) != ImageProbe::Verdict::Unsupported;
+}
+
+// size: übertragene Bytes; unpackedSize > 0 bei BZSTART und DELTA, dann die Dateigröße;
+// deltaBlock > 0 bei DELTA: Blockgröße aus SIGS, deltaCrc die CRC-32 der neuen Fassung
+bool beginTransfer(size_t size, const char* requestedName, const char* targetDir = nullptr,
+                   bool framed = false, bool resume = false, size_t unpackedSize = 0,
+                   size_t deltaBlock = 0, uint32_t deltaCrc = 0) {
   if (!gTransfersEnabled) {
     sendErr("DISABLED", "Modus nicht aktiv");
-    postEvent(SerialImageTransfer::EventType::Error, "", size, "USB-Modus nicht aktiv");
+    postFileEvent(SerialImageTransfer::EventType::Error, "", size, "USB-Modus nicht aktiv");
     return false;
   }
 
-  if (!validateSize(size)) {
+  const size_t outSize = unpackedSize ? unpackedSize : size;
+  if (!validateSize(size, framed) || outSize == 0) {
     sendErr("SIZE", "Ungültige Größe");
-    postEvent(SerialImageTransfer::EventType::Error, "", size, "Ungültige Dateigröße");
+    postFileEvent(SerialImageTransfer::EventType::Error, "", size, "Ungültige Dateigröße");
     return false;
   }
 
   if (gSession.state != RxState::Idle) {
-    cleanupFileOnError();
     resetSession();
   }
 
@@ -541,7 +1067,7 @@ bool beginTransfer(size_t size, const char* requestedName, const char* targetDir
 
   if (!ensureDirectory(dirC)) {
     sendErr("DIRFAIL", "Verzeichnis konnte nicht erstellt werden");
-    postEvent(SerialImageTransfer::EventType::Error, "", size, "Verzeichnis-Fehler");
+    postFileEvent(SerialImageTransfer::EventType::Error, "", size, "Verzeichnis-Fehler");
     return false;
   }
 
@@ -549,68 +1075,131 @@ bool beginTransfer(size_t size, const char* requestedName, const char* targetDir
     generateUniqueFilename(filename, sizeof(filename), dirC);
     filenameStr = String(filename);
   }
-  ensureUniqueOnFs(filename, sizeof(filename), dirC);
+  if (!deltaBlock) {
+    ensureUniqueOnFs(filename, sizeof(filename), dirC);  // DELTA ersetzt die Datei gerade absichtlich
+  }
 
-  if (size <= kMaxImageSize) {
-    uint8_t* buffer = static_cast<uint8_t*>(malloc(size));
-    if (buffer) {
-      gSession.ramBuffer = buffer;
-      gSession.ramCapacity = size;
-    }
+  SlideMediaType packType;
+  const bool toPack = SlidePack::enabledForUploads() && std::strcmp(dirC, kFlashSlidesDir) == 0 &&
+                      slideMediaTypeFor(filename, &packType);
+
+  // RESUME: Teil aus einem abgebrochenen Upload fortsetzen (nur Einzeldateien, nicht im Pack)
+  const String path = String(dirC) + "/" + filename;
+  if (deltaBlock && (toPack || !LittleFS.exists(path))) {
+    sendErr("DELTABASE", "Keine alte Fassung: %s", path.c_str());
+    postFileEvent(SerialImageTransfer::EventType::Error, filename, size, "Keine alte Fassung");
+    return false;
+  }
+  gSession.probe.begin(filename);
+  uint32_t resumeCrc = 0;
+  size_t offset = 0;
+  if (!toPack && resume) {
+    offset = UploadResume::load(path, size, gSession.probe, &resumeCrc);
+  } else if (!toPack) {
+    UploadResume::forget(path);
+  }
+  if (offset == 0) {
+    gSession.probe.begin(filename);
+  }
+  if (!toPack && outSize - offset > flashFreeBytes()) {
+    sendErr("SPACE", "Zu wenig Flash-Speicher");
+    postFileEvent(SerialImageTransfer::EventType::Error, filename, size, "Zu wenig Flash-Speicher");
+    return false;
   }
 
-  if (!gSession.ramBuffer) {
-    String path = String(dirC) + "/" + filename;
-    gSession.file = LittleFS.open(path.c_str(), FILE_WRITE);
-    if (!gSession.file) {
-      sendErr("OPEN", "Datei konnte nicht angelegt werden");
-      postEvent(SerialImageTransfer::EventType::Error, filename, size, "Datei konnte nicht angelegt werden");
-      return false;
-    }
+  const bool opened = toPack ? gSink.beginPack(filename, packType, outSize) : gSink.beginFile(path, offset);
+  if (!opened) {
+    sendErr("OPEN", "Datei konnte nicht angelegt werden");
+    postFileEvent(SerialImageTransfer::EventType::Error, filename, size, "Datei konnte nicht angelegt werden");
+    return false;
   }
 
-  gSession.state = RxState::Receiving;
+  if (deltaBlock && !gDelta.begin(LittleFS.open(path, FILE_READ), deltaBlock, emitUnpacked, nullptr)) {
+    gSink.abort();
+    sendErr("DELTABASE", "Alte Fassung nicht lesbar");
+    postFileEvent(SerialImageTransfer::EventType::Error, filename, size, "Alte Fassung nicht lesbar");
+    return false;
+  }
+  if (unpackedSize && !deltaBlock && !gInflate.begin(emitUnpacked, nullptr)) {
+    gSink.abort();
+    sendErr("RAM", "Kein Speicher zum Entpacken");
+    postFileEvent(SerialImageTransfer::EventType::Error, filename, size, "Kein Speicher zum Entpacken");
+    return false;
+  }
+
+  gSession.state = (offset < size) ? RxState::Receiving : RxState::AwaitEnd;
   gSession.expected = size;
-  gSession.received = 0;
-  gSession.lastNotified = 0;
+  gSession.received = offset;
+  gSession.base = offset;
+  gSession.lastNotified = offset;
   gSession.startedAt = millis();
   gSession.lastActivity = gSession.startedAt;
   gSession.endHintSent = false;
   gSession.progressPending = false;
   std::snprintf(gSession.filename, sizeof(gSession.filename), "%s", filename);
   std::snprintf(gSession.targetDir, sizeof(gSession.targetDir), "%s", resolvedDir.c_str());
-
-  sendOk("START", "%s %lu", gSession.filename, static_cast<unsigned long>(size));
+  gSession.packed = unpackedSize > 0;
+  gSession.delta = deltaBlock > 0;
+  gSession.deltaCrc = deltaCrc;
+  gSession.outSize = outSize;
+  gSession.framed = framed;
+  gSession.nextSeq = 0;
+  gSession.aheadMask = 0;
+  gSession.frameErrors = 0;
+  gFrame = FrameParser();
+  gDiscardLeft = 0;
+
+  if (gSession.delta) {
+    sendOk("DELTA", "%s %lu %lu %u %u", gSession.filename, static_cast<unsigned long>(outSize),
+           static_cast<unsigned long>(size), static_cast<unsigned>(kFramePayload),
+           static_cast<unsigned>(kFrameWindow));
+  } else if (gSession.packed) {
+    sendOk("BZSTART", "%s %lu %lu %u %u %u %u", gSession.filename, static_cast<unsigned long>(outSize),
+           static_cast<unsigned long>(size), static_cast<unsigned>(kFramePayload),
+           static_cast<unsigned>(kFrameWindow), static_cast<unsigned>(kHeatshrinkWindowBits),
+           static_cast<unsigned>(kHeatshrinkLookaheadBits));
+  } else if (resume && framed) {
+    sendOk("BRESUME", "%s %lu %lu %08lx %u %u", gSession.filename, static_cast<unsigned long>(size),
+           static_cast<unsigned long>(offset), static_cast<unsigned long>(resumeCrc),
+           static_cast<unsigned>(kFramePayload), static_cast<unsigned>(kFrameWindow));
+  } else if (resume) {
+    sendOk("RESUME", "%s %lu %lu %08lx", gSession.filename, static_cast<unsigned long>(size),
+           static_cast<unsigned long>(offset), static_cast<unsigned long>(resumeCrc));
+  } else if (framed) {
+    sendOk("BSTART", "%s %lu %u %u", gSession.filename, static_cast<unsigned long>(size),
+           static_cast<unsigned>(kFramePayload), static_cast<unsigned>(kFrameWindow));
+  } else {
+    sendOk("START", "%s %lu", gSession.filename, static_cast<unsigned long>(size));
+  }
 
   char msg[96];
   std::snprintf(msg, sizeof(msg), "USB Empfang: %s (%lu B)",
                 gSession.filename,
                 static_cast<unsigned long>(size));
-  postEvent(SerialImageTransfer::EventType::Started, gSession.filename, size, msg);
+  postFileEvent(SerialImageTransfer::EventType::Started, gSession.filename, size, msg);
 
   #ifdef USB_DEBUG
-    Serial.printf("[USB] START %s (%lu bytes)\n", gSession.filename, static_cast<unsigned long>(size));
+    Serial.printf("[USB] START %s (%lu bytes, from %lu)\n", gSession.filename,
+                  static_cast<unsigned long>(size), static_cast<unsigned long>(offset));
   #endif
   return true;
 }
 
-void abortTransfer(const char* reason, SerialImageTransfer::EventType evtType) {
+void abortTransfer(const char* reason, SerialImageTransfer::EventType evtType, const char* detail = nullptr) {
   if (gSession.state == RxState::Idle) return;
 
-  if (gSession.file) {
-    gSession.file.close();
-    gSession.file = File();
-  }
-
-  cleanupFileOnError();
   char fname[sizeof(gSession.filename)];
   std::snprintf(fname, sizeof(fname), "%s", gSession.filename);
   size_t received = gSession.received;
 
   resetSession();
 
-  sendErr(reason ? reason : "ABORT");
-  postEvent(evtType, fname, received, reason ? reason : "");
+  if (detail) {
+    sendErr(reason ? reason : "ABORT", "%s", detail);
+  } else {
+    sendErr(reason ? reason : "ABORT");
+  }
+  postFileEvent(evtType, fname, received, detail ? detail : (reason ? reason : ""));
   #ifdef USB_DEBUG
     Serial.printf("[USB] ABORT (%s) after %lu bytes\n",
                   reason ? reason : "no-reason",
@@ -618,58 +1207,125 @@ void abortTransfer(const char* reason, SerialImageTransfer::EventType evtType) {
   #endif
 }
 
+// Timeout oder Modus aus: den geschriebenen Teil für RESUME behalten
+void suspendTransfer(const char* reason) {
+  if (gSession.state == RxState::Idle) return;
+  char detail[48];
+  detail[0] = '\0';
+  // Entpacken lässt sich nicht mitten im Strom fortsetzen
+  if (gSession.received > 0 && gSink.resumable() && !gSession.packed) {
+    const String path = sessionPath();
+    if (gSink.suspend() &&
+        UploadResume::save(path, gSession.expected, gSession.received, gSession.probe.crc())) {
+      std::snprintf(detail, sizeof(detail), "fortsetzbar ab %lu",
+                    static_cast<unsigned long>(gSession.received));
+    }
+  }
+  abortTransfer(reason, SerialImageTransfer::EventType::Aborted, detail[0] ? detail : nullptr);
+}
+
+// Upload, den die Decoder nicht anzeigen könnten: abbrechen, Rest verwerfen
+void rejectUnsupported() {
+  char detail[48];
+  std::snprintf(detail, sizeof(detail), "%s", gSession.probe.reason());
+  size_t rest = (gSession.expected > gSession.received) ? gSession.expected - gSession.received : 0;
+  if (gSession.framed) {
+    // Der Host hört nach dem ERR auf; unterwegs ist höchstens ein Fenster
+    rest = std::min<size_t>(rest + kFrameOverhead * kFrameWindow,
+                            (kFramePayload + kFrameOverhead) * kFrameWindow);
+  }
+  abortTransfer("FORMAT", SerialImageTransfer::EventType::Error, detail);
+  gDiscardLeft = rest;
+  gDiscardActivity = millis();
+}
+
+void discardRejected() {
+  if (millis() - gDiscardActivity > kTransferTimeoutMs) {
+    gDiscardLeft = 0;
+    return;
+  }
+  uint8_t scratch[256];
+  while (gDiscardLeft > 0) {
+    const int available = rxAvailable();
+    if (available <= 0) {
+      return;
+    }
+    const size_t chunk = std::min<size_t>(std::min<size_t>(sizeof(scratch), gDiscardLeft),
+                                          static_cast<size_t>(available));
+    const size_t readCount = rxReadBytes(scratch, chunk);
+    if (readCount == 0) {
+      return;
+    }
+    gDiscardLeft -= readCount;
+    gDiscardActivity = millis();
+  }
+}
+
 void completeTransfer() {
   if (gSession.state != RxState::AwaitEnd) {
     sendErr("NOACTIVE", "Kein aktiver Transfer");
     return;
   }
+  if (gSession.probe.finish() == ImageProbe::Verdict::Unsupported) {
+    rejectUnsupported();
+    return;
+  }
+  if (gSession.delta) {
+    // Die alte Fassung schließen, bevor die neue sie ersetzt. Passt die CRC nicht
+    // (Datei seit SIGS geändert, Kollision), bleibt die alte Fassung stehen.
+    gDelta.end();
+    if (gSession.probe.crc() != gSession.deltaCrc) {
+      abortTransfer("DELTACRC", SerialImageTransfer::EventType::Error, "Prüfsumme passt nicht");
+      return;
+    }
+  }
 
   char fname[sizeof(gSession.filename)];
   std::snprintf(fname, sizeof(fname), "%s", gSession.filename);
   const char* dir = gSession.targetDir[0] ? gSession.targetDir : kFlashSlidesDir;
   size_t received = gSession.received;
   size_t expected = gSession.expected;
+  size_t fileSize = gSession.outSize;
   bool progressPending = gSession.progressPending;
-  uint8_t* ramPtr = gSession.ramBuffer;
-  bool ramMode = (ramPtr != nullptr);
-
-  if (ramMode) {
-    String path = String(dir) + "/" + fname;
-    File out = LittleFS.open(path.c_str(), FILE_WRITE);
-    if (!out) {
-      sendErr("FLASH", "Datei konnte nicht angelegt werden");
-      resetSession();
-      return;
-    }
-    size_t offset = 0;
-    while (offset < received) {
-      size_t chunk = std::min<size_t>(512, received - offset);
-      size_t written = out.write(ramPtr + offset, chunk);
-      if (written != chunk) {
-        out.close();
-        LittleFS.remove(path);
-        sendErr("FLASH", "Schreibfehler");
-        resetSession();
-        return;
-      }
-      offset += written;
-      delay(0);
-    }
-    out.close();
-  } else if (gSession.file) {
-    gSession.file.close();
-    gSession.file = File();
+
+  // Restpuffer schreiben, dann .part umbenennen bzw. Pack-Eintrag übernehmen.
+  // Im Stapel erledigt das der Schreib-Task, während schon die nächste Datei kommt;
+  // ein Fehler dabei erscheint in BATCHEND.
+  const bool toFile = gSink.resumable();
+  const String path = sessionPath();
+  if (toFile) {
+    HashCache::forget(path);
+  }
+  if (!(gBatch.active ? gSink.finishAsync() : gSink.finish())) {
+    sendErr("FLASH", "Schreibfehler");
+    postFileEvent(SerialImageTransfer::EventType::Error, fname, fileSize, "Schreibfehler");
+    resetSession();
+    return;
+  }
+  UploadResume::forget(path);
+  // Die CRC der ganzen Datei fällt beim Prüfen ohnehin an; im Stapel steht die Datei noch nicht da
+  if (toFile && !gBatch.active) {
+    HashCache::remember(path, gSession.probe.crc());
+  }
+
+  if (std::strcmp(dir, kFlashSlidesDir) == 0 && gSession.probe.isMedia()) {
+    SlideMeta::record(fname, fileSize, gSession.probe);
   }
 
   resetSession();
+  if (gBatch.active) {
+    ++gBatch.done;
+    gBatch.received += received;
+    gBatch.stored += fileSize;
+  }
 
   if (progressPending) {
     sendOk("PROG", "%lu %lu",
            static_cast<unsigned long>(received),
            static_cast<unsigned long>(expected));
   }
-  sendOk("END", "%s %lu", fname, static_cast<unsigned long>(received));
-  postEvent(SerialImageTransfer::EventType::Completed, fname, received, "USB Übertragung abgeschlossen");
+  sendOk("END", "%s %lu", fname, static_cast<unsigned long>(fileSize));
+  postFileEvent(SerialImageTransfer::EventType::Completed, fname, fileSize, "USB Übertragung abgeschlossen");
   #ifdef USB_DEBUG
     Serial.printf("[USB] COMPLETE %s (%lu bytes)\n",
                   fname,
@@ -677,12 +1333,242 @@ void completeTransfer() {
   #endif
 }
 
+void beginBatch(unsigned long files, unsigned long bytes) {
+  if (!gTransfersEnabled) {
+    sendErr("DISABLED", "Modus nicht aktiv");
+    return;
+  }
+  if (gBatch.active || gSession.state != RxState::Idle) {
+    sendErr("BATCHBUSY", "Transfer aktiv");
+    return;
+  }
+  if (files == 0 || files > kMaxBatchFiles) {
+    sendErr("BATCHFMT", "BATCH <files> <bytes>");
+    return;
+  }
+
+  gBatch = BatchSession();
+  gBatch.active = true;
+  gBatch.files = static_cast<uint16_t>(files);
+  gBatch.bytes = bytes;
+  gBatch.lastActivity = millis();
+  sendOk("BATCH", "%u %lu", gBatch.files, bytes);
+
+  char name[kFilenameCapacity];
+  std::snprintf(name, sizeof(name), "%u Dateien", gBatch.files);
+  char msg[96];
+  std::snprintf(msg, sizeof(msg), "USB Empfang: %u Dateien (%lu B)", gBatch.files, bytes);
+  postEvent(SerialImageTransfer::EventType::Started, name, bytes, msg);
+  #ifdef USB_DEBUG
+    Serial.printf("[USB] BATCH %u files, %lu bytes\n", gBatch.files, bytes);
+  #endif
+}
+
+// BATCHEND vom Host (reason == nullptr), Timeout oder Modus aus
+void finishBatch(const char* reason) {
+  if (!gBatch.active) return;
+  if (gSession.state != RxState::Idle) {
+    abortTransfer(reason ? reason : "INCOMPLETE", SerialImageTransfer::EventType::Aborted);
+  }
+  // Auf die letzten Umbenennungen warten; was dabei scheitert, war doch nicht fertig
+  const uint16_t lost = std::min(gSink.settle(), gBatch.done);
+  const BatchSession batch = gBatch;
+  gBatch = BatchSession();
+
+  const uint16_t done = batch.done - lost;
+  const uint16_t failed = batch.failed + lost;
+  const uint16_t missing = (batch.files > done + failed) ? batch.files - done - failed : 0;
+  char name[kFilenameCapacity];
+  std::snprintf(name, sizeof(name), "%u Dateien", done);
+
+  if (!reason && failed == 0 && missing == 0) {
+    sendOk("BATCHEND", "%u %lu", done, static_cast<unsigned long>(batch.stored));
+    postEvent(SerialImageTransfer::EventType::Completed, name, batch.stored, "USB Übertragung abgeschlossen");
+  } else {
+    sendErr(reason ? reason : "BATCHEND", "%u %u %u", done, failed, missing);
+    char msg[96];
+    std::snprintf(msg, sizeof(msg), "%u von %u Dateien fehlgeschlagen", failed + missing, batch.files);
+    postEvent(reason ? SerialImageTransfer::EventType::Aborted : SerialImageTransfer::EventType::Error,
+              name, batch.stored, msg);
+  }
+  #ifdef USB_DEBUG
+    Serial.printf("[USB] BATCHEND %u ok, %u failed, %u missing\n", done, failed, missing);
+  #endif
+}
+
+// Nutzdaten in Dateireihenfolge: bei BZSTART erst entpacken, bei DELTA aus der alten
+// Fassung zusammensetzen, dann Prüfung und Flash.
+// False, wenn der Upload dabei abgebrochen wurde.
+bool storeBlock(const uint8_t* data, size_t len) {
+  gSession.received += len;
+  if (gSession.packed) {
+    if (gSession.delta ? gDelta.feed(data, len) : gInflate.feed(data, len)) {
+      return true;
+    }
+    if (gSession.probe.verdict() == ImageProbe::Verdict::Unsupported) {
+      rejectUnsupported();
+    } else if (gSink.failed()) {
+      abortTransfer("WRITE", SerialImageTransfer::EventType::Error);
+    } else {
+      abortTransfer(gSession.delta ? "DELTA" : "INFLATE", SerialImageTransfer::EventType::Error);
+    }
+    return false;
+  }
+  if (gSink.write(data, len) != len) {
+    abortTransfer("WRITE", SerialImageTransfer::EventType::Error);
+    return false;
+  }
+  if (gSession.probe.feed(data, len) == ImageProbe::Verdict::Unsupported) {
+    rejectUnsupported();
+    return false;
+  }
+  return true;
+}
+
+void sendAck() {
+  sendOk("ACK", "%u %lx %u", gSession.nextSeq, static_cast<unsigned long>(gSession.aheadMask),
+         static_cast<unsigned>(gSession.nextSeq + kFrameWindow));
+}
+
+void handleFrame() {
+  uint32_t crc = crc32Update(0, gFrame.header, sizeof(gFrame.header));
+  crc = crc32Update(crc, gFramePayload, gFrame.len);
+  const uint32_t sent = static_cast<uint32_t>(gFrame.crc[0]) | (static_cast<uint32_t>(gFrame.crc[1]) << 8) |
+                        (static_cast<uint32_t>(gFrame.crc[2]) << 16) | (static_cast<uint32_t>(gFrame.crc[3]) << 24);
+  if (crc != sent) {
+    ++gSession.frameErrors;
+    sendAck();
+    return;
+  }
+  if (gFrame.len == 0) {
+    abortTransfer("REMOTE", SerialImageTransfer::EventType::Aborted);
+    return;
+  }
+
+  // Duplikate und Blöcke ohne Kredit nur quittieren
+  const uint16_t seq = gFrame.seq;
+  const size_t offset = static_cast<size_t>(seq) * kFramePayload;
+  const size_t frameBytes = gSession.expected - gSession.base;
+  if (seq < gSession.nextSeq || seq >= gSession.nextSeq + kFrameWindow || offset >= frameBytes) {
+    sendAck();
+    return;
+  }
+  const uint32_t bit = 1u << (seq - gSession.nextSeq);
+  if ((gSession.aheadMask & bit) || gFrame.len != std::min(kFramePayload, frameBytes - offset)) {
+    sendAck();
+    return;
+  }
+  if (seq != gSession.nextSeq) {
+    // Vorgezogener Block wartet im Fenster, bis die Lücke davor gefüllt ist
+    std::memcpy(gFrameSlots[seq % kFrameWindow], gFramePayload, gFrame.len);
+    gSession.aheadMask |= bit;
+    sendAck();
+    return;
+  }
+
+  // Dieser Block, dann alle lückenlos folgenden aus dem Fenster
+  const uint8_t* block = gFramePayload;
+  gSession.aheadMask |= 1u;
+  while (gSession.aheadMask & 1u) {
+    const size_t blockOffset = static_cast<size_t>(gSession.nextSeq) * kFramePayload;
+    const size_t blockLen = std::min(kFramePayload, frameBytes - blockOffset);
+    gSession.aheadMask >>= 1;
+    ++gSession.nextSeq;
+    if (!storeBlock(block, blockLen)) {
+      return;
+    }
+    block = gFrameSlots[gSession.nextSeq % kFrameWindow];
+  }
+
+  if (gSession.received >= gSession.expected) {
+    gSession.state = RxState::AwaitEnd;
+    gSession.endHintSent = true;
+    gSession.progressPending = true;
+    #ifdef USB_DEBUG
+      Serial.printf("[USB] framed upload complete, %u bad frames\n", gSession.frameErrors);
+    #endif
+  }
+  sendAck();
+}
+
+void processFrames() {
+  while (gSession.state == RxState::Receiving) {
+    // Erst weiterlesen, wenn ein ganzes Fenster in den Schreibpuffer passt;
+    // bis dahin staut sich der Rest im RX-Puffer bzw. beim Host
+    if (gSink.space() < kFramePayload * kFrameWindow) {
+      return;
+    }
+    const int available = rxAvailable();
+    if (available <= 0) {
+      return;
+    }
+    gSession.lastActivity = millis();
+
+    switch (gFrame.state) {
+      case FrameState::Sync0:
+        if (rxRead() == kFrameSync0) {
+          gFrame.state = FrameState::Sync1;
+        }
+        break;
+      case FrameState::Sync1: {
+        const int b = rxRead();
+        if (b == kFrameSync1) {
+          gFrame.got = 0;
+          gFrame.state = FrameState::Header;
+        } else if (b != kFrameSync0) {
+          gFrame.state = FrameState::Sync0;
+        }
+        break;
+      }
+      case FrameState::Header:
+        gFrame.header[gFrame.got++] = static_cast<uint8_t>(rxRead());
+        if (gFrame.got == sizeof(gFrame.header)) {
+          gFrame.seq = static_cast<uint16_t>(gFrame.header[0] | (gFrame.header[1] << 8));
+          gFrame.len = static_cast<uint16_t>(gFrame.header[2] | (gFrame.header[3] << 8));
+          gFrame.got = 0;
+          if (gFrame.len > kFramePayload) {
+            ++gSession.frameErrors;  // falscher Sync im Datenstrom
+            gFrame.state = FrameState::Sync0;
+          } else {
+            gFrame.state = gFrame.len ? FrameState::Payload : FrameState::Crc;
+          }
+        }
+        break;
+      case FrameState::Payload: {
+        const size_t chunk = std::min<size_t>(gFrame.len - gFrame.got, static_cast<size_t>(available));
+        gFrame.got += rxReadBytes(gFramePayload + gFrame.got, chunk);
+        if (gFrame.got == gFrame.len) {
+          gFrame.got = 0;
+          gFrame.state = FrameState::Crc;
+        }
+        break;
+      }
+      case FrameState::Crc:
+        gFrame.crc[gFrame.got++] = static_cast<uint8_t>(rxRead());
+        if (gFrame.got == sizeof(gFrame.crc)) {
+          gFrame.state = FrameState::Sync0;
+          gFrame.got = 0;
+          handleFrame();
+        }
+        break;
+    }
+  }
+}
+
 void processData() {
   if (gSession.state != RxState::Receiving) return;
-  if (!gSession.file && !gSession.ramBuffer) {
+  if (!gSink.active()) {
     abortTransfer("NOFILE", SerialImageTransfer::EventType::Error);
     return;
   }
+  if (gSink.failed()) {
+    abortTransfer("WRITE", SerialImageTransfer::EventType::Error);
+    return;
+  }
+  if (gSession.framed) {
+    processFrames();
+    return;
+  }
 
   size_t remaining = (gSession.expected > gSession.received)
                      ? (gSession.expected - gSession.received)
@@ -692,37 +1578,26 @@ void processData() {
     return;
   }
 
-  int available = Serial.available();
+  int available = rxAvailable();
   if (available <= 0) {
     return;
   }
-  size_t toRead = std::min<size_t>(remaining, static_cast<size_t>(available));
+  // Nur so viel lesen, wie der Schreibpuffer gerade aufnimmt
+  size_t toRead = std::min<size_t>(std::min<size_t>(remaining, static_cast<size_t>(available)),
+                                   gSink.space());
 
   uint8_t buffer[1024];
   while (toRead > 0) {
     size_t chunk = std::min<size_t>(sizeof(buffer), toRead);
-    size_t readCount = Serial.readBytes(buffer, chunk);
+    size_t readCount = rxReadBytes(buffer, chunk);
     if (readCount == 0) {
       break;
     }
-    if (gSession.ramBuffer) {
-      if (gSession.received + readCount > gSession.ramCapacity) {
-        abortTransfer("RAM", SerialImageTransfer::EventType::Error);
-        return;
-      }
-      std::memcpy(gSession.ramBuffer + gSession.received, buffer, readCount);
-      gSession.received += readCount;
-      toRead -= readCount;
-    } else {
-      size_t written = gSession.file.write(buffer, readCount);
-      if (written != readCount) {
-        abortTransfer("WRITE", SerialImageTransfer::EventType::Error);
-        return;
-      }
-      gSession.received += written;
-      toRead -= written;
-    }
+    toRead -= readCount;
     gSession.lastActivity = millis();
+    if (!storeBlock(buffer, readCount)) {
+      return;
+    }
   }
 
   if (gSession.received >= gSession.expected) {
@@ -741,8 +1616,17 @@ void processLine(const char* line) {
     return;
   }
 
-  if (strncmp(line, "START", 5) == 0) {
-    const char* ptr = line + 5;
+  // START/BSTART beginnen neu, RESUME/BRESUME setzen einen abgebrochenen Upload fort,
+  // BZSTART <komprimiert> <size> ... überträgt heatshrink-komprimiert,
+  // DELTA <delta> <size> <crc> <blocksize> ... nur die Änderungen gegenüber SIGS
+  const bool framedStart = std::strncmp(line, "BSTART", 6) == 0;
+  const bool framedResume = std::strncmp(line, "BRESUME", 7) == 0;
+  const bool packedStart = std::strncmp(line, "BZSTART", 7) == 0;
+  const bool deltaStart = std::strncmp(line, "DELTA", 5) == 0;
+  const bool resume = framedResume || std::strncmp(line, "RESUME", 6) == 0;
+  if (framedStart || resume || packedStart || deltaStart || strncmp(line, "START", 5) == 0) {
+    const char* ptr = line;
+    while (*ptr && *ptr != ' ') ++ptr;
     while (*ptr == ' ') ++ptr;
     if (!*ptr) {
       sendErr("STARTFMT", "START <size> [name] [directory]");
@@ -754,6 +1638,30 @@ void processLine(const char* line) {
       sendErr("STARTFMT", "Ungültige Größe");
       return;
     }
+    unsigned long unpacked = 0;
+    if (packedStart) {
+      const char* sizePtr = endPtr;
+      unpacked = std::strtoul(sizePtr, &endPtr, 10);
+      if (sizePtr == endPtr || unpacked == 0) {
+        sendErr("STARTFMT", "BZSTART <packed> <size> [name] [directory]");
+        return;
+      }
+    }
+    unsigned long deltaCrc = 0;
+    unsigned long deltaBlock = 0;
+    if (deltaStart) {
+      const char* sizePtr = endPtr;
+      unpacked = std::strtoul(sizePtr, &endPtr, 10);
+      const char* crcPtr = endPtr;
+      deltaCrc = std::strtoul(crcPtr, &endPtr, 16);
+      const char* blockPtr = endPtr;
+      deltaBlock = std::strtoul(blockPtr, &endPtr, 10);
+      if (sizePtr == crcPtr || crcPtr == blockPtr || blockPtr == endPtr || unpacked == 0 ||
+          deltaBlock < kDeltaMinBlock || deltaBlock > kDeltaMaxBlock) {
+        sendErr("STARTFMT", "DELTA <delta> <size> <crc> <blocksize> name [directory]");
+        return;
+      }
+    }
 
     // Parse filename (second argument)
     while (endPtr && *endPtr == ' ') ++endPtr;
@@ -774,7 +1682,54 @@ void processLine(const char* line) {
     while (*nameEnd == ' ') ++nameEnd;
     const char* dir = (*nameEnd) ? nameEnd : nullptr;
 
-    beginTransfer(static_cast<size_t>(sz), name, dir);
+    beginTransfer(static_cast<size_t>(sz), name, dir, framedStart || framedResume || packedStart || deltaStart,
+                  resume, static_cast<size_t>(unpacked), static_cast<size_t>(deltaBlock),
+                  static_cast<uint32_t>(deltaCrc));
+    return;
+  }
+
+  if (std::strcmp(line, "BATCHEND") == 0) {
+    if (!gBatch.active) {
+      sendErr("NOBATCH", "Kein aktiver Stapel");
+      return;
+    }
+    finishBatch(nullptr);
+    return;
+  }
+
+  if (std::strncmp(line, "BATCH", 5) == 0) {
+    char* endPtr = nullptr;
+    const unsigned long files = std::strtoul(line + 5, &endPtr, 10);
+    const unsigned long bytes = std::strtoul(endPtr, nullptr, 10);
+    beginBatch(files, bytes);
+    return;
+  }
+
+  if (std::strncmp(line, "BLIST", 5) == 0) {
+    const char* ptr = line + 5;
+    while (*ptr == ' ') ++ptr;
+    sendBinaryList(ptr);
+    return;
+  }
+
+  if (std::strncmp(line, "SIGS", 4) == 0) {
+    const char* ptr = line + 4;
+    while (*ptr == ' ') ++ptr;
+    sendSignatures(ptr);
+    return;
+  }
+
+  if (std::strncmp(line, "HASHDIR", 7) == 0) {
+    const char* ptr = line + 7;
+    while (*ptr == ' ') ++ptr;
+    hashDirectory(ptr);
+    return;
+  }
+
+  if (std::strncmp(line, "HASH", 4) == 0) {
+    const char* ptr = line + 4;
+    while (*ptr == ' ') ++ptr;
+    hashFile(ptr);
     return;
   }
 
@@ -790,7 +1745,8 @@ void processLine(const char* line) {
       sendErr("NOACTIVE", "Kein aktiver Transfer");
       return;
     }
-    if (gSession.received != gSession.expected) {
+    if (gSession.received != gSession.expected ||
+        (gSession.packed && unpackedBytes() != gSession.outSize)) {
       abortTransfer("INCOMPLETE", SerialImageTransfer::EventType::Error);
       return;
     }
@@ -838,6 +1794,13 @@ void processLine(const char* line) {
     return;
   }
 
+  if (std::strncmp(line, "BREAD", 5) == 0) {
+    const char* ptr = line + 5;
+    while (*ptr == ' ') ++ptr;
+    sendFileRange(ptr);
+    return;
+  }
+
   if (std::strncmp(line, "READ", 4) == 0) {
     const char* ptr = line + 4;
     while (*ptr == ' ') ++ptr;
@@ -878,9 +1841,15 @@ void processIncoming() {
     processData();
     return;
   }
+  if (gDiscardLeft > 0) {
+    discardRejected();
+    if (gDiscardLeft > 0) {
+      return;
+    }
+  }
 
-  while (Serial.available() > 0) {
-    int byteVal = Serial.read();
+  while (rxAvailable() > 0) {
+    int byteVal = rxRead();
     if (byteVal < 0) break;
     char c = static_cast<char>(byteVal);
     if (c == '\r') continue;
@@ -905,7 +1874,16 @@ void processIncoming() {
 namespace SerialImageTransfer {
 
 void begin() {
-  Serial.setRxBufferSize(4096);
+  Serial.setRxBufferSize(SerialTransferInternal::kRxBufferSize);
+  if (SerialTransferInternal::gRxRing.begin(SerialTransferInternal::kRxRingSize)) {
+    // Was schon im Treiber liegt, zuerst übernehmen; danach ist der Callback der einzige Schreiber
+    SerialTransferInternal::onSerialReceive();
+    Serial.onReceive(SerialTransferInternal::onSerialReceive);
+  } else {
+    #ifdef USB_DEBUG
+      Serial.println("[USB] no RAM for RX ring, polling the UART");
+    #endif
+  }
   SerialTransferInternal::ensureQueue();
   SerialTransferInternal::gLineLength = 0;
   SerialTransferInternal::resetSession();
@@ -914,7 +1892,8 @@ void begin() {
 void tick() {
   if (!SerialTransferInternal::gTransfersEnabled &&
       SerialTransferInternal::gSession.state != SerialTransferInternal::RxState::Idle) {
-    SerialTransferInternal::abortTransfer("DISABLED", EventType::Aborted);
+    SerialTransferInternal::suspendTransfer("DISABLED");
+    SerialTransferInternal::finishBatch("DISABLED");
     return;
   }
 
@@ -928,8 +1907,11 @@ void tick() {
   if (SerialTransferInternal::gSession.state != SerialTransferInternal::RxState::Idle) {
     uint32_t now = millis();
     if (now - SerialTransferInternal::gSession.lastActivity > SerialTransferInternal::kTransferTimeoutMs) {
-      SerialTransferInternal::abortTransfer("TIMEOUT", EventType::Aborted);
+      SerialTransferInternal::suspendTransfer("TIMEOUT");
     }
+  } else if (SerialTransferInternal::gBatch.active &&
+             millis() - SerialTransferInternal::gBatch.lastActivity > SerialTransferInternal::kTransferTimeoutMs) {
+    SerialTransferInternal::finishBatch("TIMEOUT");
   }
 }
 
@@ -942,22 +1924,32 @@ bool pollEvent(Event* outEvent) {
 
 bool isTransferActive() {
   return SerialTransferInternal::gSession.state == SerialTransferInternal::RxState::Receiving ||
-         SerialTransferInternal::gSession.state == SerialTransferInternal::RxState::AwaitEnd;
+         SerialTransferInternal::gSession.state == SerialTransferInternal::RxState::AwaitEnd ||
+         SerialTransferInternal::gBatch.active;
 }
 
+// Im Stapel zählt der Fortschritt über alle Dateien
 size_t bytesExpected() {
+  const SerialTransferInternal::BatchSession& batch = SerialTransferInternal::gBatch;
+  if (batch.active) {
+    return std::max(batch.bytes, batch.received + SerialTransferInternal::gSession.expected);
+  }
   return SerialTransferInternal::gSession.expected;
 }
 
 size_t bytesReceived() {
-  return SerialTransferInternal::gSession.received;
+  const SerialTransferInternal::BatchSession& batch = SerialTransferInternal::gBatch;
+  return (batch.active ? batch.received : 0) + SerialTransferInternal::gSession.received;
 }
 
 void setTransferEnabled(bool enabled) {
   if (enabled == SerialTransferInternal::gTransfersEnabled) return;
   SerialTransferInternal::gTransfersEnabled = enabled;
   if (!enabled && SerialTransferInternal::gSession.state != SerialTransferInternal::RxState::Idle) {
-    SerialTransferInternal::abortTransfer("DISABLED", EventType::Aborted);
+    SerialTransferInternal::suspendTransfer("DISABLED");
+  }
+  if (!enabled) {
+    SerialTransferInternal::finishBatch("DISABLED");
   }
   if (enabled) {
     SerialTransferInternal::sendOk("READY", "USB-Modus aktiv");
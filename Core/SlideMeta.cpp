@@ -0,0 +1,144 @@
+#include "SlideMeta.h"
+#include "ImageProbe.h"
+#include "Crc32.h"
+
+#include <LittleFS.h>
+#include <cstring>
+
+namespace {
+const char* metaBaseName(const String& path) {
+  const int slash = path.lastIndexOf('/');
+  return path.c_str() + slash + 1;
+}
+
+bool metaRead(File& f, size_t slot, SlideMeta::Record& rec) {
+  return f.seek(slot * sizeof(rec)) &&
+         f.read(reinterpret_cast<uint8_t*>(&rec), sizeof(rec)) == sizeof(rec);
+}
+
+bool metaWrite(File& f, size_t slot, const SlideMeta::Record& rec) {
+  return f.seek(slot * sizeof(rec)) &&
+         f.write(reinterpret_cast<const uint8_t*>(&rec), sizeof(rec)) == sizeof(rec);
+}
+}
+
+namespace SlideMeta {
+
+static_assert(sizeof(Record) == 64, "metadata records are 64 bytes on flash");
+
+bool record(const char* name, uint32_t size, const ImageProbe& probe) {
+  if (!name || !name[0] || std::strlen(name) >= kNameLen || !probe.isMedia() ||
+      probe.verdict() != ImageProbe::Verdict::Ok) {
+    return false;
+  }
+
+  Record rec{};
+  std::strncpy(rec.name, name, sizeof(rec.name) - 1);
+  rec.size = size;
+  rec.crc = probe.crc();
+  rec.width = probe.width();
+  rec.height = probe.height();
+  rec.type = static_cast<uint8_t>(probe.type());
+
+  File f = LittleFS.exists(kPath) ? LittleFS.open(kPath, "r+") : LittleFS.open(kPath, FILE_WRITE);
+  if (!f) {
+    return false;
+  }
+  // Same name replaces, otherwise the first free slot or the end
+  const size_t slots = f.size() / sizeof(Record);
+  size_t target = slots;
+  Record existing;
+  for (size_t slot = 0; slot < slots && metaRead(f, slot, existing); ++slot) {
+    if (std::strncmp(existing.name, rec.name, kNameLen) == 0) {
+      target = slot;
+      break;
+    }
+    if (!existing.name[0] && target == slots) {
+      target = slot;
+    }
+  }
+  const bool ok = metaWrite(f, target, rec);
+  f.close();
+  #ifdef USB_DEBUG
+    Serial.printf("[Meta] %s %ux%u crc %08lx%s\n", name, rec.width, rec.height,
+                  static_cast<unsigned long>(rec.crc), ok ? "" : " WRITE FAIL");
+  #endif
+  return ok;
+}
+
+void apply(std::vector<SlideFile>& files) {
+  if (!LittleFS.exists(kPath)) {
+    return;
+  }
+  File f = LittleFS.open(kPath, "r+");
+  if (!f) {
+    return;
+  }
+
+  const size_t slots = f.size() / sizeof(Record);
+  size_t applied = 0;
+  Record rec;
+  for (size_t slot = 0; slot < slots && metaRead(f, slot, rec); ++slot) {
+    if (!rec.name[0]) {
+      continue;
+    }
+    rec.name[kNameLen - 1] = '\0';
+    SlideFile* match = nullptr;
+    for (SlideFile& file : files) {
+      if (file.size == rec.size && static_cast<uint8_t>(file.type) == rec.type &&
+          std::strcmp(metaBaseName(file.path), rec.name) == 0) {
+        match = &file;
+        break;
+      }
+    }
+    if (match) {
+      match->width = rec.width;
+      match->height = rec.height;
+      ++applied;
+    } else {
+      // Slide deleted or replaced behind the receivers' back: free the slot
+      const Record empty{};
+      metaWrite(f, slot, empty);
+    }
+  }
+  f.close();
+  #ifdef USB_DEBUG
+    Serial.printf("[Meta] %u/%u slides known\n", static_cast<unsigned>(applied),
+                  static_cast<unsigned>(files.size()));
+  #endif
+}
+
+uint32_t nameHash(const char* name) {
+  return crc32Update(0, name, std::strlen(name));
+}
+
+void loadChecksums(std::vector<Checksum>& out) {
+  out.clear();
+  File f = LittleFS.exists(kPath) ? LittleFS.open(kPath, FILE_READ) : File();
+  if (!f) {
+    return;
+  }
+  const size_t slots = f.size() / sizeof(Record);
+  out.reserve(slots);
+  Record rec;
+  for (size_t slot = 0; slot < slots && metaRead(f, slot, rec); ++slot) {
+    if (rec.name[0]) {
+      rec.name[kNameLen - 1] = '\0';
+      out.push_back({nameHash(rec.name), rec.size, rec.crc});
+    }
+  }
+  f.close();
+}
+
+bool findChecksum(const std::vector<Checksum>& table, const char* name, uint32_t size, uint32_t* crc) {
+  const uint32_t hash = nameHash(name);
+  for (const Checksum& entry : table) {
+    if (entry.nameHash == hash && entry.size == size) {
+      *crc = entry.crc;
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace SlideMeta
@@ -0,0 +1,70 @@
+#ifndef SLIDEMETA_H
+#define SLIDEMETA_H
+
+#include <Arduino.h>
+#include <vector>
+
+#include "Storage.h"
+
+class ImageProbe;
+
+/**
+ * Slide metadata recorded at upload time
+ *
+ * The USB and BLE receivers check every flash slide with ImageProbe while
+ * it arrives and store what the probe found in /slides/.meta: one fixed
+ * 64-byte record per slide name with size, CRC-32, type and dimensions.
+ * When the flash list is rebuilt, slides whose name and size match a
+ * record get their dimensions from it, so showing them needs no header
+ * probe. Records of slides that are gone are dropped on the same pass.
+ *
+ * Slides without a record (SD copies, older uploads) keep width 0 and are
+ * probed at display time as before.
+ */
+namespace SlideMeta {
+
+constexpr const char* kPath = "/slides/.meta";
+constexpr size_t kNameLen = 48;
+
+struct Record {
+  char name[kNameLen];
+  uint32_t size;
+  uint32_t crc;
+  uint16_t width;
+  uint16_t height;
+  uint8_t type;  // SlideMediaType
+  uint8_t reserved[3];
+};
+
+/**
+ * Store the probe result for a slide, replacing an older record of the
+ * same name.
+ */
+bool record(const char* name, uint32_t size, const ImageProbe& probe);
+
+/**
+ * Fill width and height of flash slides that have a matching record.
+ */
+void apply(std::vector<SlideFile>& files);
+
+// Upload CRC of a slide, keyed by nameHash() of its name
+struct Checksum {
+  uint32_t nameHash;
+  uint32_t size;
+  uint32_t crc;
+};
+
+uint32_t nameHash(const char* name);
+
+/**
+ * CRCs of all recorded slides in one pass over the file, for listings
+ * that look up many names (12 bytes per slide instead of 64).
+ */
+void loadChecksums(std::vector<Checksum>& out);
+
+// CRC for name and size from a loadChecksums() table
+bool findChecksum(const std::vector<Checksum>& table, const char* name, uint32_t size, uint32_t* crc);
+
+}  // namespace SlideMeta
+
+#endif // SLIDEMETA_H
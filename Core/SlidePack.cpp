@@ -0,0 +1,734 @@
+#include "SlidePack.h"
+#include "BufferedFile.h"
+#include "Config.h"
+#include <algorithm>
+#include <esp_random.h>
+#include <strings.h>
+
+SlidePack slidePack;
+
+namespace {
+constexpr uint8_t kDataMagic[4] = {'S', 'P', 'D', '1'};
+constexpr uint8_t kIndexMagic[4] = {'S', 'P', 'I', '1'};
+constexpr size_t kPackFreeReserve = 4096;  // keep LittleFS metadata room
+// An append also rewrites the last, partly filled block of both files
+constexpr size_t kPackAppendSlack = 2 * 4096;
+
+size_t packFreeBytes() {
+  const size_t total = LittleFS.totalBytes();
+  const size_t used = LittleFS.usedBytes();
+  return (total > used) ? total - used : 0;
+}
+
+bool replaceFile(const char* from, const char* to) {
+  if (LittleFS.rename(from, to)) {
+    return true;
+  }
+  // Not every LittleFS port replaces an existing target
+  LittleFS.remove(to);
+  return LittleFS.rename(from, to);
+}
+
+uint32_t newPackId(uint32_t current) {
+  uint32_t id;
+  do {
+    id = esp_random();
+  } while (id == 0 || id == current);
+  return id;
+}
+}
+
+static_assert(sizeof(SlidePack::Entry) == 64, "pack entry layout");
+
+bool SlidePack::begin() {
+  if (reader_) {
+    return true;
+  }
+
+  recoverCompaction_();
+  resetState_();
+  if (!LittleFS.exists(kPackPath)) {
+    return true;  // no pack yet
+  }
+
+  reader_ = LittleFS.open(kPackPath, FILE_READ);
+  Header h;
+  if (reader_ && readHeader_(reader_, kDataMagic, h)) {
+    packId_ = h.packId;
+    dataEnd_ = reader_.size();
+  }
+  if (!packId_ || !loadIndex_()) {
+    if (reader_) reader_.close();
+    if (index_) index_.close();
+    resetState_();
+    #ifdef USB_DEBUG
+      Serial.println("[Pack] invalid pack or index, pack ignored");
+    #endif
+    return false;
+  }
+
+  #ifdef USB_DEBUG
+    Serial.printf("[Pack] %u slides, %lu bytes (%lu dead)\n",
+                  liveCount_,
+                  static_cast<unsigned long>(dataEnd_ - kDataStart),
+                  static_cast<unsigned long>(deadBytes_));
+  #endif
+  return true;
+}
+
+void SlidePack::end() {
+  abortAppend();
+  cancelCompaction_();
+  if (reader_) {
+    reader_.close();
+  }
+  if (index_) {
+    index_.close();
+  }
+}
+
+bool SlidePack::enabledForUploads() {
+#ifdef FLASH_SLIDE_PACK
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool SlidePack::ensureReader_() {
+  if (reader_) {
+    return true;
+  }
+  return begin() && reader_;
+}
+
+void SlidePack::resetState_() {
+  recordPos_.clear();
+  slots_ = 0;
+  liveCount_ = 0;
+  packId_ = 0;
+  dataEnd_ = kDataStart;
+  liveBytes_ = 0;
+  indexEnd_ = kHeaderSize;
+  deadBytes_ = 0;
+  nextStamp_ = 1;
+}
+
+bool SlidePack::readHeader_(File& f, const uint8_t* magic, Header& h) {
+  return f.seek(0) &&
+         f.read(reinterpret_cast<uint8_t*>(&h), sizeof(h)) == sizeof(h) &&
+         memcmp(h.magic, magic, sizeof(h.magic)) == 0 &&
+         h.capacity == kCapacity &&
+         h.entrySize == kEntrySize;
+}
+
+bool SlidePack::writeHeader_(File& f, const uint8_t* magic, uint32_t packId, uint32_t records) {
+  Header h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, magic, sizeof(h.magic));
+  h.packId = packId;
+  h.capacity = kCapacity;
+  h.entrySize = kEntrySize;
+  h.records = records;
+  h.nextStamp = nextStamp_;
+  return f.write(reinterpret_cast<const uint8_t*>(&h), sizeof(h)) == sizeof(h);
+}
+
+uint32_t SlidePack::packIdOf_(const char* path, const uint8_t* magic) {
+  if (!LittleFS.exists(path)) {
+    return 0;
+  }
+  File f = LittleFS.open(path, FILE_READ);
+  Header h;
+  const bool ok = f && readHeader_(f, magic, h);
+  if (f) f.close();
+  return ok ? h.packId : 0;
+}
+
+bool SlidePack::readEntry_(int16_t slot, Entry& e) {
+  if (slot < 0 || slot >= slots_ || recordPos_[slot] == 0 ||
+      !index_.seek(recordPos_[slot]) ||
+      index_.read(reinterpret_cast<uint8_t*>(&e), sizeof(e)) != sizeof(e)) {
+    return false;
+  }
+  e.name[kNameLen - 1] = '\0';
+  return true;
+}
+
+bool SlidePack::loadIndex_() {
+  if (index_) {
+    index_.close();
+  }
+  recordPos_.clear();
+  index_ = LittleFS.open(kIndexPath, FILE_READ);
+  Header h;
+  if (!index_ || !readHeader_(index_, kIndexMagic, h) || h.packId != packId_) {
+    return false;
+  }
+  nextStamp_ = std::max<uint32_t>(h.nextStamp, 1);
+
+  // Replay the journal: the last record of a slot wins
+  const uint32_t size = index_.size();
+  uint32_t pos = kHeaderSize;
+  Entry e;
+  for (; pos + kEntrySize <= size; pos += kEntrySize) {
+    if (index_.read(reinterpret_cast<uint8_t*>(&e), sizeof(e)) != sizeof(e)) {
+      break;
+    }
+    if (e.slot >= kCapacity) {
+      continue;
+    }
+    if (e.slot >= recordPos_.size()) {
+      recordPos_.resize(e.slot + 1, 0);
+    }
+    const bool live = (e.flags & kFlagLive) && e.offset >= kDataStart &&
+                      e.size <= dataEnd_ && e.offset <= dataEnd_ - e.size;
+    recordPos_[e.slot] = live ? pos : 0;
+    nextStamp_ = std::max(nextStamp_, e.stamp + 1);
+  }
+  indexEnd_ = pos;
+  slots_ = recordPos_.size();
+
+  liveCount_ = 0;
+  liveBytes_ = 0;
+  for (int16_t slot = 0; slot < slots_; ++slot) {
+    if (readEntry_(slot, e)) {
+      ++liveCount_;
+      liveBytes_ += e.size;
+    }
+  }
+  deadBytes_ = dataEnd_ - kDataStart - std::min<uint32_t>(liveBytes_, dataEnd_ - kDataStart);
+
+  if (indexEnd_ != size) {
+    // Torn record at the end: later appends must line up again
+    #ifdef USB_DEBUG
+      Serial.println("[Pack] torn index record, rewriting index");
+    #endif
+    return rewriteIndex_();
+  }
+  return true;
+}
+
+bool SlidePack::appendRecord_(const Entry& e) {
+  File f = LittleFS.open(kIndexPath, FILE_APPEND);
+  if (!f) {
+    return false;
+  }
+  // A failed earlier write leaves the size off, and this refuses until begin() repaired it
+  const bool ok = f.size() == indexEnd_ &&
+                  f.write(reinterpret_cast<const uint8_t*>(&e), sizeof(e)) == sizeof(e);
+  f.close();
+  if (!ok) {
+    return false;
+  }
+  if (e.slot >= recordPos_.size()) {
+    recordPos_.resize(e.slot + 1, 0);
+  }
+  recordPos_[e.slot] = (e.flags & kFlagLive) ? indexEnd_ : 0;
+  slots_ = recordPos_.size();
+  indexEnd_ += kEntrySize;
+  return true;
+}
+
+bool SlidePack::writeIndex_(const char* path, uint32_t packId, const std::vector<Entry>& entries) {
+  File f = LittleFS.open(path, FILE_WRITE);
+  if (!f) {
+    return false;
+  }
+  bool ok = writeHeader_(f, kIndexMagic, packId, entries.size());
+  for (const Entry& e : entries) {
+    ok = ok && f.write(reinterpret_cast<const uint8_t*>(&e), sizeof(e)) == sizeof(e);
+  }
+  f.close();
+  if (!ok) {
+    LittleFS.remove(path);
+  }
+  return ok;
+}
+
+bool SlidePack::rewriteIndex_() {
+  std::vector<Entry> entries;
+  entries.reserve(liveCount_);
+  Entry e;
+  for (int16_t slot = 0; slot < slots_; ++slot) {
+    if (readEntry_(slot, e)) {
+      entries.push_back(e);
+    }
+  }
+  if (!writeIndex_(kIndexTempPath, packId_, entries)) {
+    return false;
+  }
+  index_.close();
+  // On failure begin() retries the rename from the complete temp index
+  if (!replaceFile(kIndexTempPath, kIndexPath)) {
+    return false;
+  }
+  return loadIndex_();
+}
+
+void SlidePack::recoverCompaction_() {
+  // A complete temp index means the copy finished and only renames can be missing
+  if (LittleFS.exists(kIndexTempPath)) {
+    File tmp = LittleFS.open(kIndexTempPath, FILE_READ);
+    Header h;
+    const bool complete = tmp && readHeader_(tmp, kIndexMagic, h) &&
+                          tmp.size() == kHeaderSize + static_cast<size_t>(h.records) * kEntrySize;
+    if (tmp) tmp.close();
+    if (complete) {
+      // Data file first, as in finishCompaction_(); a failed rename keeps both for the next try
+      if (packIdOf_(kTempPath, kDataMagic) == h.packId && !replaceFile(kTempPath, kPackPath)) {
+        return;
+      }
+      if (packIdOf_(kPackPath, kDataMagic) == h.packId && !replaceFile(kIndexTempPath, kIndexPath)) {
+        return;
+      }
+    }
+  }
+  if (LittleFS.exists(kTempPath)) {
+    LittleFS.remove(kTempPath);
+  }
+  if (LittleFS.exists(kIndexTempPath)) {
+    LittleFS.remove(kIndexTempPath);
+  }
+}
+
+bool SlidePack::createPack_() {
+  if (reader_) reader_.close();
+  if (index_) index_.close();
+  resetState_();
+  packId_ = newPackId(0);
+
+  // Index first: an index without its data file is ignored and overwritten
+  bool ok = writeIndex_(kIndexPath, packId_, std::vector<Entry>());
+  if (ok) {
+    File f = LittleFS.open(kPackPath, FILE_WRITE);
+    ok = f && writeHeader_(f, kDataMagic, packId_, 0);
+    if (f) f.close();
+    if (!ok) {
+      LittleFS.remove(kPackPath);
+    }
+  }
+  if (!ok) {
+    resetState_();
+    return false;
+  }
+  reopenReader_();
+  return static_cast<bool>(reader_);
+}
+
+void SlidePack::reopenReader_() {
+  // Handles opened before a write don't see the new size
+  if (reader_) {
+    reader_.close();
+  }
+  if (index_) {
+    index_.close();
+  }
+  reader_ = LittleFS.open(kPackPath, FILE_READ);
+  index_ = LittleFS.open(kIndexPath, FILE_READ);
+  if (reader_) {
+    dataEnd_ = reader_.size();
+    deadBytes_ = dataEnd_ - kDataStart - std::min<uint32_t>(liveBytes_, dataEnd_ - kDataStart);
+  }
+  ++generation_;
+}
+
+void SlidePack::list(std::vector<SlideFile>& out) {
+  if (!ensureReader_()) {
+    return;
+  }
+  Entry e;
+  for (int16_t slot = 0; slot < slots_; ++slot) {
+    if (!readEntry_(slot, e)) {
+      continue;
+    }
+    SlideFile file;
+    file.path = String(kFlashSlidesDir) + "/" + e.name;
+    file.displayName = e.name;
+    const int dot = file.displayName.lastIndexOf('.');
+    if (dot >= 0) {
+      file.displayName.remove(dot);
+    }
+    file.type = static_cast<SlideMediaType>(e.type);
+    file.packSlot = slot;
+    file.size = e.size;
+    out.push_back(std::move(file));
+  }
+}
+
+bool SlidePack::entry(int16_t slot, Entry& out) {
+  return slot >= 0 && ensureReader_() && readEntry_(slot, out);
+}
+
+bool SlidePack::contains(const char* name) {
+  if (!name || !ensureReader_()) {
+    return false;
+  }
+  Entry e;
+  for (int16_t slot = 0; slot < slots_; ++slot) {
+    if (readEntry_(slot, e) && strcasecmp(e.name, name) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool SlidePack::nameTaken(const String& name) {
+  return LittleFS.exists(String(kFlashSlidesDir) + "/" + name) || contains(name.c_str());
+}
+
+File SlidePack::openSlide(int16_t slot, uint32_t* size) {
+  Entry e;
+  if (!entry(slot, e)) {
+    return File();
+  }
+  File f = LittleFS.open(kPackPath, FILE_READ);
+  if (f && !f.seek(e.offset)) {
+    f.close();
+    return File();
+  }
+  if (size) {
+    *size = e.size;
+  }
+  return f;
+}
+
+size_t SlidePack::read(int16_t slot, uint32_t pos, uint8_t* buf, size_t len) {
+  Entry e;
+  if (!entry(slot, e) || pos >= e.size) {
+    return 0;
+  }
+  len = std::min<size_t>(len, e.size - pos);
+  if (!reader_.seek(e.offset + pos)) {
+    return 0;
+  }
+  return reader_.read(buf, len);
+}
+
+bool SlidePack::beginAppend(const char* name, SlideMediaType type, size_t size) {
+  abortAppend();
+  cancelCompaction_();
+  if (!name || !name[0] || size == 0) {
+    return false;
+  }
+  if (!LittleFS.exists(kPackPath)) {
+    if (!createPack_()) {
+      return false;
+    }
+  } else if (!ensureReader_()) {
+    return false;
+  }
+  dropTempFiles_();
+
+  // New slot behind the last one, else one that a delete emptied
+  int16_t slot = -1;
+  if (slots_ < kCapacity) {
+    slot = slots_;
+  } else {
+    for (int16_t i = 0; i < slots_ && slot < 0; ++i) {
+      if (recordPos_[i] == 0) {
+        slot = i;
+      }
+    }
+  }
+  if (slot < 0 || packFreeBytes() < size + kPackAppendSlack + kPackFreeReserve) {
+    #ifdef USB_DEBUG
+      Serial.printf("[Pack] no room for %s\n", name);
+    #endif
+    return false;
+  }
+
+  writer_ = LittleFS.open(kPackPath, FILE_APPEND);
+  if (!writer_) {
+    return false;
+  }
+
+  appendSlot_ = slot;
+  appendEntry_ = Entry();
+  appendEntry_.offset = writer_.size();
+  appendEntry_.size = size;
+  appendEntry_.stamp = nextStamp_;
+  appendEntry_.type = static_cast<uint8_t>(type);
+  appendEntry_.flags = kFlagLive;
+  appendEntry_.slot = slot;
+  strlcpy(appendEntry_.name, name, sizeof(appendEntry_.name));
+  appendWritten_ = 0;
+  return true;
+}
+
+bool SlidePack::write(const uint8_t* data, size_t len) {
+  if (!writer_ || appendWritten_ + len > appendEntry_.size) {
+    return false;
+  }
+  if (writer_.write(data, len) != len) {
+    return false;
+  }
+  appendWritten_ += len;
+  return true;
+}
+
+bool SlidePack::commitAppend() {
+  if (!writer_) {
+    return false;
+  }
+  if (appendWritten_ != appendEntry_.size) {
+    abortAppend();
+    return false;
+  }
+
+  // Data, then its record: until the record is in the index the slide doesn't exist
+  writer_.close();
+  const bool ok = appendRecord_(appendEntry_);
+  if (ok) {
+    ++liveCount_;
+    liveBytes_ += appendEntry_.size;
+    nextStamp_ = appendEntry_.stamp + 1;
+    #ifdef USB_DEBUG
+      Serial.printf("[Pack] + %s in slot %d (%lu bytes)\n", appendEntry_.name, appendSlot_,
+                    static_cast<unsigned long>(appendEntry_.size));
+    #endif
+  }
+  appendSlot_ = -1;
+  appendWritten_ = 0;
+  reopenReader_();
+  return ok;
+}
+
+void SlidePack::abortAppend() {
+  if (writer_) {
+    // The bytes written so far stay behind as dead data until the next compaction
+    writer_.close();
+    reopenReader_();
+  }
+  appendSlot_ = -1;
+  appendWritten_ = 0;
+}
+
+bool SlidePack::append(const char* name, SlideMediaType type, const uint8_t* data, size_t len) {
+  if (!beginAppend(name, type, len)) {
+    return false;
+  }
+  size_t offset = 0;
+  while (offset < len) {
+    const size_t chunk = std::min<size_t>(512, len - offset);
+    if (!write(data + offset, chunk)) {
+      abortAppend();
+      return false;
+    }
+    offset += chunk;
+    delay(0);
+  }
+  return commitAppend();
+}
+
+bool SlidePack::remove(int16_t slot) {
+  Entry e;
+  if (writer_ || !entry(slot, e)) {
+    return false;
+  }
+  cancelCompaction_();
+  if (liveCount_ <= 1) {
+    return clear();  // last slide: nothing worth compacting
+  }
+  dropTempFiles_();
+
+  e.flags &= ~kFlagLive;
+  e.slot = slot;
+  const bool ok = appendRecord_(e);
+  if (ok) {
+    --liveCount_;
+    liveBytes_ -= e.size;
+    #ifdef USB_DEBUG
+      Serial.printf("[Pack] - %s (slot %d)\n", e.name, slot);
+    #endif
+  }
+  reopenReader_();
+  return ok;
+}
+
+bool SlidePack::clear() {
+  abortAppend();
+  cancelCompaction_();
+  if (reader_) {
+    reader_.close();
+  }
+  if (index_) {
+    index_.close();
+  }
+  dropTempFiles_();
+  resetState_();
+  ++generation_;
+  // Data file first: an index without it is ignored
+  return (!LittleFS.exists(kPackPath) || LittleFS.remove(kPackPath)) &&
+         (!LittleFS.exists(kIndexPath) || LittleFS.remove(kIndexPath));
+}
+
+void SlidePack::cancelCompaction_() {
+  if (compactIn_) compactIn_.close();
+  if (compactOut_) {
+    compactOut_.close();
+    LittleFS.remove(kTempPath);
+  }
+  compactSlot_ = -1;
+  std::vector<Entry>().swap(compactTable_);
+}
+
+void SlidePack::dropTempFiles_() {
+  // Left by a compaction whose renames failed; once the pack changes they are stale
+  if (LittleFS.exists(kTempPath)) {
+    LittleFS.remove(kTempPath);
+  }
+  if (LittleFS.exists(kIndexTempPath)) {
+    LittleFS.remove(kIndexTempPath);
+  }
+}
+
+bool SlidePack::startCompaction_() {
+  if (!ensureReader_() || blockedGeneration_ == generation_) {
+    return false;
+  }
+  // Live data and table exist twice until the old files are replaced
+  const size_t need = liveBytes_ + 2 * kHeaderSize + static_cast<size_t>(liveCount_) * kEntrySize;
+  if (packFreeBytes() < need + kPackFreeReserve) {
+    // Retried after the next change of the pack
+    blockedGeneration_ = generation_;
+    #ifdef USB_DEBUG
+      Serial.println("[Pack] compaction skipped, flash too full");
+    #endif
+    return false;
+  }
+
+  compactId_ = newPackId(packId_);
+  compactOut_ = LittleFS.open(kTempPath, FILE_WRITE);
+  compactIn_ = LittleFS.open(kPackPath, FILE_READ);
+  if (!compactOut_ || !compactIn_ || !writeHeader_(compactOut_, kDataMagic, compactId_, 0)) {
+    cancelCompaction_();
+    blockedGeneration_ = generation_;
+    return false;
+  }
+  compactTable_.clear();
+  compactTable_.reserve(liveCount_);
+  compactGeneration_ = generation_;
+  compactSlot_ = -1;
+  compactPos_ = 0;
+  compactEnd_ = kDataStart;
+  compactEntry_ = Entry();
+  return true;
+}
+
+bool SlidePack::compactStep(uint32_t budgetMs) {
+  if (!compactionPending() || writer_) {
+    return false;
+  }
+  if (compactOut_ && compactGeneration_ != generation_) {
+    cancelCompaction_();  // pack changed underneath, start over
+  }
+  if (!compactOut_ && !startCompaction_()) {
+    return false;
+  }
+
+  const uint32_t start = millis();
+  uint8_t buf[kCopyChunk];
+  bool failed = false;
+  while (!failed && millis() - start < budgetMs) {
+    if (compactSlot_ < 0 || compactPos_ >= compactEntry_.size) {
+      // Current slide done: note its new place, move on to the next live one
+      if (compactSlot_ >= 0) {
+        compactTable_.push_back(compactEntry_);
+      }
+      Entry e;
+      int16_t next = compactSlot_ + 1;
+      while (next < slots_ && !readEntry_(next, e)) {
+        ++next;
+      }
+      if (next >= slots_) {
+        return !finishCompaction_();
+      }
+      if (!compactIn_.seek(e.offset)) {
+        failed = true;
+        break;
+      }
+      e.offset = compactEnd_;
+      compactEntry_ = e;
+      compactSlot_ = next;
+      compactPos_ = 0;
+      continue;
+    }
+
+    const size_t chunk = std::min<size_t>(sizeof(buf), compactEntry_.size - compactPos_);
+    if (compactIn_.read(buf, chunk) != chunk || compactOut_.write(buf, chunk) != chunk) {
+      failed = true;
+      break;
+    }
+    compactPos_ += chunk;
+    compactEnd_ += chunk;
+  }
+
+  if (failed) {
+    cancelCompaction_();
+    blockedGeneration_ = generation_;
+    #ifdef USB_DEBUG
+      Serial.println("[Pack] compaction failed");
+    #endif
+    return false;
+  }
+  return true;
+}
+
+bool SlidePack::finishCompaction_() {
+  compactOut_.close();
+  compactIn_.close();
+  compactSlot_ = -1;
+  // The new table goes out in one piece
+  const bool written = writeIndex_(kIndexTempPath, compactId_, compactTable_);
+  std::vector<Entry>().swap(compactTable_);
+  if (!written) {
+    LittleFS.remove(kTempPath);
+    blockedGeneration_ = generation_;
+    #ifdef USB_DEBUG
+      Serial.println("[Pack] compaction failed");
+    #endif
+    return false;
+  }
+
+  #ifdef USB_DEBUG
+    const uint32_t freed = deadBytes_;
+  #endif
+  if (reader_) {
+    reader_.close();
+  }
+  if (index_) {
+    index_.close();
+  }
+  // Renamed over the old files, data first, so there is always a pack on
+  // flash; begin() completes the pair if power fails in between
+  const bool renamed = replaceFile(kTempPath, kPackPath) && replaceFile(kIndexTempPath, kIndexPath);
+  begin();
+  ++generation_;
+  if (!renamed) {
+    // The temp files stay for the next begin(); no new attempt until the pack changes
+    blockedGeneration_ = generation_;
+    #ifdef USB_DEBUG
+      Serial.println("[Pack] compaction rename failed");
+    #endif
+    return false;
+  }
+  #ifdef USB_DEBUG
+    Serial.printf("[Pack] compacted, %lu bytes freed\n", static_cast<unsigned long>(freed));
+  #endif
+  return true;
+}
+
+JRESULT drawFlashJpg(int32_t x, int32_t y, const SlideFile& slide) {
+  digitalWrite(SD_CS_PIN, HIGH);
+  File f = openBuffered((slide.packSlot < 0) ? LittleFS.open(slide.path.c_str(), FILE_READ)
+                                             : slidePack.openSlide(slide.packSlot));
+  return f ? TJpgDec.drawFsJpg(x, y, f) : JDR_INP;
+}
+
+JRESULT getFlashJpgSize(uint16_t* w, uint16_t* h, const SlideFile& slide) {
+  digitalWrite(SD_CS_PIN, HIGH);
+  File f = openBuffered((slide.packSlot < 0) ? LittleFS.open(slide.path.c_str(), FILE_READ)
+                                             : slidePack.openSlide(slide.packSlot));
+  return f ? TJpgDec.getFsJpgSize(w, h, f) : JDR_INP;
+}
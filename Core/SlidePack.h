@@ -0,0 +1,187 @@
+#ifndef SLIDEPACK_H
+#define SLIDEPACK_H
+
+#include <Arduino.h>
+#include <vector>
+#include <FS.h>
+#include <LittleFS.h>
+#include <TJpg_Decoder.h>
+
+#include "Storage.h"
+
+/**
+ * SlidePack - flash slides in one LittleFS container file
+ *
+ * Opening a LittleFS file walks the directory metadata every time, which
+ * dominates slide switches for small photos. The pack keeps all flash
+ * slides in /slides.pack and reads them through one handle that stays
+ * open; a slide is addressed by its slot, which never changes while the
+ * slide exists.
+ *
+ * LittleFS is copy-on-write, so a write in the middle of a file copies
+ * everything behind it. Both pack files are therefore only ever appended
+ * to: /slides.pack holds a short header and the slide data, /slides.idx a
+ * journal of 64-byte entry records (offset, size, type, name). Appending a
+ * slide writes its data, then one live record; deleting writes one dead
+ * record for the slot. The last record of a slot wins, so a torn append is
+ * simply not visible. The slot table is rebuilt in RAM from the journal.
+ *
+ * Deleted data is reclaimed by a stepwise background compaction: the live
+ * slides are copied into /slides.pack.tmp, the new table is collected in
+ * RAM and written once as /slides.idx.tmp, and both are renamed over the
+ * old files. begin() finishes or discards an interrupted compaction.
+ *
+ * Loose files in /slides keep working next to the pack. New uploads only
+ * go into the pack when FLASH_SLIDE_PACK is defined in Config.h.
+ */
+class SlidePack {
+ public:
+  static constexpr const char* kPackPath = "/slides.pack";
+  static constexpr const char* kIndexPath = "/slides.idx";
+  static constexpr const char* kTempPath = "/slides.pack.tmp";
+  static constexpr const char* kIndexTempPath = "/slides.idx.tmp";
+  static constexpr uint16_t kCapacity = 256;
+  static constexpr size_t kNameLen = 48;
+
+  struct Entry {
+    uint32_t offset = 0;
+    uint32_t size = 0;
+    uint32_t stamp = 0;   // append sequence number, stands in for the mtime
+    uint8_t type = 0;     // SlideMediaType
+    uint8_t flags = 0;
+    uint16_t slot = 0;    // table slot this record belongs to
+    char name[kNameLen] = {0};
+  };
+
+  /**
+   * Open an existing pack and replay its index (or finish an interrupted
+   * compaction).
+   * Without a pack file this is a no-op and the pack stays empty.
+   */
+  bool begin();
+  void end();
+  bool isOpen() const { return static_cast<bool>(reader_); }
+
+  /**
+   * True if new flash slides should be appended to the pack.
+   */
+  static bool enabledForUploads();
+
+  /**
+   * Append all live slides as SlideFile entries. Paths look like loose
+   * files in /slides so sorting and name lookups work on both.
+   */
+  void list(std::vector<SlideFile>& out);
+
+  bool entry(int16_t slot, Entry& out);
+  bool contains(const char* name);
+
+  /**
+   * True if a flash slide of that name exists, loose or packed.
+   */
+  bool nameTaken(const String& name);
+
+  /**
+   * Fresh read handle positioned at the first byte of the slide. TJpgDec
+   * closes the File it decodes, so it must not get the shared handle.
+   */
+  File openSlide(int16_t slot, uint32_t* size = nullptr);
+
+  /**
+   * Read from the slide at pos through the shared handle.
+   */
+  size_t read(int16_t slot, uint32_t pos, uint8_t* buf, size_t len);
+
+  // Append one slide: beginAppend, write() the exact size, commitAppend
+  bool beginAppend(const char* name, SlideMediaType type, size_t size);
+  bool write(const uint8_t* data, size_t len);
+  bool commitAppend();
+  void abortAppend();
+  bool appending() const { return static_cast<bool>(writer_); }
+  bool append(const char* name, SlideMediaType type, const uint8_t* data, size_t len);
+
+  bool remove(int16_t slot);
+  bool clear();
+
+  /**
+   * Copy up to one chunk of the pending compaction. Returns true while
+   * there is still work left.
+   */
+  bool compactStep(uint32_t budgetMs);
+  bool compactionPending() const { return deadBytes_ > 0 && liveCount_ > 0; }
+
+ private:
+  static constexpr uint8_t kFlagLive = 0x01;
+  static constexpr size_t kHeaderSize = 32;
+  static constexpr size_t kEntrySize = sizeof(Entry);
+  static constexpr size_t kDataStart = kHeaderSize;
+  static constexpr size_t kCopyChunk = 1024;
+
+  // Same layout at the start of the data file and of the index
+  struct Header {
+    uint8_t magic[4];
+    uint32_t packId;      // pairs an index with its data file
+    uint16_t capacity;
+    uint16_t entrySize;
+    uint32_t records;     // index: records written together with the header
+    uint32_t nextStamp;   // index: stamp floor, survives deleted records
+    uint8_t pad[12];
+  };
+
+  bool ensureReader_();
+  bool readHeader_(File& f, const uint8_t* magic, Header& h);
+  bool writeHeader_(File& f, const uint8_t* magic, uint32_t packId, uint32_t records);
+  uint32_t packIdOf_(const char* path, const uint8_t* magic);
+  bool readEntry_(int16_t slot, Entry& e);
+  bool loadIndex_();
+  bool appendRecord_(const Entry& e);
+  bool writeIndex_(const char* path, uint32_t packId, const std::vector<Entry>& entries);
+  bool rewriteIndex_();
+  void recoverCompaction_();
+  void resetState_();
+  bool createPack_();
+  void reopenReader_();
+  bool startCompaction_();
+  void cancelCompaction_();
+  void dropTempFiles_();
+  bool finishCompaction_();
+
+  File reader_;               // slide data
+  File index_;                // index journal, for entry lookups
+  File writer_;
+  std::vector<uint32_t> recordPos_;  // per slot: offset of its live record in the index, 0 = empty
+  uint16_t slots_ = 0;
+  uint16_t liveCount_ = 0;
+  uint32_t packId_ = 0;
+  uint32_t dataEnd_ = kDataStart;
+  uint32_t liveBytes_ = 0;
+  uint32_t indexEnd_ = kHeaderSize;
+  uint32_t deadBytes_ = 0;     // aborted appends and deleted slides, freed by compaction
+  uint32_t nextStamp_ = 1;
+  uint32_t generation_ = 1;   // bumped by every change of the pack
+  uint32_t blockedGeneration_ = 0;  // compaction failed or had no room at this generation
+
+  // Pending append
+  int16_t appendSlot_ = -1;
+  Entry appendEntry_;
+  uint32_t appendWritten_ = 0;
+
+  // Stepwise compaction into kTempPath; the new table stays in RAM until the end
+  File compactOut_;
+  File compactIn_;
+  uint32_t compactGeneration_ = 0;
+  uint32_t compactId_ = 0;
+  int16_t compactSlot_ = -1;
+  uint32_t compactPos_ = 0;
+  uint32_t compactEnd_ = kDataStart;
+  Entry compactEntry_;
+  std::vector<Entry> compactTable_;
+};
+
+extern SlidePack slidePack;
+
+// TJpgDec on a flash slide, loose in /slides or packed
+JRESULT drawFlashJpg(int32_t x, int32_t y, const SlideFile& slide);
+JRESULT getFlashJpgSize(uint16_t* w, uint16_t* h, const SlideFile& slide);
+
+#endif // SLIDEPACK_H
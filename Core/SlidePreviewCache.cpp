@@ -0,0 +1,359 @@
+#include "SlidePreviewCache.h"
+#include "Gfx.h"
+#include "BufferedFile.h"
+#include "Config.h"
+#include <algorithm>
+#include <climits>
+
+namespace {
+constexpr uint8_t kPreviewMagic[4] = {'S', 'P', 'V', '1'};
+constexpr size_t kPreviewHeaderSize = 8;  // magic + uint16 width + uint16 height (LE)
+constexpr uint16_t kDrawRows = 4;
+
+// Static instance pointer for the TJpgDec callback
+SlidePreviewCache* activePreviewCache = nullptr;
+
+uint32_t fnv1a(const String& text) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < text.length(); ++i) {
+    hash ^= static_cast<uint8_t>(text[i]);
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+bool buttonHeld() {
+  return digitalRead(BTN1_PIN) == LOW || digitalRead(BTN2_PIN) == LOW;
+}
+}
+
+void SlidePreviewCache::reset(size_t fileCount) {
+  state_.assign(fileCount, Entry());
+  pending_ = fileCount;
+  lastStepAt_ = 0;
+}
+
+uint32_t SlidePreviewCache::pathHash(const String& path) {
+  return fnv1a(path);
+}
+
+void SlidePreviewCache::previewPath_(char* out, const String& srcPath, size_t size, time_t mtime) {
+  snprintf(out, kPathLen, "%s/%08lx%08lx%08lx.pv",
+           kCacheDir,
+           static_cast<unsigned long>(fnv1a(srcPath)),
+           static_cast<unsigned long>(size),
+           static_cast<unsigned long>(mtime));
+}
+
+bool SlidePreviewCache::draw(const String& srcPath, size_t srcSize, time_t srcMtime) {
+  char previewPath[kPathLen];
+  previewPath_(previewPath, srcPath, srcSize, srcMtime);
+  File f = SD.open(previewPath, FILE_READ);
+  if (!f) {
+    return false;
+  }
+
+  uint8_t header[kPreviewHeaderSize];
+  if (f.read(header, sizeof(header)) != sizeof(header) ||
+      memcmp(header, kPreviewMagic, sizeof(kPreviewMagic)) != 0) {
+    f.close();
+    return false;
+  }
+  const uint16_t w = header[4] | (header[5] << 8);
+  const uint16_t h = header[6] | (header[7] << 8);
+  if (w == 0 || h == 0 || w > TFT_W || h > TFT_H ||
+      f.size() != kPreviewHeaderSize + static_cast<size_t>(w) * h * sizeof(uint16_t)) {
+    f.close();
+    return false;
+  }
+
+  const int16_t x0 = (TFT_W - w) / 2;
+  const int16_t y0 = (TFT_H - h) / 2;
+
+  // Letterbox bars: callers redraw without clearing to erase overlays
+  if (y0 > 0) {
+    tft.fillRect(0, 0, TFT_W, y0, TFT_BLACK);
+    tft.fillRect(0, y0 + h, TFT_W, TFT_H - y0 - h, TFT_BLACK);
+  }
+  if (x0 > 0) {
+    tft.fillRect(0, y0, x0, h, TFT_BLACK);
+    tft.fillRect(x0 + w, y0, TFT_W - x0 - w, h, TFT_BLACK);
+  }
+
+  uint16_t rows[TFT_W * kDrawRows];
+  bool ok = true;
+  for (uint16_t y = 0; y < h; y += kDrawRows) {
+    const uint16_t n = std::min<uint16_t>(kDrawRows, h - y);
+    const size_t bytes = static_cast<size_t>(w) * n * sizeof(uint16_t);
+    if (f.read(reinterpret_cast<uint8_t*>(rows), bytes) != bytes) {
+      ok = false;
+      break;
+    }
+    tft.pushImage(x0, y0 + y, w, n, rows);
+  }
+  f.close();
+  return ok;
+}
+
+bool SlidePreviewCache::step(const std::vector<SlideFile>& files, size_t startIdx, uint32_t deadlineMs) {
+  if (files.empty()) {
+    return false;
+  }
+  if (state_.size() != files.size()) {
+    reset(files.size());
+  }
+  if (pending_ == 0) {
+    return false;
+  }
+
+  const uint32_t now = millis();
+  if (now - lastStepAt_ < kStepIntervalMs) {
+    return false;
+  }
+  if (static_cast<int32_t>(deadlineMs - now) <= 0) {
+    return false;
+  }
+  lastStepAt_ = now;
+
+  const size_t count = files.size();
+  for (size_t n = 0; n < count; ++n) {
+    const size_t i = (startIdx + n) % count;
+    Entry& entry = state_[i];
+    if (entry.state == EntryState::Unknown) {
+      probe_(files[i], entry);
+      return true;
+    }
+    if (entry.state == EntryState::Pending &&
+        static_cast<int32_t>(deadlineMs - (now + entry.costMs)) > 0) {
+      return generate_(files[i].path, entry, deadlineMs);
+    }
+  }
+  return false;
+}
+
+bool SlidePreviewCache::probe_(const SlideFile& file, Entry& entry) {
+  const String& srcPath = file.path;
+  if (file.type != SlideMediaType::Jpeg) {
+    entry.state = EntryState::NotNeeded;
+    --pending_;
+    return true;
+  }
+
+  File f = SD.open(srcPath.c_str(), FILE_READ);
+  if (!f) {
+    entry.state = EntryState::Failed;
+    --pending_;
+    return false;
+  }
+  entry.size = f.size();
+  entry.mtime = f.getLastWrite();
+  f.close();
+
+  char previewPath[kPathLen];
+  previewPath_(previewPath, srcPath, entry.size, entry.mtime);
+  if (SD.exists(previewPath)) {
+    entry.state = EntryState::Ready;
+    --pending_;
+    return true;
+  }
+
+  uint16_t w = 0;
+  uint16_t h = 0;
+  if (getSdJpgSizeBuffered(&w, &h, srcPath.c_str()) != JDR_OK) {
+    entry.state = EntryState::Failed;
+    --pending_;
+    return false;
+  }
+  if (w <= TFT_W && h <= TFT_H) {
+    entry.state = EntryState::NotNeeded;
+    --pending_;
+    return true;
+  }
+
+  entry.state = EntryState::Pending;
+  entry.width = w;
+  entry.height = h;
+  entry.costMs = static_cast<uint32_t>(entry.size / bytesPerMs_) + 1;
+  return true;
+}
+
+bool SlidePreviewCache::generate_(const String& srcPath, Entry& entry, uint32_t deadlineMs) {
+  uint8_t scale = 1;
+  while (scale < 8 && (entry.width / scale > TFT_W || entry.height / scale > TFT_H)) {
+    scale <<= 1;
+  }
+  decW_ = entry.width / scale;
+  decH_ = entry.height / scale;
+  if (decW_ == 0 || decH_ == 0) {
+    entry.state = EntryState::Failed;
+    --pending_;
+    return false;
+  }
+
+  // Still larger than the panel at 1/8: subsample further while collecting
+  const uint16_t longest = std::max(decW_, decH_);
+  const uint16_t fit = std::min(TFT_W, TFT_H);
+  if (longest > fit) {
+    outW_ = std::max<uint16_t>(1, static_cast<uint32_t>(decW_) * fit / longest);
+    outH_ = std::max<uint16_t>(1, static_cast<uint32_t>(decH_) * fit / longest);
+  } else {
+    outW_ = decW_;
+    outH_ = decH_;
+  }
+
+  if (!SD.exists(kCacheDir) && !SD.mkdir(kCacheDir)) {
+    entry.state = EntryState::Failed;
+    --pending_;
+    return false;
+  }
+
+  strip_ = static_cast<uint16_t*>(malloc(static_cast<size_t>(outW_) * kStripRows * sizeof(uint16_t)));
+  if (!strip_) {
+    return false;  // try again in a later window
+  }
+
+  const String tmpPath = String(kCacheDir) + "/preview.tmp";
+  out_ = SD.open(tmpPath.c_str(), FILE_WRITE);
+  if (!out_) {
+    free(strip_);
+    strip_ = nullptr;
+    entry.state = EntryState::Failed;
+    --pending_;
+    return false;
+  }
+
+  uint8_t header[kPreviewHeaderSize];
+  memcpy(header, kPreviewMagic, sizeof(kPreviewMagic));
+  header[4] = outW_ & 0xFF;
+  header[5] = outW_ >> 8;
+  header[6] = outH_ & 0xFF;
+  header[7] = outH_ >> 8;
+  writeFailed_ = out_.write(header, sizeof(header)) != sizeof(header);
+
+  stripFirst_ = 0;
+  rowsWritten_ = 0;
+  deadline_ = deadlineMs;
+  cancelled_ = false;
+
+  const uint32_t started = millis();
+  JRESULT rc = JDR_INTR;
+  if (!writeFailed_) {
+    activePreviewCache = this;
+    TJpgDec.setJpgScale(scale);
+    TJpgDec.setCallback(collectBlock_);
+    rc = drawSdJpgBuffered(0, 0, srcPath.c_str());
+    TJpgDec.setCallback(gfxJpegOutput);
+    TJpgDec.setJpgScale(1);
+    activePreviewCache = nullptr;
+  }
+  const uint32_t elapsed = millis() - started;
+
+  bool ok = (rc == JDR_OK) && !writeFailed_ && flushRows_(INT32_MAX) && rowsWritten_ == outH_;
+  out_.close();
+  free(strip_);
+  strip_ = nullptr;
+
+  if (ok) {
+    char finalPath[kPathLen];
+    previewPath_(finalPath, srcPath, entry.size, entry.mtime);
+    SD.remove(finalPath);
+    ok = SD.rename(tmpPath.c_str(), finalPath);
+  }
+  if (!ok) {
+    SD.remove(tmpPath.c_str());
+  }
+
+  if (ok) {
+    entry.state = EntryState::Ready;
+    --pending_;
+    if (elapsed > 0) {
+      const uint32_t measured = std::max<uint32_t>(1, entry.size / elapsed);
+      bytesPerMs_ = std::max<uint32_t>(1, (bytesPerMs_ + measured) / 2);
+    }
+    #ifdef USB_DEBUG
+      Serial.printf("[Preview] %s -> %ux%u in %lu ms\n",
+                    srcPath.c_str(), outW_, outH_, static_cast<unsigned long>(elapsed));
+    #endif
+    return true;
+  }
+
+  if (cancelled_) {
+    // A button press is not the file's fault; only overrun deadlines count
+    if (static_cast<int32_t>(millis() - deadline_) >= 0) {
+      entry.costMs = std::max<uint32_t>(entry.costMs * 2, elapsed * 2);
+      if (++entry.attempts >= kMaxAttempts) {
+        entry.state = EntryState::Failed;
+        --pending_;
+      }
+    }
+    #ifdef USB_DEBUG
+      Serial.printf("[Preview] cancelled after %lu ms: %s\n",
+                    static_cast<unsigned long>(elapsed), srcPath.c_str());
+    #endif
+    return true;
+  }
+
+  entry.state = EntryState::Failed;
+  --pending_;
+  #ifdef USB_DEBUG
+    Serial.printf("[Preview] FAIL (%d): %s\n", rc, srcPath.c_str());
+  #endif
+  return false;
+}
+
+bool SlidePreviewCache::flushRows_(int32_t srcRowLimit) {
+  uint16_t rows = 0;
+  while (stripFirst_ + rows < outH_ && rows < kStripRows) {
+    const int32_t srcRow = static_cast<int32_t>(static_cast<uint32_t>(stripFirst_ + rows) * decH_ / outH_);
+    if (srcRow >= srcRowLimit) break;
+    ++rows;
+  }
+  if (rows == 0) {
+    return true;
+  }
+  const size_t bytes = static_cast<size_t>(outW_) * rows * sizeof(uint16_t);
+  if (out_.write(reinterpret_cast<const uint8_t*>(strip_), bytes) != bytes) {
+    writeFailed_ = true;
+    return false;
+  }
+  stripFirst_ += rows;
+  rowsWritten_ += rows;
+  return true;
+}
+
+bool SlidePreviewCache::collectBlock_(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t* bitmap) {
+  SlidePreviewCache* self = activePreviewCache;
+  if (!self) return false;
+
+  if (static_cast<int32_t>(millis() - self->deadline_) >= 0 || buttonHeld()) {
+    self->cancelled_ = true;
+    return false;
+  }
+
+  const uint32_t decW = self->decW_;
+  const uint32_t decH = self->decH_;
+  const uint32_t outW = self->outW_;
+  const uint32_t outH = self->outH_;
+
+  // Nearest-neighbour mapping from decoded block into the output strip
+  for (uint32_t oy = (static_cast<uint32_t>(y) * outH + decH - 1) / decH; oy < outH; ++oy) {
+    const uint32_t sy = oy * decH / outH;
+    if (sy >= static_cast<uint32_t>(y + h)) break;
+    if (oy < self->stripFirst_) continue;
+    const uint32_t row = oy - self->stripFirst_;
+    if (row >= kStripRows) break;
+    uint16_t* dst = self->strip_ + row * outW;
+    const uint16_t* src = bitmap + (sy - y) * w;
+    for (uint32_t ox = (static_cast<uint32_t>(x) * outW + decW - 1) / decW; ox < outW; ++ox) {
+      const uint32_t sx = ox * decW / outW;
+      if (sx >= static_cast<uint32_t>(x + w)) break;
+      dst[ox] = src[sx - x];
+    }
+  }
+
+  // Last block of an MCU row: every output row above its bottom edge is complete
+  if (static_cast<uint32_t>(x + w) >= decW) {
+    return self->flushRows_(y + h);
+  }
+  return true;
+}
@@ -0,0 +1,113 @@
+#ifndef SLIDEPREVIEWCACHE_H
+#define SLIDEPREVIEWCACHE_H
+
+#include <Arduino.h>
+#include <vector>
+#include <FS.h>
+#include <SD.h>
+
+#include "Storage.h"
+
+/**
+ * SlidePreviewCache - display-sized sidecar previews for oversized SD photos
+ *
+ * Photos copied straight from a camera are much larger than the 240x240
+ * panel. Even at 1/8 decode scale TJpgDec still has to parse the whole
+ * entropy-coded stream, so such slides take seconds to appear.
+ *
+ * This cache renders each oversized JPEG once into a raw RGB565 preview
+ * (already fitted to the panel) below /.slidecache on the SD card. The
+ * preview name is derived from the original's path, size and mtime, so a
+ * replaced photo simply gets a fresh preview.
+ *
+ * Generation is driven in small steps from SlideshowApp::tick() while a
+ * slide is on screen. A running decode is cancelled as soon as its deadline
+ * passes or a button goes down; the per-file state survives, so the next
+ * idle window resumes with the next pending photo.
+ */
+class SlidePreviewCache {
+ public:
+  static constexpr const char* kCacheDir = "/.slidecache";
+
+  /**
+   * Forget all per-file job state. Call whenever the file list changes.
+   */
+  void reset(size_t fileCount);
+
+  /**
+   * Draw the cached preview for srcPath if one exists for the given
+   * original size and mtime, centred on the panel. Returns false if no
+   * valid preview is present.
+   */
+  bool draw(const String& srcPath, size_t srcSize, time_t srcMtime);
+
+  /**
+   * Advance the background job by at most one file operation.
+   * Files are visited starting at startIdx so upcoming slides come first.
+   * Work that cannot finish before deadlineMs (millis()) is not started.
+   * Returns true if any work was done.
+   */
+  bool step(const std::vector<SlideFile>& files, size_t startIdx, uint32_t deadlineMs);
+
+  /**
+   * True once every file has been probed and processed.
+   */
+  bool done() const { return pending_ == 0 && !state_.empty(); }
+
+  /**
+   * Stable hash of a slide path, shared by the on-card cache files.
+   */
+  static uint32_t pathHash(const String& path);
+
+ private:
+  enum class EntryState : uint8_t {
+    Unknown = 0,  // not probed yet
+    Pending,      // oversized, preview still missing
+    Ready,
+    NotNeeded,    // fits the display or is no JPEG
+    Failed
+  };
+
+  struct Entry {
+    EntryState state = EntryState::Unknown;
+    uint8_t attempts = 0;
+    uint32_t costMs = 0;  // estimated decode time
+    size_t size = 0;
+    time_t mtime = 0;
+    uint16_t width = 0;
+    uint16_t height = 0;
+  };
+
+  static constexpr uint32_t kStepIntervalMs = 250;
+  static constexpr uint8_t kMaxAttempts = 4;
+  static constexpr uint16_t kStripRows = 18;  // 16px MCU row + rounding slack
+
+  static constexpr size_t kPathLen = 48;
+
+  static void previewPath_(char* out, const String& srcPath, size_t size, time_t mtime);
+  static bool collectBlock_(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t* bitmap);
+
+  bool probe_(const SlideFile& file, Entry& entry);
+  bool generate_(const String& srcPath, Entry& entry, uint32_t deadlineMs);
+  bool flushRows_(int32_t srcRowLimit);
+
+  std::vector<Entry> state_;
+  size_t pending_ = 0;
+  uint32_t lastStepAt_ = 0;
+  uint32_t bytesPerMs_ = 150;  // conservative SD + decode throughput, refined after each run
+
+  // Active generation (valid only inside generate_)
+  File out_;
+  uint16_t* strip_ = nullptr;
+  uint16_t decW_ = 0;
+  uint16_t decH_ = 0;
+  uint16_t outW_ = 0;
+  uint16_t outH_ = 0;
+  uint16_t stripFirst_ = 0;  // first output row held in strip_
+  uint16_t rowsWritten_ = 0;
+  uint32_t deadline_ = 0;
+  bool cancelled_ = false;
+  bool writeFailed_ = false;
+};
+
+#endif // SLIDEPREVIEWCACHE_H
@@ -1,5 +1,33 @@
 #include "Storage.h"
 
+#include <strings.h>
+
+bool slideMediaTypeFor(const char* name, SlideMediaType* type) {
+  if (!name) {
+    return false;
+  }
+  const char* dot = strrchr(name, '.');
+  if (!dot) {
+    return false;
+  }
+  SlideMediaType detected;
+  if (strcasecmp(dot, ".jpg") == 0 || strcasecmp(dot, ".jpeg") == 0) {
+    detected = SlideMediaType::Jpeg;
+  } else if (strcasecmp(dot, ".gif") == 0) {
+    detected = SlideMediaType::Gif;
+  } else if (strcasecmp(dot, ".qoi") == 0) {
+    detected = SlideMediaType::Qoi;
+  } else if (strcasecmp(dot, ".anm") == 0) {
+    detected = SlideMediaType::Anim;
+  } else {
+    return false;
+  }
+  if (type) {
+    *type = detected;
+  }
+  return true;
+}
+
 bool mountLittleFs(bool formatOnFail) {
   auto tryMount = [](bool format) {
     return LittleFS.begin(format, kLittleFsBasePath, 10, kLittleFsPartition);
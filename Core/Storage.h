@@ -10,6 +10,26 @@ enum class SlideSource : uint8_t {
   Flash  = 1,
 };
 
+enum class SlideMediaType : uint8_t {
+  Jpeg = 0,
+  Gif  = 1,
+  Anim = 2,  // native delta animation (.anm), see DeltaAnim
+  Qoi  = 3,  // lossless still image, see QoiImage
+};
+
+// Slide list entry. Media type and display name are derived once while the
+// directory is indexed, so showing a slide needs no string work.
+struct SlideFile {
+  String path;
+  String displayName;  // file name without extension
+  SlideMediaType type = SlideMediaType::Jpeg;
+  int16_t packSlot = -1;  // table slot in the flash slide pack, -1 for loose files
+  uint32_t size = 0;
+  uint32_t mtime = 0;     // last write of a loose file, from the directory scan
+  uint16_t width = 0;     // from the upload metadata (SlideMeta), 0 if unknown
+  uint16_t height = 0;
+};
+
 constexpr const char* kFlashSlidesDir = "/slides";
 constexpr const char* kLittleFsBasePath = "/littlefs";
 constexpr const char* kLittleFsPartition = "littlefs";
@@ -30,6 +50,9 @@ inline fs::FS* filesystemFor(SlideSource src) {
   }
 }
 
+// Classifies a file name by extension; false if it is no slide media
+bool slideMediaTypeFor(const char* name, SlideMediaType* type);
+
 bool ensureFlashSlidesDir();
 bool ensureDirectory(const char* path);
 bool clearFlashSlidesDir();
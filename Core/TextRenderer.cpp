@@ -264,14 +264,18 @@ int16_t descent() {
   return cachedDescent;
 }
 
-int16_t measure(const String& text) {
+int16_t measure(const char* text) {
   ensureFont();
   return tft.textWidth(text);
 }
 
-void draw(int16_t x, int16_t yTop, const String& text, uint16_t fgColor, uint16_t outlineColor) {
+int16_t measure(const String& text) {
+  return measure(text.c_str());
+}
+
+void draw(int16_t x, int16_t yTop, const char* text, uint16_t fgColor, uint16_t outlineColor) {
   ensureFont();
-  if (text.isEmpty()) return;
+  if (!text || !text[0]) return;
 
   uint8_t previousDatum = tft.getTextDatum();
   uint16_t previousPadding = tft.getTextPadding();
@@ -293,13 +297,21 @@ void draw(int16_t x, int16_t yTop, const String& text, uint16_t fgColor, uint16_
   tft.setTextPadding(previousPadding);
 }
 
-void drawCentered(int16_t yTop, const String& text, uint16_t fgColor, uint16_t outlineColor) {
+void draw(int16_t x, int16_t yTop, const String& text, uint16_t fgColor, uint16_t outlineColor) {
+  draw(x, yTop, text.c_str(), fgColor, outlineColor);
+}
+
+void drawCentered(int16_t yTop, const char* text, uint16_t fgColor, uint16_t outlineColor) {
   ensureFont();
   int16_t x = (tft.width() - measure(text)) / 2;
   if (x < 0) x = 0;
   draw(x, yTop, text, fgColor, outlineColor);
 }
 
+void drawCentered(int16_t yTop, const String& text, uint16_t fgColor, uint16_t outlineColor) {
+  drawCentered(yTop, text.c_str(), fgColor, outlineColor);
+}
+
 int16_t helperLineHeight() {
   ensureFont();
   HelperFontState state = beginHelperFont();
@@ -309,7 +321,7 @@ int16_t helperLineHeight() {
   return height;
 }
 
-void drawHelperCentered(int16_t yTop, const String& text, uint16_t fgColor, uint16_t bgColor) {
+void drawHelperCentered(int16_t yTop, const char* text, uint16_t fgColor, uint16_t bgColor) {
   ensureFont();
   HelperFontState state = beginHelperFont();
   tft.setTextColor(fgColor, bgColor);
@@ -320,4 +332,8 @@ void drawHelperCentered(int16_t yTop, const String& text, uint16_t fgColor, uint
   endHelperFont(state);
 }
 
+void drawHelperCentered(int16_t yTop, const String& text, uint16_t fgColor, uint16_t bgColor) {
+  drawHelperCentered(yTop, text.c_str(), fgColor, bgColor);
+}
+
 }  // namespace TextRenderer
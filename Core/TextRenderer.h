@@ -11,10 +11,15 @@ void ensureLoaded();  // Ensure font is loaded, reload if needed
 int16_t lineHeight();
 int16_t ascent();
 int16_t descent();
+// const char* overloads draw without building a temporary String
+int16_t measure(const char* text);
 int16_t measure(const String& text);
 
+void draw(int16_t x, int16_t yTop, const char* text, uint16_t fgColor, uint16_t outlineColor);
 void draw(int16_t x, int16_t yTop, const String& text, uint16_t fgColor, uint16_t outlineColor);
+void drawCentered(int16_t yTop, const char* text, uint16_t fgColor, uint16_t outlineColor);
 void drawCentered(int16_t yTop, const String& text, uint16_t fgColor, uint16_t outlineColor);
 int16_t helperLineHeight();
+void drawHelperCentered(int16_t yTop, const char* text, uint16_t fgColor, uint16_t bgColor);
 void drawHelperCentered(int16_t yTop, const String& text, uint16_t fgColor, uint16_t bgColor);
 }  // namespace TextRenderer
@@ -0,0 +1,288 @@
+#include "ThumbnailCache.h"
+#include "SlidePreviewCache.h"
+#include "SlidePack.h"
+#include "BufferedFile.h"
+#include "Gfx.h"
+#include "Config.h"
+#include <algorithm>
+
+namespace {
+constexpr uint8_t kThumbMagic[4] = {'S', 'T', 'H', '1'};
+constexpr size_t kThumbHeaderSize = 8;  // magic + thumb size + 3 reserved
+constexpr const char* kSdThumbFile = "/.slidecache/thumbs.bin";
+constexpr const char* kFlashThumbFile = "/.thumbs.bin";
+constexpr size_t kStaleSlack = 16;      // rebuild once records > 2 * files + slack
+
+// Static instance pointer for the TJpgDec callback
+ThumbnailCache* activeThumbnailCache = nullptr;
+}
+
+bool ThumbnailCache::open(SlideSource source, size_t fileCount) {
+  close();
+  fs_ = filesystemFor(source);
+  if (!fs_) {
+    return false;
+  }
+  source_ = source;
+  cachePath_ = (source == SlideSource::SDCard) ? kSdThumbFile : kFlashThumbFile;
+  if (source == SlideSource::SDCard && !SD.exists(SlidePreviewCache::kCacheDir)) {
+    SD.mkdir(SlidePreviewCache::kCacheDir);  // ensureDirectory() is LittleFS only
+  }
+  return loadIndex_(fileCount);
+}
+
+void ThumbnailCache::close() {
+  if (reader_) {
+    reader_.close();
+  }
+  index_.clear();
+  index_.shrink_to_fit();
+  readerStale_ = false;
+  fs_ = nullptr;
+}
+
+bool ThumbnailCache::loadIndex_(size_t fileCount) {
+  index_.clear();
+
+  File f = fs_->open(cachePath_, FILE_READ);
+  if (!f) {
+    return true;  // no cache yet
+  }
+
+  const size_t total = f.size();
+  uint8_t header[kThumbHeaderSize];
+  const bool valid = total >= kThumbHeaderSize &&
+                     f.read(header, sizeof(header)) == sizeof(header) &&
+                     memcmp(header, kThumbMagic, sizeof(kThumbMagic)) == 0 &&
+                     header[4] == kThumbSize &&
+                     (total - kThumbHeaderSize) % kRecordSize == 0;
+  const size_t count = valid ? (total - kThumbHeaderSize) / kRecordSize : 0;
+
+  // Torn appends, format changes and piles of stale records: start over
+  if (!valid || count > fileCount * 2 + kStaleSlack) {
+    f.close();
+    fs_->remove(cachePath_);
+    #ifdef USB_DEBUG
+      Serial.printf("[Thumbs] rebuild %s (%u records)\n", cachePath_, static_cast<unsigned>(count));
+    #endif
+    return true;
+  }
+
+  index_.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    Key key;
+    if (!f.seek(kThumbHeaderSize + i * kRecordSize) ||
+        f.read(reinterpret_cast<uint8_t*>(&key), sizeof(key)) != sizeof(key)) {
+      break;
+    }
+    index_.push_back(key);
+  }
+  f.close();
+
+  #ifdef USB_DEBUG
+    Serial.printf("[Thumbs] %s: %u records\n", cachePath_, static_cast<unsigned>(index_.size()));
+  #endif
+  return true;
+}
+
+bool ThumbnailCache::keyFor_(const SlideFile& slide, Key& key) {
+  key.hash = SlidePreviewCache::pathHash(slide.path);
+  if (slide.packSlot >= 0) {
+    // Packed slides have no mtime, the append stamp changes on replacement just as well
+    SlidePack::Entry e;
+    if (!slidePack.entry(slide.packSlot, e)) {
+      return false;
+    }
+    key.size = e.size;
+    key.mtime = e.stamp;
+    return true;
+  }
+
+  // Size and mtime come from the directory scan, so a warm page opens no source file
+  if (slide.mtime != 0) {
+    key.size = slide.size;
+    key.mtime = slide.mtime;
+    return true;
+  }
+
+  File f = fs_->open(slide.path.c_str(), FILE_READ);
+  if (!f) {
+    return false;
+  }
+  key.size = f.size();
+  key.mtime = static_cast<uint32_t>(f.getLastWrite());
+  f.close();
+  return true;
+}
+
+int32_t ThumbnailCache::find_(const Key& key) const {
+  // Newest record wins if a photo was replaced with identical metadata
+  for (int32_t i = static_cast<int32_t>(index_.size()) - 1; i >= 0; --i) {
+    const Key& k = index_[i];
+    if (k.hash == key.hash && k.size == key.size && k.mtime == key.mtime) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+ThumbnailCache::Result ThumbnailCache::draw(const SlideFile& slide, int16_t x, int16_t y, bool allowGenerate) {
+  if (!fs_ || slide.type != SlideMediaType::Jpeg) {
+    return Result::Failed;
+  }
+  if (source_ == SlideSource::Flash) {
+    digitalWrite(SD_CS_PIN, HIGH);
+  }
+
+  Key key;
+  if (!keyFor_(slide, key)) {
+    return Result::Failed;
+  }
+
+  const int32_t slot = find_(key);
+  if (slot >= 0) {
+    if (readerStale_ && reader_) {
+      reader_.close();
+    }
+    readerStale_ = false;
+    if (!reader_) {
+      reader_ = fs_->open(cachePath_, FILE_READ);
+    }
+    const size_t offset = kThumbHeaderSize + static_cast<size_t>(slot) * kRecordSize + sizeof(Key);
+    const size_t bytes = kRecordPixels * sizeof(uint16_t);
+    if (reader_ && reader_.seek(offset) &&
+        reader_.read(reinterpret_cast<uint8_t*>(pixels_), bytes) == bytes) {
+      tft.pushImage(x, y, kThumbSize, kThumbSize, pixels_);
+      return Result::Drawn;
+    }
+  }
+
+  if (!allowGenerate) {
+    return Result::Missing;
+  }
+  const Result result = generate_(slide, key);
+  if (result == Result::Generated) {
+    tft.pushImage(x, y, kThumbSize, kThumbSize, pixels_);
+  }
+  return result;
+}
+
+ThumbnailCache::Result ThumbnailCache::generate_(const SlideFile& slide, const Key& key) {
+  const String& srcPath = slide.path;
+  uint16_t w = 0;
+  uint16_t h = 0;
+  const JRESULT sizeRc = (source_ == SlideSource::SDCard)
+                             ? getSdJpgSizeBuffered(&w, &h, srcPath.c_str())
+                             : getFlashJpgSize(&w, &h, slide);
+  if (sizeRc != JDR_OK || w == 0 || h == 0) {
+    return Result::Failed;
+  }
+
+  // Strongest downscale that still leaves at least one thumbnail of detail
+  uint8_t scale = 8;
+  while (scale > 1 && std::max(w, h) / scale < kThumbSize) {
+    scale >>= 1;
+  }
+  decW_ = std::max<uint16_t>(1, w / scale);
+  decH_ = std::max<uint16_t>(1, h / scale);
+  const uint16_t longest = std::max(decW_, decH_);
+  thumbW_ = std::max<uint16_t>(1, static_cast<uint32_t>(decW_) * kThumbSize / longest);
+  thumbH_ = std::max<uint16_t>(1, static_cast<uint32_t>(decH_) * kThumbSize / longest);
+  padX_ = (kThumbSize - thumbW_) / 2;
+  padY_ = (kThumbSize - thumbH_) / 2;
+  memset(pixels_, 0, sizeof(pixels_));
+  cancelled_ = false;
+
+  #ifdef USB_DEBUG
+    const uint32_t started = millis();
+  #endif
+  activeThumbnailCache = this;
+  TJpgDec.setJpgScale(scale);
+  TJpgDec.setCallback(collectBlock_);
+  JRESULT rc;
+  if (source_ == SlideSource::SDCard) {
+    rc = drawSdJpgBuffered(0, 0, srcPath.c_str());
+  } else {
+    rc = drawFlashJpg(0, 0, slide);
+  }
+  TJpgDec.setCallback(gfxJpegOutput);
+  TJpgDec.setJpgScale(1);
+  activeThumbnailCache = nullptr;
+
+  if (cancelled_) {
+    return Result::Cancelled;
+  }
+  if (rc != JDR_OK) {
+    #ifdef USB_DEBUG
+      Serial.printf("[Thumbs] FAIL (%d): %s\n", rc, srcPath.c_str());
+    #endif
+    return Result::Failed;
+  }
+
+  #ifdef USB_DEBUG
+    Serial.printf("[Thumbs] %s 1/%u in %lu ms\n", srcPath.c_str(), scale,
+                  static_cast<unsigned long>(millis() - started));
+  #endif
+
+  // A full flash only costs the cache, the thumbnail is still shown
+  append_(key);
+  return Result::Generated;
+}
+
+bool ThumbnailCache::append_(const Key& key) {
+  File f = fs_->open(cachePath_, FILE_APPEND);
+  if (!f) {
+    return false;
+  }
+  bool ok = true;
+  if (f.size() == 0) {
+    uint8_t header[kThumbHeaderSize] = {0};
+    memcpy(header, kThumbMagic, sizeof(kThumbMagic));
+    header[4] = kThumbSize;
+    ok = f.write(header, sizeof(header)) == sizeof(header);
+  }
+  const size_t bytes = kRecordPixels * sizeof(uint16_t);
+  ok = ok && f.write(reinterpret_cast<const uint8_t*>(&key), sizeof(key)) == sizeof(key);
+  ok = ok && f.write(reinterpret_cast<const uint8_t*>(pixels_), bytes) == bytes;
+  f.close();
+
+  if (!ok) {
+    // A partial record would misalign every later one
+    fs_->remove(cachePath_);
+    index_.clear();
+    readerStale_ = true;
+    return false;
+  }
+  index_.push_back(key);
+  readerStale_ = true;
+  return true;
+}
+
+bool ThumbnailCache::collectBlock_(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t* bitmap) {
+  ThumbnailCache* self = activeThumbnailCache;
+  if (!self) return false;
+
+  if (digitalRead(BTN1_PIN) == LOW || digitalRead(BTN2_PIN) == LOW) {
+    self->cancelled_ = true;
+    return false;
+  }
+
+  const uint32_t decW = self->decW_;
+  const uint32_t decH = self->decH_;
+  const uint32_t thumbW = self->thumbW_;
+  const uint32_t thumbH = self->thumbH_;
+
+  // Nearest-neighbour sampling of the block into the thumbnail
+  for (uint32_t oy = (static_cast<uint32_t>(y) * thumbH + decH - 1) / decH; oy < thumbH; ++oy) {
+    const uint32_t sy = oy * decH / thumbH;
+    if (sy >= static_cast<uint32_t>(y + h)) break;
+    uint16_t* dst = self->pixels_ + (self->padY_ + oy) * kThumbSize + self->padX_;
+    const uint16_t* src = bitmap + (sy - y) * w;
+    for (uint32_t ox = (static_cast<uint32_t>(x) * thumbW + decW - 1) / decW; ox < thumbW; ++ox) {
+      const uint32_t sx = ox * decW / thumbW;
+      if (sx >= static_cast<uint32_t>(x + w)) break;
+      dst[ox] = src[sx - x];
+    }
+  }
+  return true;
+}
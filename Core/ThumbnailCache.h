@@ -0,0 +1,84 @@
+#ifndef THUMBNAILCACHE_H
+#define THUMBNAILCACHE_H
+
+#include <Arduino.h>
+#include <vector>
+#include <FS.h>
+
+#include "Storage.h"
+
+/**
+ * ThumbnailCache - persistent thumbnails for the slideshow grid browser
+ *
+ * Every slide source keeps one compact cache file with fixed-size records:
+ * a 12-byte key (path hash, size, mtime) followed by a kThumbSize^2 RGB565
+ * thumbnail in panel byte order. Painting a grid page is therefore one
+ * seek + read + pushImage per cell, without touching the JPEGs again.
+ *
+ * Missing thumbnails are produced by a downscaled TJpgDec decode (1/8
+ * where the photo is large enough) and appended to the file. Stale records
+ * of replaced photos are only dropped when the file is rebuilt, which
+ * happens once it holds far more records than the source has files.
+ */
+class ThumbnailCache {
+ public:
+  static constexpr uint8_t kThumbSize = 48;
+
+  enum class Result : uint8_t {
+    Drawn = 0,   // served from the cache file
+    Generated,   // decoded now and appended
+    Missing,     // not cached, generation not allowed
+    Cancelled,   // button pressed during the decode
+    Failed       // not a JPEG or undecodable
+  };
+
+  /**
+   * Load the record index of the cache file for the given source.
+   */
+  bool open(SlideSource source, size_t fileCount);
+  void close();
+  bool isOpen() const { return fs_ != nullptr; }
+
+  /**
+   * Draw the thumbnail of a slide with its top-left corner at (x, y).
+   * With allowGenerate a missing thumbnail is decoded and stored first.
+   */
+  Result draw(const SlideFile& slide, int16_t x, int16_t y, bool allowGenerate);
+
+ private:
+  struct Key {
+    uint32_t hash = 0;
+    uint32_t size = 0;
+    uint32_t mtime = 0;
+  };
+
+  static constexpr size_t kRecordPixels = static_cast<size_t>(kThumbSize) * kThumbSize;
+  static constexpr size_t kRecordSize = sizeof(Key) + kRecordPixels * sizeof(uint16_t);
+
+  static bool collectBlock_(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t* bitmap);
+
+  bool keyFor_(const SlideFile& slide, Key& key);
+  int32_t find_(const Key& key) const;
+  bool loadIndex_(size_t fileCount);
+  Result generate_(const SlideFile& slide, const Key& key);
+  bool append_(const Key& key);
+
+  fs::FS* fs_ = nullptr;
+  SlideSource source_ = SlideSource::SDCard;
+  const char* cachePath_ = nullptr;
+  std::vector<Key> index_;
+  File reader_;
+  bool readerStale_ = false;  // reader_ opened before the last append
+
+  // One thumbnail, shared by cache reads and decodes
+  uint16_t pixels_[kRecordPixels];
+  uint16_t decW_ = 0;
+  uint16_t decH_ = 0;
+  uint16_t thumbW_ = 0;
+  uint16_t thumbH_ = 0;
+  uint16_t padX_ = 0;
+  uint16_t padY_ = 0;
+  bool cancelled_ = false;
+};
+
+#endif // THUMBNAILCACHE_H
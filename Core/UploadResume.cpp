@@ -0,0 +1,118 @@
+#include "UploadResume.h"
+#include "UploadSink.h"
+#include "ImageProbe.h"
+
+#include <LittleFS.h>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+constexpr char kResumeMagic[4] = {'R', 'S', 'M', '1'};
+constexpr size_t kResumeReplayChunk = 512;
+
+bool resumeRead(UploadResume::Record& rec) {
+  File f = LittleFS.open(UploadResume::kPath, FILE_READ);
+  if (!f) {
+    return false;
+  }
+  const bool ok = f.read(reinterpret_cast<uint8_t*>(&rec), sizeof(rec)) == sizeof(rec) &&
+                  std::memcmp(rec.magic, kResumeMagic, sizeof(kResumeMagic)) == 0;
+  f.close();
+  rec.path[UploadResume::kPathLen - 1] = '\0';
+  return ok;
+}
+
+// Record and its part file
+void resumeDrop(const UploadResume::Record& rec) {
+  if (rec.path[0]) {
+    LittleFS.remove(String(rec.path) + kUploadPartSuffix);
+  }
+  LittleFS.remove(UploadResume::kPath);
+}
+}
+
+namespace UploadResume {
+
+static_assert(sizeof(Record) == 128, "resume record is 128 bytes on flash");
+
+bool save(const String& path, uint32_t size, uint32_t offset, uint32_t crc) {
+  if (path.length() >= kPathLen || offset == 0) {
+    LittleFS.remove(path + kUploadPartSuffix);
+    return false;
+  }
+  Record old;
+  if (LittleFS.exists(kPath) && resumeRead(old) && path != old.path) {
+    resumeDrop(old);  // only one partial upload is kept
+  }
+
+  Record rec{};
+  std::memcpy(rec.magic, kResumeMagic, sizeof(rec.magic));
+  rec.size = size;
+  rec.offset = offset;
+  rec.crc = crc;
+  std::strncpy(rec.path, path.c_str(), sizeof(rec.path) - 1);
+
+  File f = LittleFS.open(kPath, FILE_WRITE);
+  const bool ok = f && f.write(reinterpret_cast<const uint8_t*>(&rec), sizeof(rec)) == sizeof(rec);
+  if (f) {
+    f.close();
+  }
+  #ifdef USB_DEBUG
+    Serial.printf("[Resume] keep %s at %lu/%lu%s\n", rec.path, static_cast<unsigned long>(offset),
+                  static_cast<unsigned long>(size), ok ? "" : " WRITE FAIL");
+  #endif
+  return ok;
+}
+
+uint32_t load(const String& path, uint32_t size, ImageProbe& probe, uint32_t* crc) {
+  Record rec;
+  if (!LittleFS.exists(kPath) || !resumeRead(rec) || path != rec.path) {
+    return 0;
+  }
+
+  File part = LittleFS.open(String(rec.path) + kUploadPartSuffix, FILE_READ);
+  if (rec.size != size || rec.offset == 0 || rec.offset > size || !part || part.size() != rec.offset) {
+    if (part) {
+      part.close();
+    }
+    resumeDrop(rec);  // other file under that name, or the part does not match
+    return 0;
+  }
+
+  // Only the headers decide the verdict; the CRC of the rest is in the record
+  uint8_t buf[kResumeReplayChunk];
+  uint32_t pos = 0;
+  while (pos < rec.offset && probe.verdict() == ImageProbe::Verdict::NeedMore) {
+    const size_t n = part.read(buf, std::min<size_t>(sizeof(buf), rec.offset - pos));
+    if (n == 0) {
+      break;
+    }
+    probe.feed(buf, n);
+    pos += n;
+  }
+  part.close();
+  if (probe.verdict() == ImageProbe::Verdict::Unsupported ||
+      (pos < rec.offset && probe.verdict() == ImageProbe::Verdict::NeedMore)) {
+    resumeDrop(rec);
+    return 0;
+  }
+
+  probe.restoreCrc(rec.crc);
+  if (crc) {
+    *crc = rec.crc;
+  }
+  #ifdef USB_DEBUG
+    Serial.printf("[Resume] %s from %lu/%lu\n", rec.path, static_cast<unsigned long>(rec.offset),
+                  static_cast<unsigned long>(rec.size));
+  #endif
+  return rec.offset;
+}
+
+void forget(const String& path) {
+  Record rec;
+  if (LittleFS.exists(kPath) && resumeRead(rec) && path == rec.path) {
+    LittleFS.remove(kPath);
+  }
+}
+
+}  // namespace UploadResume
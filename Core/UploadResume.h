@@ -0,0 +1,49 @@
+#ifndef UPLOADRESUME_H
+#define UPLOADRESUME_H
+
+#include <Arduino.h>
+
+class ImageProbe;
+
+/**
+ * Partial uploads kept for RESUME
+ *
+ * When a USB or BLE upload times out or the link drops, the receiver keeps
+ * what it wrote as "<path>.part" and records it in kPath: target path,
+ * announced size, bytes on flash and the CRC-32 of those bytes. A later
+ * RESUME with the same name and size continues at that offset; the host
+ * compares the CRC with its own file first and starts over if they
+ * differ.
+ *
+ * There is one record, so at most one partial upload occupies flash:
+ * keeping a new one deletes the previous part file.
+ */
+namespace UploadResume {
+
+constexpr const char* kPath = "/.resume";
+constexpr size_t kPathLen = 112;
+
+struct Record {
+  char magic[4];        // "RSM1"
+  uint32_t size;        // announced upload size
+  uint32_t offset;      // bytes in the part file
+  uint32_t crc;         // CRC-32 of those bytes
+  char path[kPathLen];  // final path, without ".part"
+};
+
+bool save(const String& path, uint32_t size, uint32_t offset, uint32_t crc);
+
+/**
+ * Offset the upload of path can continue from, 0 if there is nothing to
+ * resume (a stale part is deleted then). On success the probe has seen the
+ * headers of the part again and carries its CRC, which is also stored in
+ * *crc.
+ */
+uint32_t load(const String& path, uint32_t size, ImageProbe& probe, uint32_t* crc);
+
+// Drop the record if it belongs to path (upload done or started afresh)
+void forget(const String& path);
+
+}  // namespace UploadResume
+
+#endif // UPLOADRESUME_H
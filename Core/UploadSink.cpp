@@ -0,0 +1,349 @@
+#include "UploadSink.h"
+#include "SlidePack.h"
+
+#include <LittleFS.h>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+constexpr uint32_t kSinkTaskStack = 4096;
+constexpr UBaseType_t kSinkTaskPriority = 1;
+constexpr BaseType_t kSinkTaskCore = 0;  // the loop and the receivers run on core 1
+}
+
+bool UploadSink::start_() {
+  if (!free_) {
+    free_ = xQueueCreate(kUploadSinkBuffers, sizeof(uint8_t));
+    // Every buffer plus one commit per file slot can be queued at once
+    full_ = xQueueCreate(kUploadSinkBuffers + kUploadSinkFiles, sizeof(Op));
+  }
+  if (!free_ || !full_) {
+    return false;
+  }
+  if (!task_ &&
+      xTaskCreatePinnedToCore(writerTask_, "upload", kSinkTaskStack, this, kSinkTaskPriority,
+                              &task_, kSinkTaskCore) != pdPASS) {
+    task_ = nullptr;
+    return false;
+  }
+
+  fill_ = -1;
+  fillLen_ = 0;
+  if (buffers_[0]) {
+    return true;  // still circulating after finishAsync()
+  }
+  for (uint8_t i = 0; i < kUploadSinkBuffers; ++i) {
+    buffers_[i] = static_cast<uint8_t*>(malloc(kUploadSinkBufferBytes));
+    if (!buffers_[i]) {
+      release_();
+      return false;
+    }
+  }
+  // Queue is empty here: drain_() took every buffer back
+  for (uint8_t i = 0; i < kUploadSinkBuffers; ++i) {
+    xQueueSend(free_, &i, 0);
+  }
+  return true;
+}
+
+void UploadSink::claimSlot_(const String& path) {
+  // A slot is free once its commit ran; the same path must not have two part files
+  for (;;) {
+    int8_t slot = -1;
+    bool samePath = false;
+    for (uint8_t i = 0; i < kUploadSinkFiles; ++i) {
+      if (busy_[i].load(std::memory_order_acquire)) {
+        samePath = samePath || paths_[i] == path;  // the writer only reads it
+      } else if (slot < 0) {
+        slot = static_cast<int8_t>(i);
+      }
+    }
+    if (slot >= 0 && !samePath) {
+      slot_ = static_cast<uint8_t>(slot);
+      failed_[slot_] = false;
+      return;
+    }
+    vTaskDelay(1);
+  }
+}
+
+bool UploadSink::pending(const String& path) const {
+  for (uint8_t i = 0; i < kUploadSinkFiles; ++i) {
+    if (busy_[i].load(std::memory_order_acquire) && paths_[i] == path) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool commitPartFile(const String& path) {
+  const String temp = path + kUploadPartSuffix;
+  if (LittleFS.rename(temp, path)) {
+    return true;
+  }
+  // Not every LittleFS port replaces an existing target
+  LittleFS.remove(path);
+  return LittleFS.rename(temp, path);
+}
+
+bool UploadSink::beginFile(const String& path, size_t offset) {
+  if (active()) {
+    abort();
+  }
+  if (!start_()) {
+    return false;
+  }
+  claimSlot_(path);
+  File& file = files_[slot_];
+  const String temp = path + kUploadPartSuffix;
+  if (offset > 0) {
+    file = LittleFS.open(temp.c_str(), FILE_APPEND);
+    if (file && file.size() != offset) {
+      file.close();
+    }
+  } else {
+    if (LittleFS.exists(temp)) {
+      LittleFS.remove(temp);  // left over from a reset during an upload
+    }
+    file = LittleFS.open(temp.c_str(), FILE_WRITE);
+  }
+  if (!file) {
+    drain_(false);
+    release_();
+    return false;
+  }
+  paths_[slot_] = path;
+  target_ = Target::File;
+  return true;
+}
+
+bool UploadSink::beginPack(const char* name, SlideMediaType type, size_t size) {
+  if (active()) {
+    abort();
+  }
+  if (!start_()) {
+    return false;
+  }
+  slot_ = kPackSlot;
+  failed_[slot_] = false;
+  if (!slidePack.beginAppend(name, type, size)) {
+    drain_(false);
+    release_();
+    return false;
+  }
+  target_ = Target::Pack;
+  return true;
+}
+
+size_t UploadSink::space() const {
+  if (!active()) {
+    return 0;
+  }
+  size_t bytes = uxQueueMessagesWaiting(free_) * kUploadSinkBufferBytes;
+  if (fill_ >= 0) {
+    bytes += kUploadSinkBufferBytes - fillLen_;
+  }
+  return bytes;
+}
+
+size_t UploadSink::write(const uint8_t* data, size_t len, TickType_t wait) {
+  if (!active()) {
+    return 0;
+  }
+  size_t done = 0;
+  while (done < len) {
+    if (fill_ < 0) {
+      uint8_t index;
+      if (xQueueReceive(free_, &index, wait) != pdTRUE) {
+        break;  // both buffers with the writer
+      }
+      fill_ = static_cast<int8_t>(index);
+      fillLen_ = 0;
+    }
+    const size_t n = std::min(len - done, kUploadSinkBufferBytes - fillLen_);
+    std::memcpy(buffers_[fill_] + fillLen_, data + done, n);
+    fillLen_ += n;
+    done += n;
+    if (fillLen_ == kUploadSinkBufferBytes) {
+      const Op op{OpKind::Write, slot_, static_cast<uint8_t>(fill_), static_cast<uint16_t>(fillLen_)};
+      xQueueSend(full_, &op, portMAX_DELAY);
+      fill_ = -1;
+      fillLen_ = 0;
+    }
+  }
+  return done;
+}
+
+void UploadSink::drain_(bool flushPartial) {
+  // Take every buffer back; afterwards the writer has stored all data.
+  // Commits of earlier files may still be queued, they need no buffer.
+  if (!buffers_[0]) {
+    return;
+  }
+  uint8_t held = 0;
+  if (fill_ >= 0) {
+    if (flushPartial && fillLen_ > 0) {
+      const Op op{OpKind::Write, slot_, static_cast<uint8_t>(fill_), static_cast<uint16_t>(fillLen_)};
+      xQueueSend(full_, &op, portMAX_DELAY);
+    } else {
+      held = 1;
+    }
+    fill_ = -1;
+    fillLen_ = 0;
+  }
+  uint8_t index;
+  for (uint8_t i = held; i < kUploadSinkBuffers; ++i) {
+    xQueueReceive(free_, &index, portMAX_DELAY);
+  }
+}
+
+void UploadSink::release_() {
+  for (uint8_t i = 0; i < kUploadSinkBuffers; ++i) {
+    free(buffers_[i]);
+    buffers_[i] = nullptr;
+  }
+  if (target_ == Target::File) {
+    if (files_[slot_]) {
+      files_[slot_].close();
+    }
+    files_[slot_] = File();
+    paths_[slot_] = String();
+  }
+  target_ = Target::None;
+}
+
+bool UploadSink::finish() {
+  if (!active()) {
+    return false;
+  }
+  const bool ok = finishAsync();
+  return settle() == 0 && ok;
+}
+
+bool UploadSink::finishAsync() {
+  if (!active()) {
+    return false;
+  }
+  if (target_ == Target::Pack) {
+    // SlidePack has one append at a time, nothing to overlap
+    drain_(true);
+    bool ok = !failed_[slot_];
+    if (ok) {
+      ok = slidePack.commitAppend();
+    } else {
+      slidePack.abortAppend();
+    }
+    release_();
+    return ok;
+  }
+  if (failed_[slot_]) {
+    abort();  // reported here, not again by settle()
+    return false;
+  }
+
+  if (fill_ >= 0 && fillLen_ > 0) {
+    const Op op{OpKind::Write, slot_, static_cast<uint8_t>(fill_), static_cast<uint16_t>(fillLen_)};
+    xQueueSend(full_, &op, portMAX_DELAY);
+  } else if (fill_ >= 0) {
+    const uint8_t index = static_cast<uint8_t>(fill_);
+    xQueueSend(free_, &index, portMAX_DELAY);
+  }
+  fill_ = -1;
+  fillLen_ = 0;
+
+  busy_[slot_].store(true, std::memory_order_release);
+  const Op commit{OpKind::Commit, slot_, 0, 0};
+  xQueueSend(full_, &commit, portMAX_DELAY);
+  // The slot belongs to the writer now; buffers stay allocated for the next file
+  target_ = Target::None;
+  return true;
+}
+
+uint16_t UploadSink::settle() {
+  for (uint8_t i = 0; i < kUploadSinkFiles; ++i) {
+    while (busy_[i].load(std::memory_order_acquire)) {
+      vTaskDelay(1);
+    }
+  }
+  if (!active()) {
+    drain_(false);
+    release_();
+  }
+  return commitFailures_.exchange(0);
+}
+
+void UploadSink::abort() {
+  if (!active()) {
+    return;
+  }
+  drain_(false);
+  if (target_ == Target::File) {
+    files_[slot_].close();
+    LittleFS.remove(paths_[slot_] + kUploadPartSuffix);
+  } else {
+    slidePack.abortAppend();
+  }
+  release_();
+}
+
+bool UploadSink::suspend() {
+  if (target_ != Target::File) {
+    abort();
+    return false;
+  }
+  drain_(true);
+  files_[slot_].close();
+  const bool ok = !failed_[slot_];
+  if (!ok) {
+    LittleFS.remove(paths_[slot_] + kUploadPartSuffix);
+  }
+  release_();
+  return ok;
+}
+
+void UploadSink::commitSlot_(UploadSink* sink, uint8_t slot) {
+  File& file = sink->files_[slot];
+  if (file) {
+    file.close();
+  }
+  // A copy: the receiver reassigns paths_[slot] as soon as busy_ is clear
+  const String path = sink->paths_[slot];
+  const bool ok = !sink->failed_[slot] && commitPartFile(path);
+  if (!ok) {
+    LittleFS.remove(path + kUploadPartSuffix);
+    sink->commitFailures_.fetch_add(1);
+    #ifdef USB_DEBUG
+      Serial.printf("[Sink] commit %s failed\n", path.c_str());
+    #endif
+  }
+  file = File();
+  sink->busy_[slot].store(false, std::memory_order_release);
+}
+
+void UploadSink::writerTask_(void* arg) {
+  UploadSink* sink = static_cast<UploadSink*>(arg);
+  Op op;
+  for (;;) {
+    if (xQueueReceive(sink->full_, &op, portMAX_DELAY) != pdTRUE) {
+      continue;
+    }
+    if (op.kind == OpKind::Commit) {
+      commitSlot_(sink, op.slot);
+      continue;
+    }
+    // After the first error the rest of that upload is dropped; finish() reports it
+    if (!sink->failed_[op.slot]) {
+      const uint8_t* data = sink->buffers_[op.index];
+      const bool ok = (op.slot == kPackSlot)
+                          ? slidePack.write(data, op.len)
+                          : sink->files_[op.slot].write(data, op.len) == op.len;
+      if (!ok) {
+        sink->failed_[op.slot] = true;
+        #ifdef USB_DEBUG
+          Serial.printf("[Sink] write failed\n");
+        #endif
+      }
+    }
+    xQueueSend(sink->free_, &op.index, portMAX_DELAY);
+  }
+}
@@ -0,0 +1,113 @@
+#ifndef UPLOADSINK_H
+#define UPLOADSINK_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
+#include "Storage.h"
+
+/**
+ * Streaming flash writer for uploads
+ *
+ * The receiver copies incoming bytes into one of kUploadSinkBuffers fixed
+ * buffers; a full buffer goes to a writer task that stores it while the
+ * receiver keeps filling the other one. Peak RAM is the buffers, whatever
+ * the upload size.
+ *
+ * Loose files are written to "<path>.part" and renamed over the target by
+ * finish(), so an aborted upload never leaves a half file behind and an
+ * overwritten file stays intact until the new one is complete. Pack
+ * targets go through SlidePack::beginAppend/write/commitAppend; the pack
+ * itself only lists the slide once it is committed.
+ *
+ * write() takes only what fits (space()); the caller leaves the rest in
+ * its input until the writer has caught up.
+ *
+ * suspend() keeps the written part of a file upload for a later RESUME
+ * (UploadResume.h); beginFile() with an offset appends to it.
+ *
+ * For batches finishAsync() queues the close and rename of a file behind its
+ * last buffer and returns at once, so the next file can be received while
+ * the writer is still flushing the previous one; there are kUploadSinkFiles
+ * file slots for that. settle() waits for the queued commits and reports how
+ * many failed. A slot's file and path belong to the writer from the commit
+ * until it clears busy_ (release); the receiver only touches them again
+ * after seeing that (acquire), and only the receiver assigns the path.
+ */
+constexpr size_t kUploadSinkBufferBytes = 8192;
+constexpr uint8_t kUploadSinkBuffers = 2;
+constexpr uint8_t kUploadSinkFiles = 2;  // file being received + one being committed
+constexpr const char* kUploadPartSuffix = ".part";
+
+// Rename "<path>.part" over path
+bool commitPartFile(const String& path);
+
+class UploadSink {
+ public:
+  bool beginFile(const String& path, size_t offset = 0);
+  bool beginPack(const char* name, SlideMediaType type, size_t size);
+
+  size_t space() const;
+  // Up to len bytes; with wait > 0 blocks that long for the writer to free a buffer
+  size_t write(const uint8_t* data, size_t len, TickType_t wait = 0);
+
+  // Waits for the writer, then renames or commits. False on any write error.
+  bool finish();
+  // Queues the rename and returns; packs still commit here. False on a write error so far,
+  // later errors count in settle().
+  bool finishAsync();
+  // Waits for queued commits, returns how many failed since the last call
+  uint16_t settle();
+  // Waits for the writer, then drops the temp file or the pack entry
+  void abort();
+  // Waits for the writer and closes the temp file but keeps it. False on a write error.
+  bool suspend();
+
+  // A queued commit will create path (its .part is not renamed yet)
+  bool pending(const String& path) const;
+
+  bool active() const { return target_ != Target::None; }
+  bool resumable() const { return target_ == Target::File; }
+  bool failed() const { return active() && failed_[slot_]; }
+
+ private:
+  enum class Target : uint8_t { None = 0, File, Pack };
+  enum class OpKind : uint8_t { Write = 0, Commit };
+
+  // Work for the writer task; Commit carries no buffer
+  struct Op {
+    OpKind kind;
+    uint8_t slot;
+    uint8_t index;
+    uint16_t len;
+  };
+
+  static constexpr uint8_t kPackSlot = kUploadSinkFiles;
+
+  bool start_();
+  void claimSlot_(const String& path);
+  void drain_(bool flushPartial);
+  void release_();
+  static void commitSlot_(UploadSink* sink, uint8_t slot);
+  static void writerTask_(void* arg);
+
+  Target target_ = Target::None;
+  uint8_t slot_ = 0;       // slot of the current upload, kPackSlot for packs
+  File files_[kUploadSinkFiles];
+  String paths_[kUploadSinkFiles];  // written by the receiver only
+  std::atomic<bool> busy_[kUploadSinkFiles] = {};  // commit queued, slot not free yet
+  std::atomic<bool> failed_[kUploadSinkFiles + 1] = {};
+  std::atomic<uint16_t> commitFailures_{0};
+  uint8_t* buffers_[kUploadSinkBuffers] = {};
+  int8_t fill_ = -1;       // buffer being filled, -1 if none
+  size_t fillLen_ = 0;
+  QueueHandle_t free_ = nullptr;
+  QueueHandle_t full_ = nullptr;
+  TaskHandle_t task_ = nullptr;
+};
+
+#endif // UPLOADSINK_H
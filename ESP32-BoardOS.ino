@@ -14,6 +14,7 @@
 #include "Apps/TextApp.h"
 #include "Apps/LuaApp.h"
 #include "Core/Storage.h"
+#include "Core/SlidePack.h"
 #include "Core/BleImageTransfer.h"
 #include "Core/SerialImageTransfer.h"
 #include "Core/SystemUI.h"
@@ -67,6 +68,7 @@ void setup() {
     lfs_ok = mountLittleFs(true);
   }
   if (lfs_ok) {
+    slidePack.begin();
     if (!ensureFlashSlidesDir()) {
       #ifdef USB_DEBUG
         Serial.println("[BOOT] ensureFlashSlidesDir failed");
@@ -360,6 +362,24 @@ void loop() {
 #include "Core/SetupMenu.cpp"
 #include "Core/SystemUI.cpp"
 #include "Core/SDCopyEngine.cpp"
+#include "Core/SlidePreviewCache.cpp"
+#include "Core/ThumbnailCache.cpp"
+#include "Core/SlidePack.cpp"
+#include "Core/GifFrameCache.cpp"
+#include "Core/GifCanvas.cpp"
+#include "Core/DeltaAnim.cpp"
+#include "Core/QoiImage.cpp"
+#include "Core/Crc32.cpp"
+#include "Core/ImageProbe.cpp"
+#include "Core/SlideMeta.cpp"
+#include "Core/SdFastSeek.cpp"
+#include "Core/BufferedFile.cpp"
+#include "Core/UploadSink.cpp"
+#include "Core/UploadResume.cpp"
+#include "Core/HashCache.cpp"
+#include "Core/Heatshrink.cpp"
+#include "Core/DeltaSync.cpp"
+#include "Core/RxRing.cpp"
 #include "Core/Gfx.cpp"
 #include "Core/Storage.cpp"
 #include "Core/TextRenderer.cpp"
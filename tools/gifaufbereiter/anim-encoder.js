@@ -0,0 +1,170 @@
+// Encoder für das native Delta-Animationsformat der Brosche (.anm, "ANM1").
+// Layout siehe Core/DeltaAnim.h: Header, Frame-Index, dann pro Frame nur die
+// geänderten Rechtecke als RLE-kodierte RGB565-Pixel (High-Byte zuerst).
+
+const MAGIC = [0x41, 0x4e, 0x4d, 0x31]; // "ANM1"
+const HEADER_SIZE = 24;
+const REPEAT_FLAG = 0x8000;
+const MAX_PACKET = 0x7fff;
+const MIN_REPEAT = 3;       // kürzere Wiederholungen bleiben literal
+const MERGE_ROW_GAP = 4;    // Bänder mit kleinerem Abstand werden zusammengelegt
+
+function pushLe16(out, value) {
+  out.push(value & 0xff, (value >> 8) & 0xff);
+}
+
+function pushLe32(out, value) {
+  out.push(value & 0xff, (value >>> 8) & 0xff, (value >>> 16) & 0xff, (value >>> 24) & 0xff);
+}
+
+function toRgb565(imageData, bgRGB) {
+  const { data, width, height } = imageData;
+  const out = new Uint16Array(width * height);
+  for (let i = 0, p = 0; i < out.length; i++, p += 4) {
+    const a = data[p + 3] / 255;
+    // Transparenz gibt es im Format nicht: über den Hintergrund legen
+    const r = Math.round(data[p] * a + bgRGB[0] * (1 - a));
+    const g = Math.round(data[p + 1] * a + bgRGB[1] * (1 - a));
+    const b = Math.round(data[p + 2] * a + bgRGB[2] * (1 - a));
+    out[i] = ((r & 0xf8) << 8) | ((g & 0xfc) << 3) | (b >> 3);
+  }
+  return out;
+}
+
+// Geänderte Zeilen zu Bändern gruppieren, je Band die gemeinsame x-Spanne
+function findDirtyRects(prev, next, width, height) {
+  const rects = [];
+  let band = null;
+  let gap = 0;
+  for (let y = 0; y < height; y++) {
+    const row = y * width;
+    let x0 = -1;
+    let x1 = -1;
+    for (let x = 0; x < width; x++) {
+      if (prev[row + x] !== next[row + x]) {
+        if (x0 < 0) x0 = x;
+        x1 = x;
+      }
+    }
+    if (x0 < 0) {
+      if (band) {
+        gap += 1;
+        if (gap > MERGE_ROW_GAP) {
+          rects.push(band);
+          band = null;
+        }
+      }
+      continue;
+    }
+    if (band) {
+      band.x0 = Math.min(band.x0, x0);
+      band.x1 = Math.max(band.x1, x1);
+      band.y1 = y;
+    } else {
+      band = { x0, x1, y0: y, y1: y };
+    }
+    gap = 0;
+  }
+  if (band) rects.push(band);
+  return rects.map((r) => ({ x: r.x0, y: r.y0, w: r.x1 - r.x0 + 1, h: r.y1 - r.y0 + 1 }));
+}
+
+function encodeRect(out, pixels, width, rect) {
+  // Pixel des Rechtecks zeilenweise, Pakete laufen über Zeilenenden hinweg
+  const span = new Uint16Array(rect.w * rect.h);
+  for (let y = 0; y < rect.h; y++) {
+    const src = (rect.y + y) * width + rect.x;
+    span.set(pixels.subarray(src, src + rect.w), y * rect.w);
+  }
+
+  const body = [];
+  const pushColor = (c) => body.push((c >> 8) & 0xff, c & 0xff);
+  let i = 0;
+  while (i < span.length) {
+    let same = 1;
+    while (i + same < span.length && same < MAX_PACKET && span[i + same] === span[i]) same++;
+    if (same >= MIN_REPEAT) {
+      pushLe16(body, REPEAT_FLAG | same);
+      pushColor(span[i]);
+      i += same;
+      continue;
+    }
+    let lit = 0;
+    while (i + lit < span.length && lit < MAX_PACKET) {
+      const c = span[i + lit];
+      if (i + lit + 2 < span.length && span[i + lit + 1] === c && span[i + lit + 2] === c) break;
+      lit++;
+    }
+    pushLe16(body, lit);
+    for (let k = 0; k < lit; k++) pushColor(span[i + k]);
+    i += lit;
+  }
+
+  pushLe16(out, rect.x);
+  pushLe16(out, rect.y);
+  pushLe16(out, rect.w);
+  pushLe16(out, rect.h);
+  pushLe32(out, body.length);
+  for (let k = 0; k < body.length; k++) out.push(body[k]);
+}
+
+export class AnimEncoder {
+  constructor(width, height, { loop = 0, background = [0, 0, 0] } = {}) {
+    if (width > 240 || height > 240) {
+      throw new Error('Animationen dürfen höchstens 240×240 px groß sein.');
+    }
+    this.width = width;
+    this.height = height;
+    this.loop = loop;
+    this.background = background;
+    this.frames = [];
+    this.previous = null;
+    this.rectCount = 0;
+  }
+
+  addFrame({ imageData, delay }) {
+    const pixels = toRgb565(imageData, this.background);
+    // Frame 0 ist immer ein Keyframe über das ganze Bild (Loop-Einstieg)
+    const rects = this.previous
+      ? findDirtyRects(this.previous, pixels, this.width, this.height)
+      : [{ x: 0, y: 0, w: this.width, h: this.height }];
+
+    const out = [];
+    pushLe16(out, Math.max(0, Math.min(0xffff, Math.round(delay))));
+    pushLe16(out, rects.length);
+    for (const rect of rects) encodeRect(out, pixels, this.width, rect);
+
+    this.frames.push(Uint8Array.from(out));
+    this.previous = pixels;
+    this.rectCount += rects.length;
+  }
+
+  finish() {
+    const header = [];
+    MAGIC.forEach((b) => header.push(b));
+    pushLe16(header, this.width);
+    pushLe16(header, this.height);
+    pushLe16(header, this.frames.length);
+    pushLe16(header, this.loop);
+    pushLe32(header, HEADER_SIZE);
+    pushLe32(header, 0);
+    pushLe32(header, 0);
+
+    const index = [];
+    let offset = HEADER_SIZE + this.frames.length * 4;
+    for (const frame of this.frames) {
+      pushLe32(index, offset);
+      offset += frame.length;
+    }
+
+    const result = new Uint8Array(offset);
+    result.set(header, 0);
+    result.set(index, HEADER_SIZE);
+    let pos = HEADER_SIZE + index.length;
+    for (const frame of this.frames) {
+      result.set(frame, pos);
+      pos += frame.length;
+    }
+    return result;
+  }
+}
@@ -1,4 +1,5 @@
 import { GifEncoder } from './gif-encoder.js';
+import { AnimEncoder } from './anim-encoder.js';
 import { quantizeImage } from './quantize.js';
 
 const els = {
@@ -25,6 +26,7 @@ const els = {
   keepAlpha: document.getElementById('keep-alpha'),
   dither: document.getElementById('dither'),
   loop: document.getElementById('loop'),
+  format: document.getElementById('format'),
   baseDelay: document.getElementById('base-delay')
 };
 
@@ -127,6 +129,7 @@ function readSettings() {
     dither: els.dither.checked,
     loop: parseInt(els.loop.value, 10) || 0,
     baseDelay: parseInt(els.baseDelay.value, 10) || 120,
+    format: els.format.value === 'anm' ? 'anm' : 'gif',
     bgRGB: hexToRgb(els.bgColor.value),
     bgCss: els.bgColor.value
   };
@@ -308,6 +311,19 @@ async function buildGif(source, settings, onProgress) {
   let dimsCache = null;
 
   const appendFrame = async (imageData, delayMs) => {
+    if (settings.format === 'anm') {
+      // Delta-Animation: volle RGB565-Farben, keine Quantisierung
+      if (!encoder) {
+        encoder = new AnimEncoder(imageData.width, imageData.height, {
+          loop: settings.loop,
+          background: settings.bgRGB
+        });
+      }
+      encoder.addFrame({ imageData, delay: delayMs });
+      frames += 1;
+      onProgress?.(frames);
+      return;
+    }
     if (!encoder) {
       encoder = new GifEncoder(imageData.width, imageData.height, { loop: settings.loop });
     }
@@ -358,6 +374,8 @@ async function buildGif(source, settings, onProgress) {
   return {
     binary,
     frames,
+    format: settings.format,
+    rects: encoder.rectCount ?? null,
     colors: usedColors,
     dims: { width: encoder.width, height: encoder.height }
   };
@@ -432,9 +450,11 @@ async function processCurrent() {
       setStatus(`Konvertiere … ${frameCount} Frames verarbeitet`);
     });
 
-    const blob = new Blob([result.binary], { type: 'image/gif' });
+    const mime = result.format === 'anm' ? 'application/octet-stream' : 'image/gif';
+    const blob = new Blob([result.binary], { type: mime });
     state.processedBlob = blob;
     state.processedInfo = {
+      format: result.format,
       frames: result.frames,
       colors: result.colors,
       dims: result.dims,
@@ -443,7 +463,9 @@ async function processCurrent() {
 
     const withinLimit = blob.size <= settings.limitBytes;
     els.infoOutput.textContent = `${result.dims.width}×${result.dims.height} · ${formatBytes(blob.size)} (${result.frames} Frames)`;
-    els.infoFrames.textContent = `${result.frames} (Output)`;
+    els.infoFrames.textContent = result.format === 'anm'
+      ? `${result.frames} (Output, ${result.rects} Rechtecke)`
+      : `${result.frames} (Output)`;
     els.infoLimit.classList.remove('ok', 'fail');
     els.infoLimit.classList.add(withinLimit ? 'ok' : 'fail');
 
@@ -451,7 +473,9 @@ async function processCurrent() {
       setStatus(`Achtung: ${formatBytes(blob.size)} überschreiten das Limit von ${formatBytes(settings.limitBytes)}. Parameter reduzieren!`, 'error');
       els.download.disabled = true;
     } else {
-      setStatus('Fertig! GIF kann geladen werden.', 'success');
+      setStatus(result.format === 'anm'
+        ? 'Fertig! Animation (.anm) kann geladen werden.'
+        : 'Fertig! GIF kann geladen werden.', 'success');
       els.download.disabled = false;
     }
   } catch (err) {
@@ -473,7 +497,8 @@ function downloadGif() {
   const a = document.createElement('a');
   const baseName = state.source?.name?.replace(/\.[^.]+$/, '') || 'slideshow';
   a.href = url;
-  a.download = `${baseName}_brosche.gif`;
+  const ext = state.processedInfo?.format === 'anm' ? 'anm' : 'gif';
+  a.download = `${baseName}_brosche.${ext}`;
   a.click();
 }
 
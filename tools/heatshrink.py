@@ -0,0 +1,136 @@
+"""heatshrink-compatible LZSS encoder for compressed USB uploads (BZSTART).
+
+Output matches the heatshrink reference codec (``heatshrink -e -w W -l L``):
+a bit stream, most significant bit first, of
+
+    1 <8-bit literal>
+    0 <W bits: distance - 1> <L bits: length - 1>
+
+padded with zero bits to a whole byte. The device decodes it with a
+2^W byte window (Core/Heatshrink.h); W and L must match its constants.
+"""
+from __future__ import annotations
+
+WINDOW_BITS = 11
+LOOKAHEAD_BITS = 4
+MAX_CANDIDATES = 48   # match candidates checked per position
+
+
+class _BitWriter:
+    def __init__(self) -> None:
+        self.out = bytearray()
+        self.acc = 0
+        self.bits = 0
+
+    def put(self, value: int, count: int) -> None:
+        self.acc = (self.acc << count) | value
+        self.bits += count
+        while self.bits >= 8:
+            self.bits -= 8
+            self.out.append((self.acc >> self.bits) & 0xFF)
+        self.acc &= (1 << self.bits) - 1
+
+    def finish(self) -> bytes:
+        if self.bits:
+            self.out.append((self.acc << (8 - self.bits)) & 0xFF)
+            self.bits = 0
+        return bytes(self.out)
+
+
+def compress(data: bytes, window_bits: int = WINDOW_BITS,
+             lookahead_bits: int = LOOKAHEAD_BITS) -> bytes:
+    window = 1 << window_bits
+    max_len = 1 << lookahead_bits
+    # A back-reference pays off once it replaces more literal bits than it costs
+    min_len = (1 + window_bits + lookahead_bits) // 9 + 1
+    writer = _BitWriter()
+    heads: dict = {}
+    pos = 0
+    size = len(data)
+
+    def remember(p: int) -> None:
+        if p + 3 <= size:
+            heads.setdefault(data[p:p + 3], []).append(p)
+
+    while pos < size:
+        best_len = 0
+        best_dist = 0
+        chain = heads.get(data[pos:pos + 3]) if pos + 3 <= size else None
+        if chain:
+            limit = min(max_len, size - pos)
+            checked = 0
+            for cand in reversed(chain):
+                dist = pos - cand
+                if dist > window or checked >= MAX_CANDIDATES:
+                    break
+                checked += 1
+                length = 0
+                while length < limit and data[cand + length] == data[pos + length]:
+                    length += 1
+                if length > best_len:
+                    best_len, best_dist = length, dist
+                    if length == limit:
+                        break
+        if best_len >= min_len:
+            writer.put(0, 1)
+            writer.put(best_dist - 1, window_bits)
+            writer.put(best_len - 1, lookahead_bits)
+            for p in range(pos, pos + best_len):
+                remember(p)
+            pos += best_len
+        else:
+            writer.put(1, 1)
+            writer.put(data[pos], 8)
+            remember(pos)
+            pos += 1
+    return writer.finish()
+
+
+def decompress(packed: bytes, window_bits: int = WINDOW_BITS,
+               lookahead_bits: int = LOOKAHEAD_BITS, size: int = -1) -> bytes:
+    """Reference decoder, mirrors the firmware (used for self-checks)."""
+    out = bytearray()
+    acc = 0
+    bits = 0
+    it = iter(packed)
+
+    def take(count: int):
+        nonlocal acc, bits
+        while bits < count:
+            byte = next(it, None)
+            if byte is None:
+                return None
+            acc = (acc << 8) | byte
+            bits += 8
+        bits -= count
+        value = (acc >> bits) & ((1 << count) - 1)
+        acc &= (1 << bits) - 1
+        return value
+
+    while size < 0 or len(out) < size:
+        tag = take(1)
+        if tag is None:
+            break
+        if tag:
+            value = take(8)
+            if value is None:
+                break
+            out.append(value)
+        else:
+            dist = take(window_bits)
+            length = take(lookahead_bits)
+            if dist is None or length is None:
+                break
+            for _ in range(length + 1):
+                out.append(out[-(dist + 1)])
+    return bytes(out)
+
+
+if __name__ == "__main__":
+    import sys
+    for name in sys.argv[1:]:
+        with open(name, "rb") as f:
+            raw = f.read()
+        packed = compress(raw)
+        assert decompress(packed, size=len(raw)) == raw
+        print(f"{name}: {len(raw)} -> {len(packed)} ({len(raw) / max(len(packed), 1):.2f}x)")
@@ -1,23 +1,27 @@
 #!/usr/bin/env python3
 """Listen LittleFS contents over the SerialImageTransfer protocol.
 
-Requires the ESP32 to be im USB-Transfer-Modus. Für jedes Verzeichnis wird der
-`LIST`-Befehl gesendet und die `USB OK LIST`/`LISTDONE`-Antworten ausgewertet.
+Requires the ESP32 to be im USB-Transfer-Modus. Der ganze Baum kommt mit
+`BLIST` (binär, rekursiv, seitenweise); ältere Firmware ohne `BLIST` wird wie
+bisher mit einem `LIST` pro Verzeichnis abgefragt (`--text` erzwingt das).
 
 Beispiel:
 
     python3 tools/list_littlefs.py --port /dev/ttyACM0 --root /system
+    python3 tools/list_littlefs.py --root /slides --hash --mtime
 
 """
 
 from __future__ import annotations
 
 import argparse
+import struct
 import sys
 import time
+import zlib
 from dataclasses import dataclass
 from pathlib import PurePosixPath
-from typing import List, Tuple
+from typing import List, Optional, Tuple
 
 import serial  # type: ignore
 
@@ -25,12 +29,20 @@ import serial  # type: ignore
 DEFAULT_PORT = "/dev/ttyACM0"
 DEFAULT_BAUD = 115200
 
+# BLIST request and entry flags, see Core/SerialImageTransfer.cpp
+LIST_RECURSIVE = 0x01
+LIST_MTIME = 0x02
+LIST_HASH = 0x04
+ENTRY_DIR = 0x01
+
 
 @dataclass
 class Entry:
     path: PurePosixPath
     is_dir: bool
     size: int
+    mtime: Optional[int] = None
+    crc: Optional[int] = None
 
 
 def ping(ser: serial.Serial, timeout: float = 2.0) -> None:
@@ -131,6 +143,82 @@ def send_list(ser: serial.Serial, directory: PurePosixPath, timeout: float = 5.0
     raise RuntimeError(f"Timeout while waiting for LIST response for {directory}")
 
 
+def read_exact(ser: serial.Serial, count: int, timeout: float) -> bytes:
+    data = bytearray()
+    end = time.time() + timeout
+    while len(data) < count and time.time() < end:
+        data += ser.read(count - len(data))
+    return bytes(data)
+
+
+def parse_blist(root: PurePosixPath, payload: bytes) -> List[Entry]:
+    entries: List[Entry] = []
+    pos = 0
+    while pos < len(payload):
+        flags = payload[pos]
+        (size,) = struct.unpack_from("<I", payload, pos + 1)
+        pos += 5
+        mtime = crc = None
+        if flags & LIST_MTIME:
+            (mtime,) = struct.unpack_from("<I", payload, pos)
+            pos += 4
+        if flags & LIST_HASH:
+            (crc,) = struct.unpack_from("<I", payload, pos)
+            pos += 4
+        length = payload[pos]
+        name = payload[pos + 1:pos + 1 + length].decode("utf-8", "replace")
+        pos += 1 + length
+        entries.append(Entry(path=root / name, is_dir=bool(flags & ENTRY_DIR), size=size,
+                             mtime=mtime, crc=crc))
+    return entries
+
+
+def send_blist(ser: serial.Serial, root: PurePosixPath, flags: int, timeout: float = 3.0) -> Optional[List[Entry]]:
+    """Whole tree below root via BLIST pages; None if the firmware has no BLIST."""
+
+    entries: List[Entry] = []
+    cursor = 0
+    attempts = 0
+    while True:
+        ser.write(f"BLIST {flags} {cursor} {root.as_posix()}\n".encode("utf-8"))
+        ser.flush()
+        header = None
+        end = time.time() + timeout
+        while time.time() < end:
+            raw = ser.readline()
+            text = raw.decode("utf-8", "replace").strip() if raw else ""
+            if text.startswith("USB ERR"):
+                raise RuntimeError(f"BLIST failed for {root.as_posix()}: {text}")
+            if text.startswith("USB OK BLIST"):
+                header = text.split()
+                break
+        if header is None:
+            if cursor == 0:
+                return None  # unknown command is ignored by older firmware
+            raise RuntimeError("Timeout while waiting for BLIST page")
+
+        count, next_cursor, length = (int(v) for v in header[3:6])
+        frame = read_exact(ser, 10 + length, timeout)
+        ok = len(frame) == 10 + length and frame[:2] == b"\xa5\x5a"
+        if ok:
+            (crc,) = struct.unpack_from("<I", frame, 6 + length)
+            ok = zlib.crc32(frame[6:6 + length], zlib.crc32(frame[2:6])) & 0xFFFFFFFF == crc
+        if not ok:
+            attempts += 1
+            if attempts > 3:
+                raise RuntimeError("BLIST page damaged repeatedly")
+            ser.reset_input_buffer()
+            continue  # same cursor again
+        attempts = 0
+        page = parse_blist(root, frame[6:6 + length])
+        if len(page) != count:
+            raise RuntimeError(f"BLIST page announced {count} entries, got {len(page)}")
+        entries.extend(page)
+        if next_cursor == 0:
+            return entries
+        cursor = next_cursor
+
+
 def list_recursive(ser: serial.Serial, root: PurePosixPath) -> List[Entry]:
     stack = [root]
     discovered: List[Entry] = []
@@ -161,6 +249,9 @@ def main() -> None:
     parser.add_argument("--baud", type=int, default=DEFAULT_BAUD, help="Baud rate (default: %(default)d)")
     parser.add_argument("--root", default="/", help="Start directory (default: %(default)s)")
     parser.add_argument("--no-ping", action="store_true", help="Skip initial PING/PONG handshake")
+    parser.add_argument("--text", action="store_true", help="Use one text LIST per directory (old firmware)")
+    parser.add_argument("--mtime", action="store_true", help="Show modification times (BLIST only)")
+    parser.add_argument("--hash", action="store_true", help="Show upload CRC-32 of slides (BLIST only)")
     args = parser.parse_args()
 
     root = PurePosixPath(args.root)
@@ -176,7 +267,14 @@ def main() -> None:
         if not args.no_ping:
             ping(ser)
         fs_total, fs_used, fs_free = read_fsinfo(ser)
-        entries = list_recursive(ser, root)
+        entries = None
+        if not args.text:
+            flags = LIST_RECURSIVE | (LIST_MTIME if args.mtime else 0) | (LIST_HASH if args.hash else 0)
+            entries = send_blist(ser, root, flags)
+            if entries is not None:
+                entries.sort(key=lambda e: e.path.as_posix())
+        if entries is None:
+            entries = list_recursive(ser, root)
 
     if not entries:
         print("(empty)")
@@ -184,7 +282,13 @@ def main() -> None:
         for entry in entries:
             kind = "<DIR>" if entry.is_dir else "     "
             size = "-" if entry.is_dir else str(entry.size)
-            print(f"{kind}  {size:>10}  {entry.path.as_posix()}")
+            extra = ""
+            if args.mtime:
+                extra += "  " + (time.strftime("%Y-%m-%d %H:%M", time.localtime(entry.mtime))
+                                 if entry.mtime else " " * 16)
+            if args.hash:
+                extra += "  " + (f"{entry.crc:08x}" if entry.crc is not None else " " * 8)
+            print(f"{kind}  {size:>10}{extra}  {entry.path.as_posix()}")
 
     kb = 1024
     print(
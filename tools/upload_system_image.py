@@ -4,10 +4,18 @@ System Image Upload Tool
 Uploads images to ESP32 LittleFS /system/ directory via USB Serial
 
 Usage:
-    python3 upload_system_image.py <port> <image_file>
+    python3 upload_system_image.py [--force] <port> <image_file> [target_dir]
+    python3 upload_system_image.py [--force] <port> <file> <file> ... [target_dir]
+
+Several files go out in one BATCH session (one connection, flash writes
+overlap with the next file). Files whose size and CRC-32 already match on
+the device (HASH) are skipped; --force uploads them anyway. A single file
+the device has in an older version goes out as a delta (SIGS/DELTA): only
+the changed blocks cross the wire. --force sends it whole.
 
 Example:
     python3 upload_system_image.py /dev/ttyACM0 ../assets/boot_logo_200.jpg
+    python3 upload_system_image.py /dev/ttyACM0 ../assets/fonts/*.vlw /system/fonts
 """
 
 import sys
@@ -16,11 +24,14 @@ import serial
 import os
 from pathlib import Path
 
+from usb_protocol import TransferError, is_unchanged, pack, send_batch, send_delta, send_framed
+
 
 BAUD_RATE = 115200
-CHUNK_SIZE = 1024
 TIMEOUT = 2.0
 TARGET_DIR = "/system"
+# Text and font files shrink about 2x and go out heatshrink-compressed (BZSTART)
+COMPRESS_SUFFIXES = {".lua", ".json", ".vlw", ".txt", ".cfg"}
 
 
 def wait_for_response(ser, timeout=2.0):
@@ -49,7 +60,7 @@ def send_ping(ser):
     return response and "PONG" in response
 
 
-def upload_image(port, image_path, target_dir=TARGET_DIR):
+def upload_image(port, image_path, target_dir=TARGET_DIR, force=False):
     """Upload an image file to ESP32 LittleFS."""
 
     if not os.path.exists(image_path):
@@ -82,41 +93,42 @@ def upload_image(port, image_path, target_dir=TARGET_DIR):
         else:
             print("✅ PONG received")
 
-        # Send START command with target directory
-        start_cmd = f"START {file_size} {filename} {target_dir}\n"
-        print(f"📤 Sending: {start_cmd.strip()}")
-        ser.write(start_cmd.encode('utf-8'))
-
-        # Wait for START response
-        response = wait_for_response(ser, timeout=3.0)
-        if response:
-            print(f"📥 Response: {response}")
-            if "ERR" in response:
-                print(f"❌ Error from ESP32: {response}")
-                ser.close()
-                return False
-
-        # Send file data in chunks
-        print(f"📤 Uploading data...")
         with open(image_path, 'rb') as f:
-            sent = 0
-            last_percent = -1
+            data = f.read()
 
-            while sent < file_size:
-                chunk = f.read(CHUNK_SIZE)
-                if not chunk:
-                    break
+        if not force and is_unchanged(ser, filename, data, target_dir):
+            print(f"✅ Unchanged on the device, skipped: {filename}")
+            ser.close()
+            return True
 
-                ser.write(chunk)
-                sent += len(chunk)
+        # Framed upload: numbered 1 KB blocks with CRC-32, resent if lost
+        print(f"📤 Uploading data ({file_size} bytes, {filename} -> {target_dir})...")
 
-                # Progress indicator
-                percent = int((sent / file_size) * 100)
-                if percent != last_percent and percent % 10 == 0:
-                    print(f"   {percent}% ({sent}/{file_size} bytes)")
-                    last_percent = percent
+        last_percent = [-1]
 
-        print(f"✅ Upload complete: {sent} bytes sent")
+        def show_progress(done, total):
+            percent = int((done / total) * 100)
+            if percent != last_percent[0] and percent % 10 == 0:
+                print(f"   {percent}% ({done}/{total} bytes)")
+                last_percent[0] = percent
+
+        try:
+            packed = pack(data) if Path(filename).suffix.lower() in COMPRESS_SUFFIXES else None
+            # DELTA: only what changed against the version on the device
+            sent = not force and send_delta(ser, data, filename, target_dir,
+                                            log=lambda msg: print(f"📥 {msg}"), progress=show_progress,
+                                            baseline=len(packed) if packed else len(data))
+            if not sent:
+                # BRESUME: continues a previous attempt that timed out, else starts fresh
+                send_framed(ser, data, filename, target_dir,
+                            log=lambda msg: print(f"📥 {msg}"), progress=show_progress,
+                            resume=True, packed=packed)
+        except TransferError as e:
+            print(f"❌ Error from ESP32: {e}")
+            ser.close()
+            return False
+
+        print(f"✅ Upload complete: {len(data)} bytes sent")
 
         # Send END command
         print("📤 Sending END command...")
@@ -191,6 +203,73 @@ def upload_image(port, image_path, target_dir=TARGET_DIR):
         return False
 
 
+def upload_batch(port, paths, target_dir=TARGET_DIR, force=False):
+    """Upload several files in one BATCH session."""
+    missing = [p for p in paths if not os.path.exists(p)]
+    if missing:
+        print(f"❌ Error: File not found: {', '.join(missing)}")
+        return False
+
+    files = []
+    for path in paths:
+        with open(path, 'rb') as f:
+            files.append((Path(path).name, f.read()))
+    total = sum(len(data) for _, data in files)
+    print(f"📁 Files: {len(files)} ({total} bytes, {total/1024:.1f} KB)")
+    print(f"📂 Target: {target_dir}")
+    print(f"🔌 Port: {port}")
+    print()
+
+    try:
+        print("🔗 Opening serial connection...")
+        ser = serial.Serial(port, BAUD_RATE, timeout=TIMEOUT)
+        time.sleep(0.5)  # Wait for ESP32 to stabilize
+        ser.reset_input_buffer()
+        ser.reset_output_buffer()
+
+        print("🏓 Sending PING...")
+        if not send_ping(ser):
+            print("⚠️  Warning: No PONG response (continuing anyway)")
+        else:
+            print("✅ PONG received")
+
+        last_percent = [-1]
+
+        def show_progress(done, total_bytes):
+            percent = int((done / total_bytes) * 100)
+            if percent != last_percent[0] and percent % 10 == 0:
+                print(f"   {percent}% ({done}/{total_bytes} bytes)")
+                last_percent[0] = percent
+
+        started = time.time()
+        try:
+            replies = send_batch(ser, files, target_dir,
+                       log=lambda msg: print(f"📥 {msg}"), progress=show_progress,
+                       compress=lambda name: Path(name).suffix.lower() in COMPRESS_SUFFIXES,
+                       skip_unchanged=not force)
+        except TransferError as e:
+            print(f"❌ Error from ESP32: {e}")
+            ser.close()
+            return False
+
+        elapsed = max(time.time() - started, 0.001)
+        print(f"✅ SUCCESS: {len(replies)} of {len(files)} files uploaded in {elapsed:.1f}s")
+        ser.close()
+        return True
+
+    except serial.SerialException as e:
+        print(f"❌ Serial error: {e}")
+        return False
+    except KeyboardInterrupt:
+        print("\n⚠️  Upload cancelled by user")
+        try:
+            ser.write(b"ABORT\n")
+            ser.close()
+        except:
+            pass
+        return False
+
+
 def main():
     if len(sys.argv) < 3:
         print(__doc__)
@@ -203,18 +282,28 @@ def main():
             print("  (install pyserial to list ports: pip install pyserial)")
         sys.exit(1)
 
-    port = sys.argv[1]
-    image_path = sys.argv[2]
+    args = [a for a in sys.argv[1:] if a != "--force"]
+    force = len(args) < len(sys.argv) - 1
+    port = args[0]
+    paths = args[1:]
+    if not paths:
+        print(__doc__)
+        sys.exit(1)
 
-    # Optional: custom target directory
-    target_dir = sys.argv[3] if len(sys.argv) > 3 else TARGET_DIR
+    # Optional: custom target directory (last argument, device path)
+    target_dir = TARGET_DIR
+    if len(paths) > 1 and paths[-1].startswith("/") and not os.path.isfile(paths[-1]):
+        target_dir = paths.pop()
 
     print("=" * 60)
     print("ESP32 System Image Upload Tool")
     print("=" * 60)
     print()
 
-    success = upload_image(port, image_path, target_dir)
+    if len(paths) == 1:
+        success = upload_image(port, paths[0], target_dir, force)
+    else:
+        success = upload_batch(port, paths, target_dir, force)
 
     print()
     print("=" * 60)
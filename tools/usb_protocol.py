@@ -0,0 +1,577 @@
+"""Binary framed USB upload (BSTART) shared by the host tools.
+
+Frame layout (little-endian), see Core/SerialImageTransfer.cpp:
+
+    A5 5A | u16 seq | u16 len | payload | u32 crc32(seq, len, payload)
+
+The device answers BSTART with ``USB OK BSTART <name> <size> <chunk> <window>``
+and every frame with ``USB OK ACK <next> <mask-hex> <limit>``: ``next`` is the
+first missing block, bit i of ``mask`` says block ``next + i`` already
+arrived, and blocks below ``limit`` may be in flight. Only blocks the device
+is missing are sent again.
+
+With ``resume=True`` the upload starts with BRESUME instead. The device
+answers ``USB OK BRESUME <name> <size> <offset> <crc-hex> <chunk> <window>``
+when it kept the first ``offset`` bytes of an upload that timed out; if
+their CRC-32 matches the local file only the rest is sent, block numbers
+counting from ``offset``. Otherwise the upload starts over.
+
+With ``compress=True`` the data is packed with heatshrink (tools/heatshrink.py)
+and sent as ``BZSTART <packed> <size> <name> [directory]``; the device
+unpacks it while writing. Block numbers and ACKs count packed bytes. Data
+that does not shrink goes out with BSTART as usual.
+
+send_batch() sends many files in one session: ``BATCH <files> <bytes>``,
+then every file as above followed by END, then ``BATCHEND``. The device
+renames each file in the background while the next one arrives and answers
+``USB OK BATCHEND <files> <bytes>``, or ``USB ERR BATCHEND <done> <failed>
+<missing>`` if any file did not make it.
+
+download() reads files back with ``BREAD <offset> <length> <path>``: the
+device answers ``USB OK BREAD <name> <filesize> <offset> <length> <chunk>``,
+sends the range as frames in the layout above (block 0 at ``offset``) and
+ends with ``USB OK BREADEND <bytes> <crc-hex>``, the CRC-32 of the whole
+range. Blocks with a bad CRC are fetched again on their own. Paths under
+``/sd/`` are read from the SD card.
+
+remote_hash() asks ``HASH <path>`` (``USB OK HASH CRC32 <size> <crc> <path>``);
+the device caches the result until the file changes, so upload tools can
+skip files that are already there (``skip_unchanged``).
+
+send_delta() updates a file the device already has with only the changes,
+rsync-style. ``SIGS <blocksize> <path>`` returns ``USB OK SIGS <name> <size>
+<blocksize> <count> <chunk>``, frames of ``u32 weak | u32 crc32`` per block
+of the old file and ``USB OK SIGSEND <count> <crc-hex>``. make_delta() finds
+those blocks in the new data with the rolling sum and emits ``'L' <u16 len>
+<bytes>`` and ``'C' <u32 block> <u16 count>`` operations (Core/DeltaSync.h).
+``DELTA <delta> <size> <crc-hex> <blocksize> <name> [directory]`` sends them
+framed like BSTART (``USB OK DELTA <name> <size> <delta> <chunk>
+<window>``); the device rebuilds the file into the .part file, checks the
+CRC-32 of the result and only then replaces the old version.
+"""
+from __future__ import annotations
+
+import math
+import struct
+import time
+import zlib
+from typing import Callable, Dict, List, Optional, Sequence, Tuple
+
+import heatshrink
+
+SYNC = b"\xa5\x5a"
+RESEND_AFTER_S = 0.5      # no ACK for a block in this time -> send it again
+MIN_PACK_GAIN = 0.9       # compress only if it saves at least 10 %
+STALL_TIMEOUT_S = 10.0    # no progress at all -> give up
+END_TIMEOUT_S = 30.0      # END of a single upload waits for the flash
+DELTA_MIN_BLOCK = 64      # block sizes the device accepts for SIGS/DELTA
+DELTA_MAX_BLOCK = 2048
+
+
+class TransferError(RuntimeError):
+    pass
+
+
+def build_frame(seq: int, payload: bytes) -> bytes:
+    header = struct.pack("<HH", seq, len(payload))
+    crc = zlib.crc32(payload, zlib.crc32(header)) & 0xFFFFFFFF
+    return SYNC + header + payload + struct.pack("<I", crc)
+
+
+def abort_frame() -> bytes:
+    return build_frame(0, b"")
+
+
+def read_line(ser, timeout: float) -> Optional[str]:
+    """Next non-empty line from the device, or None after timeout."""
+    end = time.time() + timeout
+    old_timeout = ser.timeout
+    ser.timeout = min(0.05, timeout) if timeout > 0 else 0
+    try:
+        while True:
+            raw = ser.readline()
+            if raw:
+                line = raw.decode("utf-8", "replace").strip()
+                if line:
+                    return line
+            if time.time() >= end:
+                return None
+    finally:
+        ser.timeout = old_timeout
+
+
+def _start(ser, verb: str, sizes: str, name: str, target_dir: Optional[str]):
+    """Send BSTART/BRESUME/BZSTART, return the reply line."""
+    command = f"{verb} {sizes} {name}"
+    if target_dir:
+        command += f" {target_dir}"
+    ser.write((command + "\n").encode("utf-8"))
+    ser.flush()
+
+    deadline = time.time() + 4.0
+    while time.time() < deadline:
+        line = read_line(ser, deadline - time.time())
+        if line is None:
+            break
+        if line.startswith("USB ERR"):
+            raise TransferError(f"Device returned error: {line}")
+        if line.startswith(f"USB OK {verb}"):
+            return line
+    raise TransferError(f"No {verb} confirmation (firmware without framed mode?)")
+
+
+def pack(data: bytes) -> Optional[bytes]:
+    """heatshrink-compressed data, or None if it does not shrink enough."""
+    packed = heatshrink.compress(data)
+    return packed if len(packed) <= len(data) * MIN_PACK_GAIN else None
+
+
+def send_framed(ser, data: bytes, name: str, target_dir: Optional[str] = None,
+                log: Callable[[str], None] = print,
+                progress: Optional[Callable[[int, int], None]] = None,
+                resume: bool = False, compress: bool = False,
+                packed: Optional[bytes] = None) -> None:
+    """Upload data with BSTART framing. Raises TransferError on failure.
+
+    packed: result of pack(data) if the caller compressed already.
+    """
+    if compress or packed is not None:
+        if packed is None:
+            packed = pack(data)
+        if packed is not None:
+            line = _start(ser, "BZSTART", f"{len(packed)} {len(data)}", name, target_dir)
+            log(line)
+            parts = line.split()
+            if (int(parts[-2]), int(parts[-1])) != (heatshrink.WINDOW_BITS, heatshrink.LOOKAHEAD_BITS):
+                ser.write(abort_frame())
+                raise TransferError(f"Device uses other heatshrink parameters: {line}")
+            log(f"Compressed {len(data)} -> {len(packed)} bytes")
+            _send_blocks(ser, packed, int(parts[-4]), int(parts[-3]), 0, log, progress)
+            return
+
+    offset = 0
+    if resume:
+        line = _start(ser, "BRESUME", str(len(data)), name, target_dir)
+        log(line)
+        parts = line.split()
+        offset, crc = int(parts[-4]), int(parts[-3], 16)
+        if offset and zlib.crc32(data[:offset]) & 0xFFFFFFFF != crc:
+            log(f"Device has {offset} bytes of a different file, starting over")
+            ser.write(abort_frame())
+            read_line(ser, 1.0)  # USB ERR REMOTE
+            resume = False
+        elif offset:
+            log(f"Resuming at {offset}/{len(data)} bytes")
+    if not resume:
+        offset = 0
+        line = _start(ser, "BSTART", str(len(data)), name, target_dir)
+        log(line)
+        parts = line.split()
+    _send_blocks(ser, data[offset:], int(parts[-2]), int(parts[-1]), offset, log, progress)
+
+
+def wait_reply(ser, code: str, timeout: float) -> str:
+    """Wait for ``USB OK <code>``; raises TransferError on USB ERR or timeout."""
+    deadline = time.time() + timeout
+    while time.time() < deadline:
+        line = read_line(ser, deadline - time.time())
+        if line is None:
+            break
+        if line.startswith("USB ERR"):
+            raise TransferError(f"Device returned error: {line}")
+        if line.startswith(f"USB OK {code}"):
+            return line
+    raise TransferError(f"No {code} confirmation")
+
+
+def device_path(name: str, target_dir: Optional[str] = None) -> str:
+    """Where the firmware stores an upload (sanitizeFilename and the routing in beginTransfer)."""
+    clean = "".join("_" if ch == " " else ch for ch in name.lower()
+                    if ch in " -_." or ch.isascii() and ch.isalnum())
+    clean = (clean[:63] or "usb_image.jpg").lstrip(".")
+    if "." not in clean:
+        clean += ".jpg"
+    directory = (target_dir or "/slides").rstrip("/") or "/"
+    if clean.endswith((".cfg", ".txt", ".json")):
+        directory = "/"
+    elif clean.endswith(".lua"):
+        directory = "/scripts"
+    if clean == "i18n.json" or clean.startswith("i18n_"):
+        directory = "/system"
+    return directory.rstrip("/") + "/" + clean
+
+
+def remote_hash(ser, path: str) -> Optional[Tuple[int, int]]:
+    """(size, CRC-32) of a device file, None if it does not exist."""
+    ser.write(f"HASH {path}\n".encode("utf-8"))
+    ser.flush()
+    deadline = time.time() + END_TIMEOUT_S
+    while time.time() < deadline:
+        line = read_line(ser, deadline - time.time())
+        if line is None:
+            break
+        if line.startswith("USB ERR"):
+            return None
+        if line.startswith("USB OK HASH "):
+            _, _, _, _, size, crc, _ = line.split(" ", 6)
+            return int(size), int(crc, 16)
+    raise TransferError(f"No HASH reply for {path} (firmware without HASH?)")
+
+
+def is_unchanged(ser, name: str, data: bytes, target_dir: Optional[str] = None) -> bool:
+    remote = remote_hash(ser, device_path(name, target_dir))
+    return remote == (len(data), zlib.crc32(data) & 0xFFFFFFFF)
+
+
+def send_batch(ser, files: Sequence[Tuple[str, bytes]], target_dir: Optional[str] = None,
+               log: Callable[[str], None] = print,
+               progress: Optional[Callable[[int, int], None]] = None,
+               compress: Callable[[str], bool] = lambda name: False,
+               skip_unchanged: bool = False) -> List[str]:
+    """Upload (name, data) pairs in one BATCH session; returns the END replies.
+
+    Files are packed up front so the manifest can announce the bytes that
+    actually go over the wire. With skip_unchanged, files whose size and
+    CRC-32 already match on the device are left out. Raises TransferError
+    if any file fails.
+    """
+    if skip_unchanged:
+        changed = [(name, data) for name, data in files if not is_unchanged(ser, name, data, target_dir)]
+        if len(changed) < len(files):
+            log(f"{len(files) - len(changed)} of {len(files)} file(s) unchanged, skipped")
+        files = changed
+        if not files:
+            return []
+    plans = [(name, data, pack(data) if compress(name) else None) for name, data in files]
+    wire = [len(packed) if packed is not None else len(data) for _, data, packed in plans]
+    total = sum(wire)
+    ser.write(f"BATCH {len(plans)} {total}\n".encode("utf-8"))
+    ser.flush()
+    log(wait_reply(ser, "BATCH", 4.0))
+
+    done = 0
+    replies = []
+    for (name, data, packed), size in zip(plans, wire):
+        def file_progress(sent, _size, base=done):
+            if progress:
+                progress(base + sent, total)
+
+        send_framed(ser, data, name, target_dir, log=log, progress=file_progress, packed=packed)
+        # The device renames in the background, END comes back at once
+        ser.write(b"END\n")
+        ser.flush()
+        replies.append(wait_reply(ser, "END", END_TIMEOUT_S))
+        log(replies[-1])
+        done += size
+
+    ser.write(b"BATCHEND\n")
+    ser.flush()
+    log(wait_reply(ser, "BATCHEND", END_TIMEOUT_S))
+    return replies
+
+
+def _send_blocks(ser, data: bytes, chunk: int, window: int, base: int,
+                 log: Callable[[str], None],
+                 progress: Optional[Callable[[int, int], None]]) -> None:
+    """Selective-repeat loop; data[0] is block 0, base only shifts progress."""
+    total = (len(data) + chunk - 1) // chunk
+    next_seq = 0
+    mask = 0
+    limit = window
+    sent_at: Dict[int, float] = {}
+    fast_resent = set()
+    resends = 0
+    last_progress = time.time()
+
+    while next_seq < total:
+        now = time.time()
+        for seq in range(next_seq, min(limit, total)):
+            if (mask >> (seq - next_seq)) & 1:
+                continue
+            stamp = sent_at.get(seq)
+            if stamp is not None and now - stamp < RESEND_AFTER_S:
+                continue
+            if stamp is not None:
+                resends += 1
+            ser.write(build_frame(seq, data[seq * chunk:(seq + 1) * chunk]))
+            sent_at[seq] = now
+
+        line = read_line(ser, 0.05)
+        if line is None:
+            if time.time() - last_progress > STALL_TIMEOUT_S:
+                ser.write(abort_frame())
+                raise TransferError(f"Transfer stalled at block {next_seq}/{total}")
+            continue
+        if line.startswith("USB ERR"):
+            raise TransferError(f"Device returned error: {line}")
+        if not line.startswith("USB OK ACK"):
+            continue  # debug output of the firmware
+
+        _, _, _, ack_next, ack_mask, ack_limit = line.split()
+        ack_next = int(ack_next)
+        if ack_next > next_seq:
+            last_progress = time.time()
+            if progress:
+                progress(base + min(ack_next * chunk, len(data)), base + len(data))
+        next_seq = max(next_seq, ack_next)
+        mask = int(ack_mask, 16) if ack_next == next_seq else 0
+        limit = max(limit, int(ack_limit))
+        for seq in [s for s in sent_at if s < next_seq]:
+            del sent_at[seq]
+        # A later block overtook the first missing one: that one was lost
+        if mask and next_seq in sent_at and next_seq not in fast_resent:
+            fast_resent.add(next_seq)
+            del sent_at[next_seq]
+
+    if resends:
+        log(f"{resends} block(s) sent again")
+
+
+def _receive_frames(ser, chunk: int, end_code: str,
+                    progress: Optional[Callable[[int], None]] = None):
+    """Frames sent by BREAD/SIGS up to ``USB OK <end_code>``.
+
+    Returns ({block number: payload} of blocks with a good CRC, fields of
+    the end line).
+    """
+    blocks: Dict[int, bytes] = {}
+    buf = bytearray()
+    got = 0
+    deadline = time.time() + STALL_TIMEOUT_S
+    while True:
+        if time.time() > deadline:
+            raise TransferError(f"{end_code} missing, stalled after {got} bytes")
+        data = ser.read(max(1, min(ser.in_waiting, 65536)))
+        if data:
+            buf += data
+            deadline = time.time() + STALL_TIMEOUT_S
+        while buf:
+            if buf.startswith(SYNC):
+                if len(buf) < 6:
+                    break
+                seq, n = struct.unpack_from("<HH", buf, 2)
+                if n > chunk:
+                    del buf[:2]   # not a frame header after all
+                    continue
+                if len(buf) < 10 + n:
+                    break
+                payload = bytes(buf[6:6 + n])
+                (crc,) = struct.unpack_from("<I", buf, 6 + n)
+                if zlib.crc32(payload, zlib.crc32(bytes(buf[2:6]))) & 0xFFFFFFFF == crc:
+                    blocks[seq] = payload
+                    got += n
+                    if progress:
+                        progress(got)
+                del buf[:10 + n]
+            elif buf.startswith(b"USB "):
+                end = buf.find(b"\n")
+                if end < 0:
+                    break
+                text = buf[:end].decode("utf-8", "replace").strip()
+                del buf[:end + 1]
+                if text.startswith("USB ERR"):
+                    raise TransferError(f"Device returned error: {text}")
+                if text.startswith(f"USB OK {end_code}"):
+                    return blocks, text.split()[3:]
+            else:
+                del buf[:1]   # damaged bytes between frames
+
+
+def read_range(ser, path: str, offset: int = 0, length: int = 0,
+               progress: Optional[Callable[[int, int], None]] = None):
+    """One BREAD request.
+
+    Returns (filesize, block size, {block offset: data} of blocks with a
+    good CRC, number of bytes the device sent, CRC-32 the device computed
+    over them).
+    """
+    ser.write(f"BREAD {offset} {length} {path}\n".encode("utf-8"))
+    ser.flush()
+    line = wait_reply(ser, "BREAD", 4.0)
+    parts = line.split()
+    size, start, count, chunk = (int(p) for p in parts[-4:])
+
+    frames, (sent, crc_hex) = _receive_frames(
+        ser, chunk, "BREADEND", (lambda got: progress(got, count)) if progress else None)
+    blocks = {start + seq * chunk: payload for seq, payload in frames.items()}
+    return size, chunk, blocks, int(sent), int(crc_hex, 16)
+
+
+def download(ser, path: str, log: Callable[[str], None] = print,
+             progress: Optional[Callable[[int, int], None]] = None,
+             retries: int = 3) -> bytes:
+    """Read a whole device file; only blocks that arrived damaged are fetched again."""
+    size, chunk, blocks, sent, crc = read_range(ser, path, 0, 0, progress)
+    # One BREAD covers at most 64 MB; longer files continue in further ranges
+    while sent < size:
+        _, _, more, more_sent, _ = read_range(ser, path, sent, 0)
+        blocks.update(more)
+        sent += more_sent
+        crc = None
+
+    for _ in range(retries):
+        missing = [off for off in range(0, size, chunk) if off not in blocks]
+        if not missing:
+            break
+        log(f"{len(missing)} block(s) damaged, fetching again")
+        for off in missing:
+            _, _, more, _, _ = read_range(ser, path, off, min(chunk, size - off))
+            blocks.update(more)
+
+    data = b"".join(blocks.get(off, b"") for off in range(0, size, chunk))
+    if len(data) != size:
+        raise TransferError(f"{path}: {size - len(data)} bytes missing after {retries} retries")
+    if crc is not None and zlib.crc32(data) & 0xFFFFFFFF != crc:
+        raise TransferError(f"{path}: file CRC mismatch")
+    return data
+
+
+def weak_sum(data: bytes) -> int:
+    """rsync weak sum of one block, as deltaWeakSum() in Core/DeltaSync.cpp."""
+    n = len(data)
+    a = sum(data) & 0xFFFF
+    b = sum((n - i) * x for i, x in enumerate(data)) & 0xFFFF
+    return a | (b << 16)
+
+
+def delta_block_size(size: int) -> int:
+    """Signature overhead grows with size / block, waste per edit with the block."""
+    return max(DELTA_MIN_BLOCK, min(DELTA_MAX_BLOCK, int(math.sqrt(size * 8)) // 16 * 16))
+
+
+def remote_signatures(ser, path: str, block_size: int):
+    """SIGS of a device file: (size, CRC-32, {block: (weak, crc)}), None if missing.
+
+    Blocks whose frame arrived damaged are left out; the delta then sends
+    their bytes literally.
+    """
+    ser.write(f"SIGS {block_size} {path}\n".encode("utf-8"))
+    ser.flush()
+    deadline = time.time() + 4.0
+    while True:
+        line = read_line(ser, deadline - time.time())
+        if line is None or line.startswith("USB ERR"):
+            return None   # no such file, or firmware without SIGS
+        if line.startswith("USB OK SIGS "):
+            break
+    parts = line.split()
+    size, chunk = int(parts[-4]), int(parts[-1])
+    frames, (_, crc_hex) = _receive_frames(ser, chunk, "SIGSEND")
+    per_frame = chunk // 8
+    sigs = {}
+    for seq, payload in frames.items():
+        for i in range(len(payload) // 8):
+            sigs[seq * per_frame + i] = struct.unpack_from("<II", payload, i * 8)
+    return size, int(crc_hex, 16), sigs
+
+
+def make_delta(data: bytes, block_size: int, base_size: int, sigs: Dict[int, Tuple[int, int]]) -> bytes:
+    """Operations that rebuild data from the old file described by sigs."""
+    full = base_size // block_size
+    table: Dict[int, List[Tuple[int, int]]] = {}
+    for index, (weak, strong) in sigs.items():
+        if index < full:
+            table.setdefault(weak, []).append((index, strong))
+    tail = base_size % block_size
+    tail_sig = sigs.get(full) if tail else None
+
+    out = bytearray()
+    literal = bytearray()
+    copy = [0, 0]   # pending run: first block, count
+
+    def flush_copy():
+        if copy[1]:
+            out.extend(b"C" + struct.pack("<IH", copy[0], copy[1]))
+            copy[1] = 0
+
+    def flush_literal():
+        for i in range(0, len(literal), 0xFFFF):
+            piece = literal[i:i + 0xFFFF]
+            out.extend(b"L" + struct.pack("<H", len(piece)) + piece)
+        literal.clear()
+
+    def add_copy(block: int):
+        flush_literal()
+        if copy[1] and copy[0] + copy[1] == block and copy[1] < 0xFFFF:
+            copy[1] += 1
+            return
+        flush_copy()
+        copy[0], copy[1] = block, 1
+
+    def add_literal(byte: int):
+        flush_copy()
+        literal.append(byte)
+
+    n = len(data)
+    pos = 0
+    a = b = 0
+    fresh = True
+    while pos + block_size <= n:
+        if fresh:
+            w = weak_sum(data[pos:pos + block_size])
+            a, b = w & 0xFFFF, w >> 16
+            fresh = False
+        hit = None
+        for index, strong in table.get(a | (b << 16), ()):
+            if zlib.crc32(data[pos:pos + block_size]) & 0xFFFFFFFF == strong:
+                hit = index
+                break
+        if hit is not None:
+            add_copy(hit)
+            pos += block_size
+            fresh = True
+            continue
+        # Roll the window one byte on
+        old = data[pos]
+        add_literal(old)
+        if pos + block_size < n:
+            a = (a - old + data[pos + block_size]) & 0xFFFF
+            b = (b - block_size * old + a) & 0xFFFF
+        pos += 1
+
+    rest = data[pos:]
+    if tail_sig and len(rest) == tail and tail_sig == (weak_sum(rest), zlib.crc32(rest) & 0xFFFFFFFF):
+        add_copy(full)
+    else:
+        for byte in rest:
+            add_literal(byte)
+    flush_literal()
+    flush_copy()
+    return bytes(out)
+
+
+def send_delta(ser, data: bytes, name: str, target_dir: Optional[str] = None,
+               log: Callable[[str], None] = print,
+               progress: Optional[Callable[[int, int], None]] = None,
+               baseline: Optional[int] = None) -> bool:
+    """Update a device file with DELTA; the caller sends END afterwards.
+
+    Returns False without touching the device file if there is no old
+    version (or no SIGS in the firmware) or the delta would not save at
+    least 10 % of baseline, the bytes a normal upload costs (len(data) by
+    default). Raises TransferError if the delta upload itself fails.
+    """
+    block_size = delta_block_size(len(data))
+    remote = remote_signatures(ser, device_path(name, target_dir), block_size)
+    if remote is None:
+        return False
+    base_size, _, sigs = remote
+    delta = make_delta(data, block_size, base_size, sigs)
+    if baseline is None:
+        baseline = len(data)
+    if len(delta) > baseline * MIN_PACK_GAIN:
+        log(f"Delta {len(delta)} bytes does not pay off against {baseline}")
+        return False
+
+    crc = zlib.crc32(data) & 0xFFFFFFFF
+    try:
+        line = _start(ser, "DELTA", f"{len(delta)} {len(data)} {crc:08x} {block_size}", name, target_dir)
+    except TransferError as e:
+        if "DELTABASE" in str(e):
+            return False   # old version went away since SIGS
+        raise
+    log(line)
+    parts = line.split()
+    log(f"Delta {len(data)} -> {len(delta)} bytes ({block_size} byte blocks)")
+    _send_blocks(ser, delta, int(parts[-2]), int(parts[-1]), 0, log, progress)
+    return True
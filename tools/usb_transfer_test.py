@@ -5,6 +5,11 @@ Usage:
   python3 tools/usb_transfer_test.py [--port /dev/ttyACM0] [--size 4096] [--name test.bin]
 
 If --file PATH is provided, the bytes from PATH are sent instead of random data.
+By default the data goes through the framed protocol (BSTART, CRC-32 blocks,
+see usb_protocol.py); --raw uses the old START/raw stream/END sequence.
+
+--read PATH uploads nothing: it downloads PATH from the device with the old
+READ and with BREAD (CRC-32 per block) and compares throughput and content.
 """
 from __future__ import annotations
 
@@ -12,11 +17,14 @@ import argparse
 import os
 import sys
 import time
+import zlib
 from pathlib import Path
 from typing import Iterable
 
 import serial  # type: ignore
 
+from usb_protocol import TransferError, download, send_framed
+
 DEFAULT_PORT = "/dev/ttyACM0"
 DEFAULT_BAUD = 115200
 DEFAULT_SIZE = 4096
@@ -43,6 +51,37 @@ def expect_ok(prefix: str, lines: Iterable[str]) -> None:
     raise RuntimeError(f"Did not observe expected response prefix: {prefix}")
 
 
+def read_plain(ser: serial.Serial, path: str) -> bytes:
+    """Old READ: header line, raw bytes, READEND."""
+    ser.write(f"READ {path}\n".encode("utf-8"))
+    ser.flush()
+    for line in iter_lines(ser, timeout=4):
+        if line.startswith("USB ERR"):
+            raise RuntimeError(f"Device returned error: {line}")
+        if line.startswith("USB OK READ"):
+            size = int(line.split()[3])
+            break
+    else:
+        raise RuntimeError("No READ response")
+    data = ser.read(size)
+    expect_ok(" READEND", iter_lines(ser, timeout=4))
+    return data
+
+
+def benchmark_read(ser: serial.Serial, path: str) -> None:
+    results = []
+    for label, fetch in (("READ", lambda: read_plain(ser, path)),
+                         ("BREAD", lambda: download(ser, path))):
+        started = time.time()
+        data = fetch()
+        elapsed = max(time.time() - started, 1e-3)
+        print(f"{label:5} {len(data)} bytes in {elapsed:.2f}s ({len(data) / elapsed / 1024:.1f} KB/s)")
+        results.append(data)
+    if results[0] != results[1]:
+        raise RuntimeError("READ and BREAD returned different data")
+    print(f"Content identical, CRC-32 {zlib.crc32(results[1]) & 0xFFFFFFFF:08x}")
+
+
 def main() -> None:
     parser = argparse.ArgumentParser(description="Send a test payload over the USB transfer protocol.")
     parser.add_argument("--port", default=DEFAULT_PORT)
@@ -52,6 +91,10 @@ def main() -> None:
     parser.add_argument("--file", type=Path)
     parser.add_argument("--chunk", type=int, default=None, help="chunk size for paced writes (default: single write)")
     parser.add_argument("--delay", type=float, default=0.0, help="delay in seconds between chunk writes")
+    parser.add_argument("--raw", action="store_true", help="unframed START/raw/END upload (old firmware)")
+    parser.add_argument("--resume", action="store_true", help="continue a timed-out upload of the same name and size")
+    parser.add_argument("--compress", action="store_true", help="heatshrink-compressed upload (BZSTART)")
+    parser.add_argument("--read", metavar="PATH", help="benchmark READ against BREAD on a device file instead")
     args = parser.parse_args()
 
     if args.file:
@@ -73,32 +116,46 @@ def main() -> None:
         else:
             raise RuntimeError("No PONG response; ensure USB transfer mode is active")
 
-        ser.write(f"START {len(data)} {filename}\n".encode("ascii"))
-        ser.flush()
-        expect_ok(" START", iter_lines(ser, timeout=4))
+        if args.read:
+            benchmark_read(ser, args.read)
+            return
 
-        if args.chunk and args.chunk > 0:
-            offset = 0
-            while offset < len(data):
-                end = min(offset + args.chunk, len(data))
-                written = ser.write(data[offset:end])
-                ser.flush()
-                await_empty_start = time.time()
-                while ser.out_waiting:
-                    if time.time() - await_empty_start > 2:
-                        raise RuntimeError("Serial out_waiting did not drain")
-                    time.sleep(0.01)
-                offset += written
-                if args.delay:
-                    time.sleep(args.delay)
-        else:
-            ser.write(data)
+        started = time.time()
+        if args.raw:
+            ser.write(f"START {len(data)} {filename}\n".encode("ascii"))
             ser.flush()
+            expect_ok(" START", iter_lines(ser, timeout=4))
+
+            if args.chunk and args.chunk > 0:
+                offset = 0
+                while offset < len(data):
+                    end = min(offset + args.chunk, len(data))
+                    written = ser.write(data[offset:end])
+                    ser.flush()
+                    await_empty_start = time.time()
+                    while ser.out_waiting:
+                        if time.time() - await_empty_start > 2:
+                            raise RuntimeError("Serial out_waiting did not drain")
+                        time.sleep(0.01)
+                    offset += written
+                    if args.delay:
+                        time.sleep(args.delay)
+            else:
+                ser.write(data)
+                ser.flush()
 
-        # Wait for ESP32 to finish receiving (no PROG messages during transfer anymore)
-        # Calculate expected transfer time and add margin
-        expected_time = (len(data) * 10) / args.baud  # 10 bits per byte
-        time.sleep(expected_time + 1.0)  # Add 1 second margin
+            # Wait for ESP32 to finish receiving (no PROG messages during transfer anymore)
+            # Calculate expected transfer time and add margin
+            expected_time = (len(data) * 10) / args.baud  # 10 bits per byte
+            time.sleep(expected_time + 1.0)  # Add 1 second margin
+        else:
+            try:
+                send_framed(ser, data, filename, resume=args.resume, compress=args.compress)
+            except TransferError as exc:
+                raise RuntimeError(str(exc)) from exc
+            elapsed = max(time.time() - started, 1e-3)
+            print(f"{len(data)} bytes in {elapsed:.2f}s ({len(data) / elapsed / 1024:.1f} KB/s, "
+                  f"line rate {args.baud / 10 / 1024:.1f} KB/s)")
 
         ser.write(b"END\n")
         ser.flush()